@@ -0,0 +1,415 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+/// \file   dualmc_benchmark.cpp
+/// Benchmark suite for the dual marching cubes extractor on synthetic volumes.
+
+// c includes
+#include <cmath>
+#include <cstdint>
+
+// stl includes
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// google benchmark
+#include <benchmark/benchmark.h>
+
+// dual mc includes
+#include <dmc/dualmc.hpp>
+
+#if defined(_WIN32)
+    #define NOMINMAX
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace {
+
+//------------------------------------------------------------------------------
+
+/// Synthetic volumes of the benchmarks.
+enum Workload : int64_t {
+    /// caffeine molecule approximated by radial Gaussians, as in the example
+    CAFFEINE = 0,
+    /// white noise, almost every cell holds surface
+    NOISE = 1,
+    /// a few small spheres in an otherwise empty volume
+    SPARSE_SDF = 2
+};
+
+/// Value of the normalized density 1 for a voxel type.
+template<class T>
+constexpr float maxValue() {
+    return dualmc::IsFloatingVoxel<T> ? 1.0f : float(dualmc::VoxelLimits<T>::max());
+}
+
+/// Signed 16-bit and half volumes store the densities shifted by -0.5 like
+/// signed distances, which are extracted at iso value 0.
+template<class T>
+constexpr bool signedDistance() {
+    return std::is_same_v<T, int16_t> || dualmc::IsHalf<T>;
+}
+
+/// Radial Gaussian with the parameterization of the example.
+struct RadialGaussian {
+    RadialGaussian(float cX, float cY, float cZ, float variance) : cX(cX), cY(cY), cZ(cZ) {
+        float constexpr TWO_PI = 6.283185307179586f;
+        normalization = 1.0f / std::sqrt(TWO_PI * variance);
+        falloff = -0.5f / variance;
+    }
+
+    float eval(float x, float y, float z) const {
+        float const dx = x - cX;
+        float const dy = y - cY;
+        float const dz = z - cZ;
+        return normalization * std::exp(falloff * (dx * dx + dy * dy + dz * dz));
+    }
+
+    float cX, cY, cZ;
+    float normalization, falloff;
+};
+
+/// Atoms of the caffeine molecule of the example.
+std::vector<RadialGaussian> caffeineAtoms() {
+    float constexpr s = 1.0f / 10.0f;
+    float constexpr o = 0.5f;
+    float constexpr as = 0.025f * 0.025f / 70.0f / 70.0f;
+    float const h = 25 * 25 * as, c = 70 * 70 * as, n = 65 * 65 * as, ox = 60 * 60 * as;
+    float const atoms[24][4] = {
+        {  0.47f,   2.5688f,  0.0006f, ox}, {-3.1271f, -0.4436f, -0.0003f, ox},
+        {-0.9686f, -1.3125f,  0.0f,    n},  { 2.2182f,  0.1412f, -0.0003f, n},
+        {-1.3477f,  1.0797f, -0.0001f, n},  { 1.4119f, -1.9372f,  0.0002f, n},
+        { 0.8579f,  0.2592f, -0.0008f, c},  { 0.3897f, -1.0264f, -0.0004f, c},
+        {-1.9061f, -0.2495f, -0.0004f, c},  { 0.0307f,  1.422f,  -0.0006f, c},
+        { 2.5032f, -1.1998f,  0.0003f, c},  {-1.4276f, -2.6960f,  0.0008f, c},
+        { 3.1926f,  1.2061f,  0.0003f, c},  {-2.2969f,  2.1881f,  0.0007f, c},
+        { 3.5163f, -1.5787f,  0.0008f, h},  {-1.0451f, -3.1973f, -0.8937f, h},
+        {-2.5186f, -2.7596f,  0.0011f, h},  {-1.0447f, -3.1963f,  0.8957f, h},
+        { 4.1992f,  0.7801f,  0.0002f, h},  { 3.0468f,  1.8092f, -0.8992f, h},
+        { 3.0466f,  1.8083f,  0.9004f, h},  {-1.8087f,  3.1651f, -0.0003f, h},
+        {-2.9322f,  2.1027f,  0.8881f, h},  {-2.9346f,  2.1021f, -0.8849f, h}
+    };
+    std::vector<RadialGaussian> result;
+    for(auto const & a : atoms) {
+        result.emplace_back(a[0] * s + o, a[1] * s + o, a[2] * s + o, a[3]);
+    }
+    return result;
+}
+
+/// Hash a voxel position to a uniform value in [0,1).
+float hashNoise(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u ^ z * 0xcb1ab31fu;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return float(h >> 8) * (1.0f / 16777216.0f);
+}
+
+/// Normalized density of a workload at a voxel of a size^3 volume.
+template<Workload W>
+struct Field;
+
+template<>
+struct Field<CAFFEINE> {
+    explicit Field(int32_t size) : atoms(caffeineAtoms()), invDim(1.0f / float(size - 1)) {}
+    float operator()(int32_t x, int32_t y, int32_t z) const {
+        float rho = 0.0f;
+        for(auto const & a : atoms) {
+            rho += a.eval(float(x) * invDim, float(y) * invDim, float(z) * invDim);
+        }
+        return std::min(rho * 2.5f, 1.0f);
+    }
+    std::vector<RadialGaussian> atoms;
+    float invDim;
+};
+
+template<>
+struct Field<NOISE> {
+    explicit Field(int32_t) {}
+    float operator()(int32_t x, int32_t y, int32_t z) const {
+        return hashNoise(uint32_t(x), uint32_t(y), uint32_t(z));
+    }
+};
+
+template<>
+struct Field<SPARSE_SDF> {
+    explicit Field(int32_t size) : size(float(size)) {}
+    float operator()(int32_t x, int32_t y, int32_t z) const {
+        // spheres with a radius of 3% of the volume, densities are 0.5 on the
+        // surface and fall off to 0 and 1 within 4 voxels
+        static constexpr float centers[4][3] = {{0.25f, 0.25f, 0.25f}, {0.75f, 0.3f, 0.6f}, {0.4f, 0.8f, 0.7f}, {0.6f, 0.5f, 0.2f}};
+        float distance = std::numeric_limits<float>::max();
+        for(auto const & c : centers) {
+            float const dx = float(x) - c[0] * size;
+            float const dy = float(y) - c[1] * size;
+            float const dz = float(z) - c[2] * size;
+            distance = std::min(distance, std::sqrt(dx * dx + dy * dy + dz * dz) - 0.03f * size);
+        }
+        return std::clamp(0.5f - distance / 8.0f, 0.0f, 1.0f);
+    }
+    float size;
+};
+
+/// Sample a field into a size^3 volume on all hardware threads.
+template<class T, Workload W>
+void sampleField(std::vector<T> & data, int32_t size) {
+    Field<W> const field(size);
+    size_t const sliceSize = size_t(size) * size_t(size);
+    data.resize(sliceSize * size_t(size));
+
+    uint32_t const threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::jthread> workers;
+    for(uint32_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t]() {
+            for(int32_t z = int32_t(t); z < size; z += int32_t(threadCount)) {
+                T * slice = &data[sliceSize * size_t(z)];
+                for(int32_t y = 0; y < size; ++y) {
+                    for(int32_t x = 0; x < size; ++x) {
+                        slice[size_t(y) * size_t(size) + size_t(x)] = T((field(x, y, z) - (signedDistance<T>() ? 0.5f : 0.0f)) * maxValue<T>());
+                    }
+                }
+            }
+        });
+    }
+}
+
+/// Last generated volume of a voxel type.
+template<class T>
+struct VolumeCache {
+    static inline std::vector<T> data;
+    static inline Workload workload = CAFFEINE;
+    static inline int32_t size = 0;
+
+    static void release() {
+        data.clear();
+        data.shrink_to_fit();
+        size = 0;
+    }
+};
+
+/// releases the cached volume of the voxel type requested last
+void (*releaseCachedVolume)() = nullptr;
+
+/// Get the volume of a workload. Only the last requested volume is kept,
+/// which bounds the memory of the suite.
+template<class T>
+std::vector<T> const & getVolume(Workload workload, int32_t size) {
+    using Cache = VolumeCache<T>;
+    if(Cache::size != size || Cache::workload != workload) {
+        if(releaseCachedVolume != nullptr) {
+            releaseCachedVolume();
+        }
+        switch(workload) {
+            case CAFFEINE: sampleField<T, CAFFEINE>(Cache::data, size); break;
+            case NOISE: sampleField<T, NOISE>(Cache::data, size); break;
+            case SPARSE_SDF: sampleField<T, SPARSE_SDF>(Cache::data, size); break;
+        }
+        Cache::workload = workload;
+        Cache::size = size;
+        releaseCachedVolume = &Cache::release;
+    }
+    return Cache::data;
+}
+
+/// Peak resident set size of the process in bytes.
+double peakRSS() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return double(counters.PeakWorkingSetSize);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return double(usage.ru_maxrss);
+#else
+    return double(usage.ru_maxrss) * 1024.0;
+#endif
+#endif
+}
+
+/// Number of cells along each axis, whose faces the mesher constructs. As in
+/// Mesher::GetCellCount, the border cells are only read by the manifold test.
+int32_t meshedCellCount(int32_t size) {
+    return std::max(size - 4, 0);
+}
+
+/// Report cell and vertex throughput and the peak memory of the process so far.
+void reportCounters(benchmark::State & state, int32_t size, dualmc::Mesh const & mesh) {
+    double const cells = std::pow(double(meshedCellCount(size)), 3.0);
+    state.counters["cells/s"] = benchmark::Counter(cells, benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["vertices/s"] = benchmark::Counter(double(mesh.vertices.size()), benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["vertices"] = double(mesh.vertices.size());
+    state.counters["peakRSS"] = benchmark::Counter(peakRSS(), benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+}
+
+/// Arguments are the workload, the volume size and the topology.
+dualmc::Topology topologyArg(benchmark::State const & state) {
+    return state.range(2) == 0 ? dualmc::Topology::Quads : dualmc::Topology::Triangles;
+}
+
+template<class T>
+T isoValue() {
+    return signedDistance<T>() ? T(0) : T(0.5f * maxValue<T>());
+}
+
+//------------------------------------------------------------------------------
+// full extraction
+
+template<class T>
+void BM_Build(benchmark::State & state) {
+    Workload const workload = Workload(state.range(0));
+    int32_t const size = int32_t(state.range(1));
+    std::vector<T> const & data = getVolume<T>(workload, size);
+    std::span<T const> const volume(data);
+
+    dualmc::Mesher<T> mesher;
+    dualmc::Mesh mesh;
+    for(auto _ : state) {
+        mesher.Build(volume, {size, size, size}, isoValue<T>(), mesh, topologyArg(state));
+        benchmark::DoNotOptimize(mesh.indices.data());
+    }
+    reportCounters(state, size, mesh);
+}
+
+template<class T>
+void BM_BuildParallel(benchmark::State & state) {
+    Workload const workload = Workload(state.range(0));
+    int32_t const size = int32_t(state.range(1));
+    std::vector<T> const & data = getVolume<T>(workload, size);
+    std::span<T const> const volume(data);
+
+    dualmc::Mesher<T> mesher;
+    dualmc::Mesh mesh;
+    for(auto _ : state) {
+        mesher.BuildParallel(volume, {size, size, size}, isoValue<T>(), mesh, topologyArg(state), dualmc::Manifold::On, 0);
+        benchmark::DoNotOptimize(mesh.indices.data());
+    }
+    reportCounters(state, size, mesh);
+}
+
+template<class T>
+void BM_BuildPyramid(benchmark::State & state) {
+    Workload const workload = Workload(state.range(0));
+    int32_t const size = int32_t(state.range(1));
+    std::vector<T> const & data = getVolume<T>(workload, size);
+    std::span<T const> const volume(data);
+
+    dualmc::MinMaxPyramid<T> const pyramid(data, {size, size, size});
+    dualmc::Mesher<T> mesher;
+    dualmc::Mesh mesh;
+    for(auto _ : state) {
+        mesher.Build(volume, {size, size, size}, isoValue<T>(), mesh, topologyArg(state), dualmc::Manifold::On, &pyramid);
+        benchmark::DoNotOptimize(mesh.indices.data());
+    }
+    reportCounters(state, size, mesh);
+}
+
+//------------------------------------------------------------------------------
+// stages
+
+/// Classification of the cells the mesher constructs faces of with the
+/// vectorized row kernels.
+template<class T>
+void BM_StageClassify(benchmark::State & state) {
+    Workload const workload = Workload(state.range(0));
+    int32_t const size = int32_t(state.range(1));
+    std::vector<T> const & data = getVolume<T>(workload, size);
+
+    int32_t const cellCount = meshedCellCount(size);
+    size_t const rowSize = size_t(size);
+    size_t const sliceSize = rowSize * rowSize;
+    size_t const width = size_t(cellCount) + 1;
+    std::vector<uint8_t> inside(4 * width);
+    std::vector<uint8_t> codes(width);
+    for(auto _ : state) {
+        for(int32_t z = 0; z < cellCount; ++z) {
+            for(int32_t y = 0; y < cellCount; ++y) {
+                T const * row = &data[sliceSize * size_t(z) + rowSize * size_t(y)];
+                dualmc::kernels::ClassifyRow(row, width, isoValue<T>(), &inside[0]);
+                dualmc::kernels::ClassifyRow(row + rowSize, width, isoValue<T>(), &inside[width]);
+                dualmc::kernels::ClassifyRow(row + sliceSize, width, isoValue<T>(), &inside[2 * width]);
+                dualmc::kernels::ClassifyRow(row + sliceSize + rowSize, width, isoValue<T>(), &inside[3 * width]);
+                dualmc::kernels::AssembleCubeCodes(dualmc::kernels::ActiveInstructionSet(),
+                    &inside[0], &inside[width], &inside[2 * width], &inside[3 * width], width - 1, codes.data());
+                benchmark::DoNotOptimize(codes.data());
+            }
+        }
+    }
+    state.counters["cells/s"] = benchmark::Counter(std::pow(double(cellCount), 3.0), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/// Construction of the min/max pyramid.
+template<class T>
+void BM_StagePyramid(benchmark::State & state) {
+    Workload const workload = Workload(state.range(0));
+    int32_t const size = int32_t(state.range(1));
+    std::vector<T> const & data = getVolume<T>(workload, size);
+
+    dualmc::MinMaxPyramid<T> pyramid;
+    for(auto _ : state) {
+        pyramid.Build(data, {size, size, size});
+        benchmark::DoNotOptimize(&pyramid);
+    }
+    state.counters["voxels/s"] = benchmark::Counter(double(data.size()), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+//------------------------------------------------------------------------------
+
+/// Register the workloads with sizes from 64^3 to maxSize^3 and both topologies.
+void volumeArgs(benchmark::internal::Benchmark * b, int64_t maxSize, bool withTopology) {
+    b->ArgNames({"workload", "size", "topology"});
+    for(int64_t workload : {CAFFEINE, NOISE, SPARSE_SDF}) {
+        for(int64_t size = 64; size <= maxSize; size *= 2) {
+            for(int64_t topology = 0; topology < (withTopology ? 2 : 1); ++topology) {
+                b->Args({workload, size, topology});
+            }
+        }
+    }
+    b->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+void fullArgs(benchmark::internal::Benchmark * b) { volumeArgs(b, 1024, true); }
+void stageArgs(benchmark::internal::Benchmark * b) { volumeArgs(b, 1024, false); }
+// float volumes of 1024^3 voxels need 4 GiB
+void floatArgs(benchmark::internal::Benchmark * b) { volumeArgs(b, 512, true); }
+void floatStageArgs(benchmark::internal::Benchmark * b) { volumeArgs(b, 512, false); }
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Build, uint8_t)->Apply(fullArgs);
+BENCHMARK_TEMPLATE(BM_Build, uint16_t)->Apply(fullArgs);
+BENCHMARK_TEMPLATE(BM_Build, float)->Apply(floatArgs);
+BENCHMARK_TEMPLATE(BM_Build, int16_t)->Apply(fullArgs);
+#if defined(DUALMC_HAS_HALF)
+BENCHMARK_TEMPLATE(BM_Build, dualmc::half)->Apply(fullArgs);
+#endif
+BENCHMARK_TEMPLATE(BM_BuildParallel, uint8_t)->Apply(fullArgs);
+BENCHMARK_TEMPLATE(BM_BuildParallel, uint16_t)->Apply(fullArgs);
+BENCHMARK_TEMPLATE(BM_BuildParallel, float)->Apply(floatArgs);
+BENCHMARK_TEMPLATE(BM_BuildPyramid, uint8_t)->Apply(fullArgs);
+BENCHMARK_TEMPLATE(BM_BuildPyramid, uint16_t)->Apply(fullArgs);
+BENCHMARK_TEMPLATE(BM_BuildPyramid, float)->Apply(floatArgs);
+BENCHMARK_TEMPLATE(BM_StageClassify, uint8_t)->Apply(stageArgs);
+BENCHMARK_TEMPLATE(BM_StageClassify, uint16_t)->Apply(stageArgs);
+BENCHMARK_TEMPLATE(BM_StageClassify, float)->Apply(floatStageArgs);
+BENCHMARK_TEMPLATE(BM_StageClassify, int16_t)->Apply(stageArgs);
+#if defined(DUALMC_HAS_HALF)
+BENCHMARK_TEMPLATE(BM_StageClassify, dualmc::half)->Apply(stageArgs);
+#endif
+BENCHMARK_TEMPLATE(BM_StagePyramid, uint8_t)->Apply(stageArgs);
+BENCHMARK_TEMPLATE(BM_StagePyramid, uint16_t)->Apply(stageArgs);
+BENCHMARK_TEMPLATE(BM_StagePyramid, float)->Apply(floatStageArgs);
+
+BENCHMARK_MAIN();
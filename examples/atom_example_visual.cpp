@@ -9,17 +9,20 @@
 #include <cstring>
 
 // std libs
+#include <algorithm>
 #include <chrono>
-#include <fstream>
 #include <iostream>
 #include <limits>
 #include <string>
 
 // stl includes
+#include <span>
 #include <vector>
 
 // dual mc builder vertex and quad definitions
 #include <dmc/dualmc.hpp>
+#include <dmc/mapped_file.hpp>
+#include <dmc/mesh_writer.hpp>
 
 using std::chrono::high_resolution_clock;
 using std::chrono::duration;
@@ -40,26 +43,45 @@ private:
         int32_t dimY;
         int32_t dimZ;
         float isoValue;
+        bool hasIsoValue;
+        std::string voxelType;
         bool generateCaffeine;
         bool generateManifold;
+        bool generateTriangles;
+        bool generateNormals;
+        bool placeQef;
+        uint32_t threadCount;
         std::string outputFile;
     };
 
     /// Parse program arguments.
     bool parseArgs(int const argc, char** argv, AppOptions & options);
 
-    /// Generate an example volume for the dual mc builder.
-    void generateCaffeine();
+    /// Generate an example volume for the dual mc builder. Unless dense is set,
+    /// only the atoms are set up and the volume is sampled while meshing.
+    void generateCaffeine(bool const dense);
+
+    /// Sample the caffeine density at a voxel.
+    uint16_t sampleCaffeine(int32_t x, int32_t y, int32_t z) const;
+
+    /// Conservative range of the caffeine density in a box of voxels.
+    dualmc::Mesher<uint16_t>::Range boundCaffeine(dualmc::int3 const & min, dualmc::int3 const & max) const;
     
-    /// Load volume from raw file.
-    bool loadRawFile(std::string const & fileName, int32_t dimX, int32_t dimY, int32_t dimZ);
+    /// Load volume from raw file. Unless a voxel type is given, 8 or 16-bit
+    /// voxels are assumed by the file size.
+    bool loadRawFile(std::string const & fileName, int32_t dimX, int32_t dimY, int32_t dimZ, std::string const & voxelType);
 
     /// Compute the iso surface for the specified iso value. Optionally generate
     /// a quad soup.
-    void computeSurface(float const iso, bool const generateManifold);
+    void computeSurface(float const iso, bool const generateManifold, bool const generateTriangles, bool const generateNormals, bool const placeQef, uint32_t const threadCount);
+
+    /// Extract the surface of the loaded or generated voxels of type T.
+    template<class T>
+    void computeVolumeSurface(T const iso, dualmc::Manifold const manifold, dualmc::Normals const normals, dualmc::Placement const placement, uint32_t const threadCount);
     
-    /// Write a Wavefront OBJ model for the extracted ISO surface.
-    void writeOBJ(std::string const & fileName) const;
+    /// Write the extracted ISO surface as binary PLY, binary STL or Wavefront
+    /// OBJ model, depending on the file extension.
+    void writeMesh(std::string const & fileName) const;
     
     /// Print program arguments.
     void printArgs() const;
@@ -68,16 +90,29 @@ private:
     void printHelpHint() const;
    
 private:
+    /// voxel types of the volume, 8 and 16-bit unsigned voxels hold normalized
+    /// densities, the others hold values such as signed distances
+    enum class VoxelFormat { UInt8, UInt16, Int16, Half, Float, Double };
+
+    /// Find the voxel format of a type name and its size in bytes.
+    static bool parseVoxelFormat(std::string const & name, VoxelFormat & format, size_t & voxelSize);
+
     /// struct for volume data information
     struct Volume {
         // volume grid extents
         int32_t dimX;
         int32_t dimY;
         int32_t dimZ;
-        // bit depth, should be 8 or 16
-        int32_t bitDepth;
-        /// volume data
+        // type of the voxels
+        VoxelFormat format;
+        /// generated volume data
         std::vector<uint8_t> data;
+        /// memory mapping of a loaded RAW file
+        dualmc::MappedFile file;
+        /// voxels of the generated volume or of the mapped file
+        std::span<const std::byte> bytes;
+        /// the volume is sampled from the caffeine atoms instead of bytes
+        bool procedural = false;
     };
        
     /// example volume
@@ -90,6 +125,8 @@ private:
         RadialGaussian(float cX, float cY, float cZ, float variance);
         // evaluate the sphere function
         float eval(float x, float y, float z) const;
+        // evaluate the range of the sphere function in a box
+        void evalRange(float minX, float minY, float minZ, float maxX, float maxY, float maxZ, float & low, float & high) const;
     private:
         // Coordinates of the sphere center.
         float cX;
@@ -101,8 +138,15 @@ private:
         
     };
 
+    /// atoms of the caffeine molecule in [0,1]^3 volume coordinates
+    std::vector<RadialGaussian> atoms;
+    /// scale for density field
+    static constexpr float caffeineDensityScale = 2.5f;
+
     // extracted surface
     dualmc::Mesh mesh{};
+    // face topology of the extracted surface
+    dualmc::Topology topology = dualmc::Topology::Quads;
 };
 
 //------------------------------------------------------------------------------
@@ -116,9 +160,10 @@ void DualMCExample::run(int const argc, char** argv) {
     
     // load raw file or generate example volume dataset
     if(options.generateCaffeine) {
-        generateCaffeine();
+        // normals are computed from the dense volume
+        generateCaffeine(options.generateNormals);
     } else if(!options.inputFile.empty()) {
-        if(!loadRawFile(options.inputFile, options.dimX, options.dimY, options.dimZ)) {
+        if(!loadRawFile(options.inputFile, options.dimX, options.dimY, options.dimZ, options.voxelType)) {
             return;
         }
     } else {
@@ -127,11 +172,15 @@ void DualMCExample::run(int const argc, char** argv) {
         return;
     }
     
+    // signed distances are extracted at 0 by default
+    bool const normalized = volume.format == VoxelFormat::UInt8 || volume.format == VoxelFormat::UInt16;
+    float const iso = options.hasIsoValue || normalized ? options.isoValue : 0.0f;
+    
     // compute ISO surface
-    computeSurface(options.isoValue,options.generateManifold);
+    computeSurface(iso,options.generateManifold,options.generateTriangles,options.generateNormals,options.placeQef,options.threadCount);
     
     // write output file
-    writeOBJ(options.outputFile);
+    writeMesh(options.outputFile);
 }
 
 //------------------------------------------------------------------------------
@@ -143,8 +192,14 @@ bool DualMCExample::parseArgs(int const argc, char** argv, AppOptions & options)
     options.dimY = -1;
     options.dimZ = -1;
     options.isoValue = 0.5f;
+    options.hasIsoValue = false;
+    options.voxelType.assign("");
     options.generateCaffeine = false;
     options.generateManifold = false;
+    options.generateTriangles = false;
+    options.generateNormals = false;
+    options.placeQef = false;
+    options.threadCount = 1;
     options.outputFile.assign("surface.obj");
     
     // parse arguments
@@ -153,18 +208,45 @@ bool DualMCExample::parseArgs(int const argc, char** argv, AppOptions & options)
             options.generateCaffeine = true;
         } else if(strcmp(argv[currentArg],"-manifold") == 0) {
             options.generateManifold = true;
+        } else if(strcmp(argv[currentArg],"-triangles") == 0) {
+            options.generateTriangles = true;
+        } else if(strcmp(argv[currentArg],"-normals") == 0) {
+            options.generateNormals = true;
+        } else if(strcmp(argv[currentArg],"-qef") == 0) {
+            options.placeQef = true;
         } else if(strcmp(argv[currentArg],"-iso") == 0) {
             if(currentArg+1 == argc) {
                 std::cerr << "Iso value missing" << std::endl;
                 return false;
             }
-            // Read the iso value and clamp it to [0,1].
-            // Invalid values are set to 0.
+            // Read the iso value, which is clamped to [0,1] for normalized
+            // voxels. Invalid values are set to 0.
             options.isoValue = atof(argv[currentArg+1]);
-            if(options.isoValue > 1.0f)
-                options.isoValue = 1.0f;
-            else if(options.isoValue < 0.0f || options.isoValue != options.isoValue)
+            if(options.isoValue != options.isoValue)
                 options.isoValue = 0.0f;
+            options.hasIsoValue = true;
+            ++currentArg;
+        } else if(strcmp(argv[currentArg],"-type") == 0) {
+            if(currentArg+1 == argc) {
+                std::cerr << "Voxel type missing" << std::endl;
+                return false;
+            }
+            VoxelFormat format;
+            size_t voxelSize;
+            if(!parseVoxelFormat(argv[currentArg+1], format, voxelSize)) {
+                std::cerr << "Unknown voxel type: " << argv[currentArg+1] << std::endl;
+                return false;
+            }
+            options.voxelType.assign(argv[currentArg+1]);
+            ++currentArg;
+        } else if(strcmp(argv[currentArg],"-threads") == 0) {
+            if(currentArg+1 == argc) {
+                std::cerr << "Thread count missing" << std::endl;
+                return false;
+            }
+            // 0 selects the number of hardware threads
+            int const threads = atoi(argv[currentArg+1]);
+            options.threadCount = threads < 0 ? 1 : threads;
             ++currentArg;
         } else if(strcmp(argv[currentArg],"-out") == 0) {
             if(currentArg+1 == argc) {
@@ -201,10 +283,15 @@ void DualMCExample::printArgs() const {
     std::cout << "Usage: dmc ARGS" << std::endl;
     std::cout << " -help              print this help" << std::endl;
     std::cout << " -raw FILE X Y Z    specify raw file with dimensions" << std::endl;
+    std::cout << " -type T            voxel type of the raw file: uint8, uint16, int16, half, float or double. DEFAULT: uint8 or uint16 by file size" << std::endl;
     std::cout << " -caffeine          generate built-in caffeine molecule" << std::endl;
     std::cout << " -manifold          use Manifold Dual Marching Cubes algorithm (Rephael Wenger)" << std::endl;
-    std::cout << " -iso X             specify iso value X in [0,1]. DEFAULT: 0.5" << std::endl;
-    std::cout << " -out FILE          specify output file name. DEFAULT: surface.obj" << std::endl;
+    std::cout << " -iso X             specify iso value X in [0,1] for uint8 and uint16 voxels, the voxel value otherwise. DEFAULT: 0.5, or 0 for signed voxels" << std::endl;
+    std::cout << " -threads N         extract with N threads, 0 uses all hardware threads. DEFAULT: 1" << std::endl;
+    std::cout << " -triangles         generate triangles instead of quads" << std::endl;
+    std::cout << " -normals           compute vertex normals from the volume gradient" << std::endl;
+    std::cout << " -qef               place dual points on sharp features with QEFs" << std::endl;
+    std::cout << " -out FILE          specify output file name, .ply and .stl files are binary. DEFAULT: surface.obj" << std::endl;
     std::cout << " -soup              generate a quad soup (no vertex sharing)" << std::endl;
 }
 
@@ -216,24 +303,55 @@ void DualMCExample::printHelpHint() const {
 
 //------------------------------------------------------------------------------
 
-void DualMCExample::computeSurface(float const iso, bool const generateManifold) {
+void DualMCExample::computeSurface(float const iso, bool const generateManifold, bool const generateTriangles, bool const generateNormals, bool const placeQef, uint32_t const threadCount) {
     std::cout << "Computing surface" << std::endl;
     
     // measure extraction time
     high_resolution_clock::time_point const startTime = high_resolution_clock::now();
     
-    // construct iso surface
-    if(volume.bitDepth == 8) {
-        dualmc::Mesher<uint8_t> builder;
-        mesh = builder.Build(volume.data, {volume.dimX, volume.dimY, volume.dimZ},
-            iso * std::numeric_limits<uint8_t>::max(), dualmc::Topology::Quads);
-    } else if(volume.bitDepth == 16) {
+    dualmc::Manifold const manifold = generateManifold ? dualmc::Manifold::On : dualmc::Manifold::Off;
+    topology = generateTriangles ? dualmc::Topology::Triangles : dualmc::Topology::Quads;
+    dualmc::Normals const normals = generateNormals ? dualmc::Normals::On : dualmc::Normals::Off;
+    dualmc::Placement const placement = placeQef ? dualmc::Placement::Qef : dualmc::Placement::Mean;
+
+    // construct iso surface directly from the generated or mapped voxels,
+    // normalized iso values are mapped to the range of the voxel type
+    float const density = std::clamp(iso, 0.0f, 1.0f);
+    if(volume.procedural) {
+        // sample the density lazily near the surface
+        dualmc::int3 const dimension{volume.dimX, volume.dimY, volume.dimZ};
         dualmc::Mesher<uint16_t> builder;
-        mesh = builder.Build({(uint16_t*)&volume.data.front(), volume.data.size() / sizeof(uint16_t)}, {volume.dimX, volume.dimY, volume.dimZ},
-            iso * std::numeric_limits<uint16_t>::max(), dualmc::Topology::Quads);
+        builder.SetPlacement(placement);
+        mesh = builder.BuildField(
+            [this](int32_t x, int32_t y, int32_t z) { return sampleCaffeine(x, y, z); },
+            [this](dualmc::int3 const & min, dualmc::int3 const & max) { return boundCaffeine(min, max); },
+            dimension, density * std::numeric_limits<uint16_t>::max(), topology, manifold);
     } else {
-        std::cerr << "Invalid volume bit depth" << std::endl;
-        return;
+        switch(volume.format) {
+        case VoxelFormat::UInt8:
+            computeVolumeSurface<uint8_t>(density * std::numeric_limits<uint8_t>::max(), manifold, normals, placement, threadCount);
+            break;
+        case VoxelFormat::UInt16:
+            computeVolumeSurface<uint16_t>(density * std::numeric_limits<uint16_t>::max(), manifold, normals, placement, threadCount);
+            break;
+        case VoxelFormat::Int16:
+            computeVolumeSurface<int16_t>(int16_t(std::clamp(std::round(iso), -32768.0f, 32767.0f)), manifold, normals, placement, threadCount);
+            break;
+        case VoxelFormat::Half:
+#if defined(DUALMC_HAS_HALF)
+            computeVolumeSurface<dualmc::half>(dualmc::half(iso), manifold, normals, placement, threadCount);
+            break;
+#else
+            std::cerr << "Half precision voxels are not supported by the compiler" << std::endl;
+            return;
+#endif
+        case VoxelFormat::Float:
+            computeVolumeSurface<float>(iso, manifold, normals, placement, threadCount);
+            break;
+        case VoxelFormat::Double:
+            computeVolumeSurface<double>(iso, manifold, normals, placement, threadCount);
+            break;
+        }
     }
         
     high_resolution_clock::time_point const endTime = high_resolution_clock::now();
@@ -245,20 +363,26 @@ void DualMCExample::computeSurface(float const iso, bool const generateManifold)
 
 //------------------------------------------------------------------------------
 
-void DualMCExample::generateCaffeine() {
+template<class T>
+void DualMCExample::computeVolumeSurface(T const iso, dualmc::Manifold const manifold, dualmc::Normals const normals, dualmc::Placement const placement, uint32_t const threadCount) {
+    dualmc::int3 const dimension{volume.dimX, volume.dimY, volume.dimZ};
+    dualmc::Mesher<T> builder;
+    builder.SetNormals(normals);
+    builder.SetPlacement(placement);
+    mesh = builder.BuildParallel(dualmc::VolumeView<T>((T const*)volume.bytes.data(), dimension),
+        iso, topology, manifold, threadCount);
+}
+
+//------------------------------------------------------------------------------
+
+void DualMCExample::generateCaffeine(bool const dense) {
     std::cout << "Generating caffeine volume" << std::endl;
     
-    // initialize volume dimensions and memory
+    // initialize volume dimensions
     volume.dimX = 128;
     volume.dimY = 128;
     volume.dimZ = 128;
-    size_t const numDataPoints = volume.dimX * volume.dimY * volume.dimZ;
-    volume.data.resize(numDataPoints*2);
-    volume.bitDepth = 16;
-    
-    float invDimX = 1.0f / (volume.dimX-1);
-    float invDimY = 1.0f / (volume.dimY-1);
-    float invDimZ = 1.0f / (volume.dimZ-1);
+    volume.format = VoxelFormat::UInt16;
     
     // create caffeine molecule
     // 3D structure from https://pubchem.ncbi.nlm.nih.gov/compound/caffeine#section=Top
@@ -277,7 +401,7 @@ void DualMCExample::generateCaffeine() {
     enum ElementType {HYDROGEN=0,CARBON=1,NITROGEN=2,OXYGEN=3};
     
     // approximate electron density with radial Gaussians.
-    std::vector<RadialGaussian> atoms;
+    atoms.clear();
     atoms.reserve(24);
     // 1 hydrogen, 6 carbon, 7 nitrogen, 8 oxygen
     atoms.emplace_back(   0.47 * s + oX,  2.5688 * s + oY,  0.0006 * s + oZ,atomScales[OXYGEN]); // 8
@@ -305,30 +429,24 @@ void DualMCExample::generateCaffeine() {
     atoms.emplace_back(-2.9322 * s + oX,  2.1027 * s + oY,  0.8881 * s + oZ,atomScales[HYDROGEN]); // 1
     atoms.emplace_back(-2.9346 * s + oX,  2.1021 * s + oY, -0.8849 * s + oZ,atomScales[HYDROGEN]); // 1
     
-    uint16_t * data16Bit = (uint16_t*)&volume.data.front();
+    // the mesher samples the density function itself
+    if(!dense) {
+        volume.procedural = true;
+        return;
+    }
     
-    // scale for density field
-    float constexpr postDensityScale = 2.5f;
+    size_t const numDataPoints = size_t(volume.dimX) * size_t(volume.dimY) * size_t(volume.dimZ);
+    volume.data.resize(numDataPoints*2);
+    volume.bytes = std::as_bytes(std::span<uint8_t const>(volume.data));
+    uint16_t * data16Bit = (uint16_t*)&volume.data.front();
     
     // volume write position
-    int32_t p = 0;
+    size_t p = 0;
     // iterate all voxels
-    // compute canoncical [0,1]^3 volume coordinates for density evaluation
     for(int32_t z = 0; z < volume.dimZ; ++z) {
-        float const nZ = float(z) * invDimZ;
         for(int32_t y = 0; y < volume.dimY; ++y) {
-            float const nY = float(y) * invDimY;
             for(int32_t x = 0; x < volume.dimX; ++x, ++p) {
-                float const nX = float(x) * invDimX;
-                float rho = 0.0f;
-                // compute sum of electron densities
-                for(auto const & a : atoms) {
-                    rho += a.eval(nX,nY,nZ);
-                }
-                rho *= postDensityScale;
-                if(rho > 1.0f)
-                    rho = 1.0f;
-                data16Bit[p] = rho * std::numeric_limits<uint16_t>::max();
+                data16Bit[p] = sampleCaffeine(x, y, z);
             }
         }
     }
@@ -336,94 +454,147 @@ void DualMCExample::generateCaffeine() {
 
 //------------------------------------------------------------------------------
 
-bool DualMCExample::loadRawFile(std::string const & fileName, int32_t dimX, int32_t dimY, int32_t dimZ) {
+uint16_t DualMCExample::sampleCaffeine(int32_t x, int32_t y, int32_t z) const {
+    // compute canoncical [0,1]^3 volume coordinates for density evaluation
+    float const nX = float(x) * (1.0f / (volume.dimX-1));
+    float const nY = float(y) * (1.0f / (volume.dimY-1));
+    float const nZ = float(z) * (1.0f / (volume.dimZ-1));
+    float rho = 0.0f;
+    // compute sum of electron densities
+    for(auto const & a : atoms) {
+        rho += a.eval(nX,nY,nZ);
+    }
+    rho *= caffeineDensityScale;
+    if(rho > 1.0f)
+        rho = 1.0f;
+    return rho * std::numeric_limits<uint16_t>::max();
+}
+
+//------------------------------------------------------------------------------
+
+dualmc::Mesher<uint16_t>::Range DualMCExample::boundCaffeine(dualmc::int3 const & min, dualmc::int3 const & max) const {
+    float const invDimX = 1.0f / (volume.dimX-1);
+    float const invDimY = 1.0f / (volume.dimY-1);
+    float const invDimZ = 1.0f / (volume.dimZ-1);
+    // interval sum of the electron densities
+    float low = 0.0f;
+    float high = 0.0f;
+    for(auto const & a : atoms) {
+        float atomLow;
+        float atomHigh;
+        a.evalRange(min[0] * invDimX, min[1] * invDimY, min[2] * invDimZ,
+            max[0] * invDimX, max[1] * invDimY, max[2] * invDimZ, atomLow, atomHigh);
+        low += atomLow;
+        high += atomHigh;
+    }
+    // widen the range by the rounding of the samples
+    float constexpr maxValue = std::numeric_limits<uint16_t>::max();
+    low = std::floor(std::min(low * caffeineDensityScale, 1.0f) * maxValue * 0.999f) - 1.0f;
+    high = std::ceil(std::min(high * caffeineDensityScale, 1.0f) * maxValue * 1.001f) + 1.0f;
+    return {uint16_t(std::max(low, 0.0f)), uint16_t(std::min(high, maxValue))};
+}
+
+//------------------------------------------------------------------------------
+
+bool DualMCExample::parseVoxelFormat(std::string const & name, VoxelFormat & format, size_t & voxelSize) {
+    struct NamedFormat {
+        char const * name;
+        VoxelFormat format;
+        size_t voxelSize;
+    };
+    static NamedFormat const formats[] = {
+        {"uint8", VoxelFormat::UInt8, 1}, {"uint16", VoxelFormat::UInt16, 2}, {"int16", VoxelFormat::Int16, 2},
+        {"half", VoxelFormat::Half, 2}, {"float", VoxelFormat::Float, 4}, {"double", VoxelFormat::Double, 8}
+    };
+    for(NamedFormat const & named : formats) {
+        if(name == named.name) {
+            format = named.format;
+            voxelSize = named.voxelSize;
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+
+bool DualMCExample::loadRawFile(std::string const & fileName, int32_t dimX, int32_t dimY, int32_t dimZ, std::string const & voxelType) {
     // check provided dimensions
     if(dimX < 1 || dimY < 1 || dimZ < 1) {
         std::cerr << "Invalid RAW file dimensions specified" << std::endl;
         return false;
     }
     
-    // open raw file
-    std::ifstream file(fileName, std::ifstream::binary);
-    if(!file) {
+    // map raw file, its pages are read while the surface is extracted
+    if(!volume.file.Open(fileName, dualmc::MappedFile::Access::Sequential)) {
         std::cerr << "Unable to open file '" << fileName << "'" << std::endl;
         return false;
     }
     
     // check consistency of file size and volume dimensions
     size_t const expectedFileSize = size_t(dimX) * size_t(dimY) * size_t(dimZ);
-    file.seekg (0, file.end);
-    size_t const fileSize = file.tellg();
-    file.seekg (0, file.beg);
+    size_t const fileSize = volume.file.Size();
     
-    if(expectedFileSize != fileSize) {
+    if(!voxelType.empty()) {
+        size_t voxelSize = 1;
+        parseVoxelFormat(voxelType, volume.format, voxelSize);
+        if(expectedFileSize * voxelSize != fileSize) {
+            std::cerr << "File size inconsistent with specified dimensions and voxel type" << std::endl;
+            return false;
+        }
+    } else if(expectedFileSize != fileSize) {
         if(expectedFileSize * 2 == fileSize) {
             std::cout << "Assuming 16-bit RAW file" << std::endl;
-            volume.bitDepth = 16;
+            volume.format = VoxelFormat::UInt16;
         } else {
             std::cerr << "File size inconsistent with specified dimensions" << std::endl;
             return false;
         }
     } else {
-        volume.bitDepth = 8;
+        volume.format = VoxelFormat::UInt8;
     }
 
-    //
-    if(expectedFileSize >= 0xffffffffu) {
-        std::cerr << "Too many voxels. Please improve the dual mc implementation." << std::endl;
-        return false;
-    }
-    
-    // initialize volume dimensions and memory
+    // initialize volume dimensions, the voxels stay in the mapping
     volume.dimX = dimX;
     volume.dimY = dimY;
     volume.dimZ = dimZ;
-    volume.data.resize(fileSize);
-    
-    // read data
-    file.read((char*)&volume.data[0], fileSize);
-    
-    if(!file) {
-        std::cerr << "Error while reading file" << std::endl;
-        return false;
-    }
+    volume.bytes = volume.file.Bytes();
     
     return true;
 }
 
 //------------------------------------------------------------------------------
 
-void DualMCExample::writeOBJ(std::string const & fileName) const {
-    std::cout << "Writing OBJ file" << std::endl;
+void DualMCExample::writeMesh(std::string const & fileName) const {
+    std::cout << "Writing mesh file" << std::endl;
     // check if we actually have an ISO surface
     if(mesh.vertices.size () == 0 || mesh.indices.size() == 0) {
-        std::cout << "No ISO surface generated. Skipping OBJ generation." << std::endl;
+        std::cout << "No ISO surface generated. Skipping mesh generation." << std::endl;
         return;
     }
     
-    // open output file
-    std::ofstream file(fileName);
-    if(!file) {
-        std::cout << "Error opening output file" << std::endl;
-        return;
-    }
+    std::cout << "Generating mesh with " << mesh.vertices.size() << " vertices and "
+      << mesh.indices.size() / dualmc::GetFaceSize(topology)
+      << (topology == dualmc::Topology::Quads ? " quads" : " triangles") << std::endl;
     
-    std::cout << "Generating OBJ mesh with " << mesh.vertices.size() << " vertices and "
-      << mesh.indices.size() / 4 << " quads" << std::endl;
+    // select the format by the file extension
+    auto const hasExtension = [&](char const * extension) {
+        size_t const length = strlen(extension);
+        return fileName.size() >= length && fileName.compare(fileName.size() - length, length, extension) == 0;
+    };
     
-    // write vertices
-    for(auto const & v : mesh.vertices) 
-    {
-        file << "v " << v.position[0] << ' ' << v.position[1] << ' ' << v.position[2] << '\n';
+    bool written;
+    if(hasExtension(".ply")) {
+        written = dualmc::WritePLY(fileName, mesh, topology);
+    } else if(hasExtension(".stl")) {
+        written = dualmc::WriteSTL(fileName, mesh, topology);
+    } else {
+        written = dualmc::WriteOBJ(fileName, mesh, topology);
     }
     
-    // write quad indices
-    for(size_t i = 0; i < mesh.indices.size(); i+=4)
-    {
-        file << "f " << (mesh.indices[i + 0] + 1) << ' ' << (mesh.indices[i + 1] + 1) << ' ' << (mesh.indices[i + 2] + 1) << ' ' << (mesh.indices[i + 3] + 1 ) << '\n';
+    if(!written) {
+        std::cout << "Error writing output file" << std::endl;
     }
-    
-    file.close();
 }
 
 //------------------------------------------------------------------------------
@@ -451,6 +622,29 @@ float DualMCExample::RadialGaussian::eval(float x, float y, float z) const {
     return normalization * exp(falloff * dSquared);
 }
 
+//------------------------------------------------------------------------------
+
+void DualMCExample::RadialGaussian::evalRange(
+    float minX, float minY, float minZ,
+    float maxX, float maxY, float maxZ,
+    float & low, float & high
+    ) const {
+    // squared distances of the nearest and farthest point of the box
+    float nearSquared = 0.0f;
+    float farSquared = 0.0f;
+    float const lower[3] = {minX - cX, minY - cY, minZ - cZ};
+    float const upper[3] = {maxX - cX, maxY - cY, maxZ - cZ};
+    for(int i = 0; i < 3; ++i) {
+        float const nearest = lower[i] > 0.0f ? lower[i] : (upper[i] < 0.0f ? -upper[i] : 0.0f);
+        float const farthest = std::max(std::fabs(lower[i]), std::fabs(upper[i]));
+        nearSquared += nearest * nearest;
+        farSquared += farthest * farthest;
+    }
+    // the gauss falls off with the distance
+    low = normalization * exp(falloff * farSquared);
+    high = normalization * exp(falloff * nearSquared);
+}
+
 int main( int argc, char** argv) 
 {
     DualMCExample example;
@@ -0,0 +1,415 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_ASYNC_MESHER_H_INCLUDED
+#define DUALMC_ASYNC_MESHER_H_INCLUDED
+
+/// \file   async_mesher.hpp
+/// Asynchronous extraction in z-slabs, which reports its progress, delivers
+/// the mesh of each slab when it is done and can be cancelled between slabs.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+
+// stl includes
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    /// \class  AsyncMesher
+    /// Starts extractions, which run in the background while the caller goes
+    /// on, e.g. an interactive viewer re-extracting a surface whenever its iso
+    /// value changes. The cells are split into z-slabs of slabDepth cells, which
+    /// are extracted by workers on their own threads or on an executor of the
+    /// caller, e.g. the thread pool of an application. Each slab is a separate
+    /// mesh as for IncrementalMesher, dual points on slab seams are duplicated
+    /// in the meshes of both slabs. Job::Assemble welds them again.
+    template<class T, MeshIndex I = uint32_t>
+    requires VoxelType<T>
+    class AsyncMesher
+    {
+    public:
+        using VolumeDataType = T;
+        using IndexType = I;
+        using MeshType = BasicMesh<IndexType>;
+
+        /// Runs a task on some thread, which may be called from any thread.
+        using Executor = std::function<void(std::function<void()> task)>;
+
+        /// Receives the number of completed slabs and the number of slabs.
+        using ProgressCallback = std::function<void(size_t completedSlabs, size_t slabCount)>;
+
+        /// Receives the mesh of a completed slab, which stays valid as long as
+        /// its job.
+        using SlabCallback = std::function<void(size_t slab, const MeshType& mesh)>;
+
+    private:
+        /// state shared by a job and its workers, which may outlive the job
+        /// while queued on an executor
+        struct State
+        {
+            VolumeView<VolumeDataType> volume;
+            VolumeDataType iso{};
+            Topology topology = Topology::Triangles;
+            Manifold manifold = Manifold::On;
+            Normals normals = Normals::Off;
+            Placement placement = Placement::Mean;
+            const MinMaxPyramid<VolumeDataType>* pyramid = nullptr;
+            int3 cellCount{0, 0, 0};
+            int32_t slabDepth = 0;
+
+            ProgressCallback progress;
+            SlabCallback slabDone;
+
+            std::vector<MeshType> meshes;
+            /// dual points of the vertices of each slab, which identify the
+            /// seam vertices for Assemble
+            std::vector<std::vector<DualPointId>> dualPoints;
+            std::vector<uint8_t> completed;
+
+            std::mutex mutex;
+            std::condition_variable changed;
+            size_t nextSlab = 0;
+            size_t completedCount = 0;
+            size_t runningCount = 0;
+            bool cancelled = false;
+        };
+
+    public:
+        /// \class  Job
+        /// Handle of a running extraction. Destroying or reassigning a job
+        /// cancels it and waits for the slabs in progress, so the volume only
+        /// needs to outlive its job.
+        class Job
+        {
+        public:
+            Job() = default;
+
+            Job(Job&&) noexcept = default;
+
+            Job& operator=(Job&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    Finish();
+                    state = std::move(other.state);
+                    threads = std::move(other.threads);
+                }
+                return *this;
+            }
+
+            Job(const Job&) = delete;
+            Job& operator=(const Job&) = delete;
+
+            ~Job()
+            {
+                Finish();
+            }
+
+            /// Stop the extraction before the next slab. Slabs in progress are
+            /// completed.
+            void Cancel() noexcept
+            {
+                if (!state)
+                    return;
+
+                {
+                    std::lock_guard lock(state->mutex);
+                    state->cancelled = true;
+                }
+                state->changed.notify_all();
+            }
+
+            [[nodiscard]] bool IsCancelled() const noexcept
+            {
+                if (!state)
+                    return false;
+
+                std::lock_guard lock(state->mutex);
+                return state->cancelled;
+            }
+
+            /// Check if all slabs are completed, or no slab is in progress after
+            /// cancelling.
+            [[nodiscard]] bool IsDone() const noexcept
+            {
+                if (!state)
+                    return true;
+
+                std::lock_guard lock(state->mutex);
+                return IsDone(*state);
+            }
+
+            /// Wait until the job is done.
+            void Wait() const
+            {
+                if (!state)
+                    return;
+
+                std::unique_lock lock(state->mutex);
+                state->changed.wait(lock, [this]() { return IsDone(*state); });
+            }
+
+            [[nodiscard]] size_t SlabCount() const noexcept
+            {
+                return state ? state->meshes.size() : 0;
+            }
+
+            [[nodiscard]] size_t CompletedSlabs() const noexcept
+            {
+                if (!state)
+                    return 0;
+
+                std::lock_guard lock(state->mutex);
+                return state->completedCount;
+            }
+
+            /// Check if the mesh of a slab is completed.
+            [[nodiscard]] bool IsSlabCompleted(size_t slab) const noexcept
+            {
+                if (!state)
+                    return false;
+
+                std::lock_guard lock(state->mutex);
+                return state->completed[slab] != 0;
+            }
+
+            /// Get the mesh of a completed slab.
+            [[nodiscard]] const MeshType& GetSlabMesh(size_t slab) const noexcept
+            {
+                assert(IsSlabCompleted(slab) && "Slab is not completed");
+                return state->meshes[slab];
+            }
+
+            /// Wait until the job is done and join the meshes of the completed
+            /// slabs into a single mesh with WeldMeshes. A seam vertex of two
+            /// completed slabs is kept once, as the earlier slab creates it, so
+            /// the mesh of a completed job is the one of Mesher::Build, including
+            /// vertex order. Returns false if slabs are missing after cancelling.
+            /// Throws std::length_error if the vertices do not fit into the
+            /// index type, even though each slab fits.
+            bool Assemble(MeshType& mesh) const
+            {
+                mesh.vertices.clear();
+                mesh.indices.clear();
+                mesh.normals.clear();
+                if (!state)
+                    return false;
+
+                Wait();
+                std::vector<MeshRegion<IndexType>> regions;
+                for (size_t slab = 0; slab < state->meshes.size(); ++slab)
+                {
+                    if (state->completed[slab] == 0)
+                        continue;
+
+                    const int32_t zBegin = int32_t(slab) * state->slabDepth;
+                    const int3 cellBegin{0, 0, zBegin};
+                    const int3 cellEnd{state->cellCount[0], state->cellCount[1], std::min(zBegin + state->slabDepth, state->cellCount[2])};
+                    regions.push_back({&state->meshes[slab], &state->dualPoints[slab], cellBegin, cellEnd});
+                }
+                WeldMeshes<IndexType>(regions, state->cellCount, mesh);
+                return state->completedCount == state->meshes.size();
+            }
+
+        private:
+            friend class AsyncMesher;
+
+            explicit Job(std::shared_ptr<State> state) noexcept : state(std::move(state))
+            {
+            }
+
+            static bool IsDone(const State& state) noexcept
+            {
+                return state.runningCount == 0 && (state.cancelled || state.completedCount == state.meshes.size());
+            }
+
+            /// Cancel the job and wait for the slabs in progress and the own
+            /// worker threads.
+            void Finish() noexcept
+            {
+                Cancel();
+                Wait();
+                threads.clear();
+            }
+
+            std::shared_ptr<State> state;
+            /// workers of jobs without an executor
+            std::vector<std::jthread> threads;
+        };
+
+        /// Slabs hold slabDepth cells along z. They are extracted by workerCount
+        /// workers, 0 uses the number of hardware threads. Without an executor
+        /// each job starts its own worker threads.
+        explicit AsyncMesher(int32_t slabDepth = 16, uint32_t workerCount = 0, Executor executor = {})
+            : slabDepth(slabDepth), workerCount(workerCount), executor(std::move(executor))
+        {
+            assert(slabDepth > 0 && "Slab depth is invalid");
+        }
+
+        /// Start extracting the iso surface of a volume view. The callbacks are
+        /// called on the worker threads after each slab, possibly at the same
+        /// time for different slabs. The volume and the optional min/max pyramid
+        /// must stay valid until the job is done.
+        [[nodiscard]] Job BuildAsync(
+            const VolumeView<VolumeDataType>& volume,
+            VolumeDataType iso,
+            Topology topology = Topology::Triangles,
+            Manifold manifold = Manifold::On,
+            const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+        {
+            assert(volume.data != nullptr && "Volume data is empty");
+            auto state = std::make_shared<State>();
+            state->volume = volume;
+            state->iso = iso;
+            state->topology = topology;
+            state->manifold = manifold;
+            state->normals = normals;
+            state->placement = placement;
+            state->pyramid = pyramid;
+            state->slabDepth = slabDepth;
+            state->progress = progress;
+            state->slabDone = slabDone;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                state->cellCount[i] = std::max(volume.extent[i] - 4, 0);
+            }
+            size_t slabCount = size_t((state->cellCount[2] + slabDepth - 1) / slabDepth);
+            state->meshes.resize(slabCount);
+            state->dualPoints.resize(slabCount);
+            state->completed.assign(slabCount, 0);
+
+            uint32_t workers = workerCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : workerCount;
+            workers = static_cast<uint32_t>(std::min<size_t>(workers, std::max<size_t>(slabCount, 1)));
+
+            Job job(state);
+            for (uint32_t i = 0; i < workers; ++i)
+            {
+                if (executor)
+                {
+                    executor([state]() { RunWorker(*state); });
+                }
+                else
+                {
+                    job.threads.emplace_back([state]() { RunWorker(*state); });
+                }
+            }
+            return job;
+        }
+
+        /// Extract the iso surface of a dense volume asynchronously.
+        [[nodiscard]] Job BuildAsync(
+            const std::span<const VolumeDataType>& data,
+            const int3& dimension,
+            VolumeDataType iso,
+            Topology topology = Topology::Triangles,
+            Manifold manifold = Manifold::On,
+            const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+        {
+            assert(data.size() >= size_t(dimension[0]) * size_t(dimension[1]) * size_t(dimension[2]) && "Volume data is smaller than extent");
+            return BuildAsync(VolumeView<VolumeDataType>(data.data(), dimension), iso, topology, manifold, pyramid);
+        }
+
+        /// Report the progress of the following jobs.
+        void SetProgressCallback(ProgressCallback callback)
+        {
+            progress = std::move(callback);
+        }
+
+        /// Deliver the meshes of the slabs of the following jobs as soon as
+        /// they are completed, e.g. for rendering them before the job is done.
+        void SetSlabCallback(SlabCallback callback)
+        {
+            slabDone = std::move(callback);
+        }
+
+        /// Select if the following jobs compute vertex normals, see
+        /// Mesher::SetNormals.
+        void SetNormals(Normals normals) noexcept
+        {
+            this->normals = normals;
+        }
+
+        /// Select the dual point placement of the following jobs, see
+        /// Mesher::SetPlacement.
+        void SetPlacement(Placement placement) noexcept
+        {
+            this->placement = placement;
+        }
+
+        [[nodiscard]] int32_t SlabDepth() const noexcept { return slabDepth; }
+
+    private:
+        /// Extract slabs until all slabs are taken or the job is cancelled.
+        /// Each worker keeps its mesher, whose scratch buffers are reused for
+        /// its slabs.
+        static void RunWorker(State& state)
+        {
+            Mesher<VolumeDataType, IndexType> mesher;
+            mesher.SetNormals(state.normals);
+            mesher.SetPlacement(state.placement);
+
+            for (;;)
+            {
+                size_t slab;
+                {
+                    std::lock_guard lock(state.mutex);
+                    if (state.cancelled || state.nextSlab == state.meshes.size())
+                        return;
+                    slab = state.nextSlab++;
+                    ++state.runningCount;
+                }
+
+                const int32_t zBegin = int32_t(slab) * state.slabDepth;
+                const int3 cellBegin{0, 0, zBegin};
+                const int3 cellEnd{state.cellCount[0], state.cellCount[1], std::min(zBegin + state.slabDepth, state.cellCount[2])};
+                MeshType& mesh = state.meshes[slab];
+                mesher.BuildRegion(state.volume, state.iso, cellBegin, cellEnd, mesh, state.topology, state.manifold, state.pyramid, &state.dualPoints[slab]);
+
+                size_t completedCount;
+                {
+                    std::lock_guard lock(state.mutex);
+                    state.completed[slab] = 1;
+                    completedCount = ++state.completedCount;
+                }
+                if (state.slabDone)
+                {
+                    state.slabDone(slab, mesh);
+                }
+                if (state.progress)
+                {
+                    state.progress(completedCount, state.meshes.size());
+                }
+
+                // the slab is in progress until its callbacks returned
+                {
+                    std::lock_guard lock(state.mutex);
+                    --state.runningCount;
+                }
+                state.changed.notify_all();
+            }
+        }
+
+        int32_t slabDepth;
+        uint32_t workerCount;
+        Executor executor;
+        ProgressCallback progress;
+        SlabCallback slabDone;
+        Normals normals = Normals::Off;
+        Placement placement = Placement::Mean;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_ASYNC_MESHER_H_INCLUDED
@@ -0,0 +1,202 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_BRICKED_VOLUME_H_INCLUDED
+#define DUALMC_BRICKED_VOLUME_H_INCLUDED
+
+/// \file   bricked_volume.hpp
+/// Volume container storing cubic bricks of voxels in Morton order.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+
+// stl includes
+#include <vector>
+#include <span>
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
+
+// dual mc includes
+#include "types.hpp"
+#include "volume_view.hpp"
+
+namespace dualmc
+{
+    /// \class  BrickedVolume
+    /// Stores a volume as bricks of BrickSize^3 voxels. The voxels of a brick
+    /// are adjacent in memory and x-fastest inside of the brick, and bricks are
+    /// ordered along the Morton curve of their grid coordinates. Neighboring
+    /// voxels in all three directions are therefore close in memory, which
+    /// keeps the cells of a slice of bricks in few pages. Bricks on the upper
+    /// border of the volume are padded.
+    template<class T>
+    requires VoxelType<T>
+    class BrickedVolume
+    {
+    public:
+        using VolumeDataType = T;
+
+        static constexpr int32_t BrickBits = 3;
+        static constexpr int32_t BrickSize = 1 << BrickBits;
+        static constexpr size_t BrickVoxels = size_t(BrickSize) * BrickSize * BrickSize;
+
+        BrickedVolume() = default;
+
+        explicit BrickedVolume(const int3& dimension)
+        {
+            Resize(dimension);
+        }
+
+        /// Copy a dense or strided volume into bricks.
+        explicit BrickedVolume(const VolumeView<VolumeDataType>& volume)
+        {
+            Assign(volume);
+        }
+
+        /// Change the extent of the volume. All voxels are set to 0.
+        void Resize(const int3& dimension)
+        {
+            assert(!(dimension[0] < 0 || dimension[1] < 0 || dimension[2] < 0) && "Dimension is invalid");
+            extent = dimension;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                grid[i] = (dimension[i] + BrickSize - 1) >> BrickBits;
+            }
+            const size_t brickCount = size_t(grid[0]) * size_t(grid[1]) * size_t(grid[2]);
+
+            // rank the bricks by the Morton codes of their grid coordinates
+            std::vector<uint64_t> codes(brickCount);
+            std::vector<uint32_t> order(brickCount);
+            for (size_t brick = 0; brick < brickCount; ++brick)
+            {
+                codes[brick] = GetMortonCode(
+                    uint32_t(brick % size_t(grid[0])),
+                    uint32_t((brick / size_t(grid[0])) % size_t(grid[1])),
+                    uint32_t(brick / (size_t(grid[0]) * size_t(grid[1]))));
+            }
+            std::iota(order.begin(), order.end(), 0u);
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return codes[a] < codes[b]; });
+
+            brickSlots.resize(brickCount);
+            for (size_t slot = 0; slot < brickCount; ++slot)
+            {
+                brickSlots[order[slot]] = uint32_t(slot);
+            }
+            voxels.assign(brickCount * BrickVoxels, VolumeDataType{});
+        }
+
+        /// Replace the volume with a copy of a dense or strided volume.
+        void Assign(const VolumeView<VolumeDataType>& volume)
+        {
+            Resize(volume.extent);
+            for (int32_t z = 0; z < extent[2]; ++z)
+            {
+                for (int32_t y = 0; y < extent[1]; ++y)
+                {
+                    for (int32_t x = 0; x < extent[0]; ++x)
+                    {
+                        (*this)(x, y, z) = volume(x, y, z);
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] const int3& Extent() const noexcept { return extent; }
+
+        /// Number of bricks along each axis.
+        [[nodiscard]] const int3& BrickGrid() const noexcept { return grid; }
+
+        [[nodiscard]] VolumeDataType& operator()(int32_t x, int32_t y, int32_t z) noexcept
+        {
+            return voxels[GetVoxelIndex(x, y, z)];
+        }
+
+        [[nodiscard]] const VolumeDataType& operator()(int32_t x, int32_t y, int32_t z) const noexcept
+        {
+            return voxels[GetVoxelIndex(x, y, z)];
+        }
+
+        /// Copy the voxels [xBegin,xEnd) of the row (y,z) to out. The row is
+        /// walked brick by brick, copying the adjacent voxels of each brick.
+        void CopyRow(int32_t y, int32_t z, int32_t xBegin, int32_t xEnd, VolumeDataType* out) const noexcept
+        {
+            assert(xBegin >= 0 && xEnd <= extent[0] && "Row is outside of the volume");
+            const size_t rowBase = size_t(y & (BrickSize - 1)) * BrickSize + size_t(z & (BrickSize - 1)) * BrickSize * BrickSize;
+            const size_t brickRow = size_t(grid[0]) * (size_t(y >> BrickBits) + size_t(grid[1]) * size_t(z >> BrickBits));
+            for (int32_t x = xBegin; x < xEnd;)
+            {
+                int32_t end = std::min((x | (BrickSize - 1)) + 1, xEnd);
+                const VolumeDataType* brick = &voxels[size_t(brickSlots[brickRow + size_t(x >> BrickBits)]) * BrickVoxels + rowBase];
+                out = std::copy(brick + (x & (BrickSize - 1)), brick + (x & (BrickSize - 1)) + (end - x), out);
+                x = end;
+            }
+        }
+
+        /// Copy the box [begin,begin+size) into a dense x-fastest block. Voxels
+        /// outside of the volume are taken from the closest border voxel, so
+        /// the block can be used as the padded block of a chunk.
+        void CopyBlock(const int3& begin, const int3& size, std::span<VolumeDataType> block) const noexcept
+        {
+            assert(block.size() >= size_t(size[0]) * size_t(size[1]) * size_t(size[2]) && "Block is smaller than the box");
+            assert(!(extent[0] < 1 || extent[1] < 1 || extent[2] < 1) && "Volume is empty");
+            const int32_t xBegin = std::clamp(begin[0], 0, extent[0]);
+            const int32_t xEnd = std::clamp(begin[0] + size[0], xBegin, extent[0]);
+            VolumeDataType* out = block.data();
+            for (int32_t z = 0; z < size[2]; ++z)
+            {
+                const int32_t vz = std::clamp(begin[2] + z, 0, extent[2] - 1);
+                for (int32_t y = 0; y < size[1]; ++y)
+                {
+                    const int32_t vy = std::clamp(begin[1] + y, 0, extent[1] - 1);
+                    int32_t x = 0;
+                    for (; x < size[0] && begin[0] + x < xBegin; ++x)
+                    {
+                        out[x] = (*this)(std::min(xBegin, extent[0] - 1), vy, vz);
+                    }
+                    CopyRow(vy, vz, xBegin, xEnd, out + x);
+                    for (x += xEnd - xBegin; x < size[0]; ++x)
+                    {
+                        out[x] = (*this)(extent[0] - 1, vy, vz);
+                    }
+                    out += size[0];
+                }
+            }
+        }
+
+    private:
+        /// Interleave the bits of the brick coordinates, x in the lowest bit.
+        static uint64_t GetMortonCode(uint32_t x, uint32_t y, uint32_t z) noexcept
+        {
+            auto spread = [](uint64_t v)
+            {
+                v &= 0x1fffff;
+                v = (v | (v << 32)) & 0x1f00000000ffffull;
+                v = (v | (v << 16)) & 0x1f0000ff0000ffull;
+                v = (v | (v << 8)) & 0x100f00f00f00f00full;
+                v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+                v = (v | (v << 2)) & 0x1249249249249249ull;
+                return v;
+            };
+            return spread(x) | (spread(y) << 1) | (spread(z) << 2);
+        }
+
+        size_t GetVoxelIndex(int32_t x, int32_t y, int32_t z) const noexcept
+        {
+            size_t brick = size_t(x >> BrickBits) + size_t(grid[0]) * (size_t(y >> BrickBits) + size_t(grid[1]) * size_t(z >> BrickBits));
+            size_t local = size_t(x & (BrickSize - 1)) + BrickSize * (size_t(y & (BrickSize - 1)) + BrickSize * size_t(z & (BrickSize - 1)));
+            return size_t(brickSlots[brick]) * BrickVoxels + local;
+        }
+
+        int3 extent{0, 0, 0};
+        int3 grid{0, 0, 0};
+        /// position of each brick of the grid in Morton order
+        std::vector<uint32_t> brickSlots;
+        std::vector<VolumeDataType> voxels;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_BRICKED_VOLUME_H_INCLUDED
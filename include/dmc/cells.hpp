@@ -0,0 +1,181 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_CELLS_H_INCLUDED
+#define DUALMC_CELLS_H_INCLUDED
+
+/// \file   cells.hpp
+/// Dual points, gradients and the manifold test of single cells, which are
+/// shared by the meshers. Voxels are read through accessors, so the meshers
+/// keep their own storage of the volume.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+
+// stl includes
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <type_traits>
+
+// dual mc includes
+#include "types.hpp"
+#include "tables.hpp"
+
+namespace dualmc
+{
+    namespace cells
+    {
+        /// axis and origin corner of a cell edge
+        struct EdgeDef
+        {
+            int8_t axis;      // 0=x, 1=y, 2=z
+            int8_t oX, oY, oZ; // Origin coordinates
+        };
+
+        /// Table mapping edge index (0-11), the bit of its DMCEdgeCode, to axis and origin
+        inline constexpr std::array<EdgeDef, 12> edgeTable = {{
+            {0, 0,0,0}, {2, 1,0,0}, {0, 0,0,1}, {2, 0,0,0}, // Edges 0-3
+            {0, 0,1,0}, {2, 1,1,0}, {0, 0,1,1}, {2, 0,1,0}, // Edges 4-7
+            {1, 0,0,0}, {1, 1,0,0}, {1, 1,0,1}, {1, 0,0,1}  // Edges 8-11
+        }};
+
+        /// Number of dual point slots of a cell.
+        inline constexpr int32_t SlotsPerCell = 4;
+
+        /// Type in which the edge intersections of voxels of type T are
+        /// computed. Voxel types wider than float are converted to double, so
+        /// distinct values stay distinct.
+        template<class T>
+        using IntersectionType = std::conditional_t<(sizeof(T) > 2 && !std::is_same_v<T, float>), double, float>;
+
+        /// Get the slot of the dual point of a cube code which belongs to the
+        /// given edge. Its dualPointsList entry is the 12-bit dual point code mask,
+        /// which encodes the traditional marching cube vertices of the traditional
+        /// marching cubes face which corresponds to the dual point.
+        inline int32_t GetDualPointSlot(int32_t cubeCode, tables::DMCEdgeCode edge) noexcept
+        {
+            for (int32_t i = 0; i < SlotsPerCell; ++i)
+            {
+                if (tables::dualPointsList[cubeCode][i] & edge)
+                {
+                    return i;
+                }
+            }
+            assert(false && "Edge is not intersected by the surface");
+            return 0;
+        }
+
+        /// Apply the manifold test to the cube code of a cell in a volume of
+        /// the given extent. neighborCode(cell) returns the cube code of a
+        /// neighboring cell.
+        template<class NeighborCode>
+        int32_t ResolveCellCode(const int3& cell, int32_t cubeCode, const int3& extent, NeighborCode&& neighborCode)
+        {
+            // The Manifold Dual Marching Cubes approach from Rephael Wenger as described in
+            // chapter 3.3.5 of his book "Isosurfaces: Geometry, Topology, and Algorithms"
+            // is implemente here.
+            // If a problematic C16 or C19 configuration shares the ambiguous face
+            // with another C16 or C19 configuration we simply invert the cube code
+            // before looking up dual points. Doing this for these pairs ensures
+            // manifold meshes.
+            // But this removes the dualism to marching cubes.
+
+            // check if we have a potentially problematic configuration
+            uint8_t direction = tables::problematicConfigs[uint8_t(cubeCode)];
+            // If the direction code is in {0,...,5} we have a C16 or C19 configuration.
+            if (direction != 255)
+            {
+                // We have to check the neighboring cube, which shares the ambiguous
+                // face. For this we decode the direction. This could also be done
+                // with another lookup table.
+                // copy current cube coordinates into an array.
+                int3 neighborCoords = cell;
+                // get the dimension of the non-zero coordinate axis
+                uint32_t component = direction >> 1;
+                // get the sign of the direction
+                int32_t delta = (direction & 1) == 1 ? 1 : -1;
+                // modify the correspong cube coordinate
+                neighborCoords[component] += delta;
+                // have we left the volume in this direction?
+                if (neighborCoords[component] >= 0 && neighborCoords[component] < (extent[component] - 1))
+                {
+                    // get the cube configuration of the relevant neighbor
+                    int32_t neighborCubeCode = neighborCode(neighborCoords);
+                    // Look up the neighbor configuration ambiguous face direction.
+                    // If the direction is valid we have a C16 or C19 neighbor.
+                    // As C16 and C19 have exactly one ambiguous face this face is
+                    // guaranteed to be shared for the pair.
+                    if (tables::problematicConfigs[uint8_t(neighborCubeCode)] != 255)
+                    {
+                        // replace the cube configuration with its inverse.
+                        cubeCode ^= 0xff;
+                    }
+                }
+            }
+            return cubeCode;
+        }
+
+        /// Compute the dual point of a cell with the given point code as the
+        /// mean of its edge intersections, relative to the cell. Corner c of
+        /// corners lies at (c & 1, (c >> 1) & 1, c >> 2). intersection(edge, pos, t)
+        /// is called for each intersected edge with the intersection pos at
+        /// parameter t along the edge.
+        template<class Real, class Intersection>
+        float3 CalculateDualPoint(int32_t pointCode, const std::array<Real, 8>& corners, Real iso, Intersection&& intersection)
+        {
+            float3 p{0, 0, 0};
+            int32_t points = 0;
+
+            // visit the intersected edges only
+            for (uint32_t edges = uint32_t(pointCode) & 0xfff; edges != 0; edges &= edges - 1)
+            {
+                const EdgeDef& edge = edgeTable[size_t(std::countr_zero(edges))];
+                const int32_t origin = edge.oX + 2 * edge.oY + 4 * edge.oZ;
+
+                // the corner values differ in their side of the iso value, so
+                // the intersection is in [0,1] without testing for a zero
+                // difference
+                const Real v1 = corners[size_t(origin)];
+                const Real v2 = corners[size_t(origin + (1 << edge.axis))];
+                const float t = static_cast<float>((iso - v1) / (v2 - v1));
+
+                // Base position is the edge origin, offset along the axis
+                float3 pos = {static_cast<float>(edge.oX), static_cast<float>(edge.oY), static_cast<float>(edge.oZ)};
+                pos[edge.axis] += t;
+
+                p = p + pos;
+                points++;
+                intersection(edge, pos, t);
+            }
+
+            // divide by number of accumulated points
+            float invPoints = 1.0f / (float)points;
+            return p * invPoints;
+        }
+
+        /// Get the central difference gradient at a voxel of a volume of the
+        /// given extent, whose values are returned by voxelValue(voxel).
+        /// Differences on the border of the volume are one-sided.
+        template<class VoxelValue>
+        float3 GetVoxelGradient(const int3& voxel, const int3& extent, VoxelValue&& voxelValue)
+        {
+            float3 gradient;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                int3 lower = voxel;
+                int3 upper = voxel;
+                lower[i] = std::max(voxel[i] - 1, 0);
+                upper[i] = std::min(voxel[i] + 1, extent[i] - 1);
+                gradient[i] = (static_cast<float>(voxelValue(upper)) - static_cast<float>(voxelValue(lower))) / static_cast<float>(upper[i] - lower[i]);
+            }
+            return gradient;
+        }
+
+    } // END: namespace cells
+
+} // END: namespace dualmc
+#endif // DUALMC_CELLS_H_INCLUDED
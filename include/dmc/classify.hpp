@@ -0,0 +1,793 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_CLASSIFY_H_INCLUDED
+#define DUALMC_CLASSIFY_H_INCLUDED
+
+/// \file   classify.hpp
+/// Vectorized inside/outside classification kernels used by the mesher.
+/// A row of voxels is turned into a mask with one byte per voxel, which is 1
+/// for voxels inside the surface (value >= iso) and 0 otherwise. The cube
+/// codes of a row of cells are assembled from the masks of the four voxel rows
+/// holding the cell corners.
+/// The kernel is selected at compile time by the voxel type and at runtime by
+/// the available instruction sets. Define DUALMC_NO_SIMD to only use the
+/// scalar kernels.
+/// Signed 16-bit and half precision voxels are classified by their sign bit
+/// for an iso value of 0, which is the surface of signed distance fields.
+/// Half precision voxels are compared as integers, so they need no
+/// conversion instructions.
+
+// c includes
+#include <cstdint>
+#include <cstddef>
+
+// stl includes
+#include <type_traits>
+#include <bit>
+
+// dual mc includes
+#include "types.hpp"
+
+#if !defined(DUALMC_NO_SIMD)
+    #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+        #define DUALMC_X86 1
+        #include <immintrin.h>
+        #if defined(_MSC_VER) && !defined(__clang__)
+            #include <intrin.h>
+        #endif
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define DUALMC_NEON 1
+        #include <arm_neon.h>
+    #endif
+#endif
+
+// GCC and Clang need the instruction sets of a kernel enabled per function.
+#if defined(DUALMC_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define DUALMC_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define DUALMC_TARGET(isa)
+#endif
+
+namespace dualmc
+{
+namespace kernels
+{
+    /// Instruction sets with a dedicated kernel implementation.
+    enum class InstructionSet : uint8_t { Scalar, SSE2, AVX2, AVX512, NEON };
+
+    /// Determine the best instruction set supported by the executing CPU.
+    inline InstructionSet DetectInstructionSet() noexcept
+    {
+#if defined(DUALMC_X86)
+    #if defined(__GNUC__) || defined(__clang__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl"))
+            return InstructionSet::AVX512;
+        if (__builtin_cpu_supports("avx2"))
+            return InstructionSet::AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return InstructionSet::SSE2;
+    #elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        // the OS has to save the AVX register state
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+        if (maxLeaf >= 7 && (xcr0 & 0x6) == 0x6)
+        {
+            __cpuidex(info, 7, 0);
+            const bool avx2 = (info[1] & (1 << 5)) != 0;
+            const bool avx512 = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0 && (info[1] & (1 << 31)) != 0;
+            if (avx512 && (xcr0 & 0xe0) == 0xe0)
+                return InstructionSet::AVX512;
+            if (avx2)
+                return InstructionSet::AVX2;
+        }
+        if (sse2)
+            return InstructionSet::SSE2;
+    #endif
+        return InstructionSet::Scalar;
+#elif defined(DUALMC_NEON)
+        return InstructionSet::NEON;
+#else
+        return InstructionSet::Scalar;
+#endif
+    }
+
+    /// The instruction set used by the kernels, detected once.
+    inline InstructionSet ActiveInstructionSet() noexcept
+    {
+        static const InstructionSet instructionSet = DetectInstructionSet();
+        return instructionSet;
+    }
+
+    /// Voxel types with vectorized classification kernels.
+    template<class T>
+    inline constexpr bool HasVectorizedClassification =
+        std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t> || std::is_same_v<T, int16_t> ||
+        std::is_same_v<T, float> || std::is_same_v<T, double> || IsHalf<T>;
+
+    namespace detail
+    {
+        /// Bits of a half precision float mapped to a signed integer with the
+        /// order of the values: the magnitude, negated for negative values.
+        /// Both zeros map to 0.
+        constexpr int16_t HalfKey(uint16_t bits) noexcept
+        {
+            const int32_t magnitude = bits & 0x7fff;
+            return static_cast<int16_t>((bits & 0x8000) != 0 ? -magnitude : magnitude);
+        }
+
+        /// Bits of half precision NaNs are above the infinity once the sign is
+        /// cleared.
+        inline constexpr uint16_t HalfInfinityBits = 0x7c00;
+        inline constexpr uint16_t HalfNegativeZeroBits = 0x8000;
+
+        template<class T>
+        inline void ClassifyRowScalar(const T* row, size_t count, T iso, uint8_t* inside, size_t x = 0) noexcept
+        {
+            for (; x < count; ++x)
+            {
+                inside[x] = row[x] >= iso ? 1 : 0;
+            }
+        }
+
+        inline void AssembleCubeCodesScalar(
+            const uint8_t* lower0, const uint8_t* upper0,
+            const uint8_t* lower1, const uint8_t* upper1,
+            size_t count, uint8_t* codes, size_t x = 0) noexcept
+        {
+            for (; x < count; ++x)
+            {
+                codes[x] = static_cast<uint8_t>(
+                    lower0[x] | (lower0[x + 1] << 1) | (upper0[x] << 2) | (upper0[x + 1] << 3) |
+                    (lower1[x] << 4) | (lower1[x + 1] << 5) | (upper1[x] << 6) | (upper1[x + 1] << 7));
+            }
+        }
+
+#if defined(DUALMC_X86)
+        /// Mask of the half precision voxels v >= 0 for the bits of a vector:
+        /// the sign bit is clear and v is no NaN, or v is -0.
+        DUALMC_TARGET("sse2")
+        inline __m128i HalfNonNegativeSSE2(__m128i v, __m128i infinity, __m128i negativeZero) noexcept
+        {
+            __m128i positive = _mm_cmpeq_epi16(_mm_subs_epu16(v, infinity), _mm_setzero_si128());
+            return _mm_or_si128(positive, _mm_cmpeq_epi16(v, negativeZero));
+        }
+
+        /// Mask of the half precision voxels v < iso or NaN, given the key of iso.
+        DUALMC_TARGET("sse2")
+        inline __m128i HalfBelowSSE2(__m128i v, __m128i threshold, __m128i infinity) noexcept
+        {
+            __m128i magnitude = _mm_and_si128(v, _mm_set1_epi16(0x7fff));
+            __m128i sign = _mm_srai_epi16(v, 15);
+            __m128i key = _mm_sub_epi16(_mm_xor_si128(magnitude, sign), sign);
+            return _mm_or_si128(_mm_cmplt_epi16(key, threshold), _mm_cmpgt_epi16(magnitude, infinity));
+        }
+
+        /// Masks of p[i] >= iso for four doubles as 32-bit lanes, keeping the low
+        /// halves of the 64-bit comparison masks.
+        DUALMC_TARGET("sse2")
+        inline __m128i CompareDoubleSSE2(const double* p, __m128d threshold) noexcept
+        {
+            __m128 a = _mm_castpd_ps(_mm_cmpge_pd(_mm_loadu_pd(p), threshold));
+            __m128 b = _mm_castpd_ps(_mm_cmpge_pd(_mm_loadu_pd(p + 2), threshold));
+            return _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+
+        DUALMC_TARGET("avx2")
+        inline __m256i HalfNonNegativeAVX2(__m256i v, __m256i infinity, __m256i negativeZero) noexcept
+        {
+            __m256i positive = _mm256_cmpeq_epi16(_mm256_subs_epu16(v, infinity), _mm256_setzero_si256());
+            return _mm256_or_si256(positive, _mm256_cmpeq_epi16(v, negativeZero));
+        }
+
+        DUALMC_TARGET("avx2")
+        inline __m256i HalfBelowAVX2(__m256i v, __m256i threshold, __m256i infinity) noexcept
+        {
+            __m256i magnitude = _mm256_and_si256(v, _mm256_set1_epi16(0x7fff));
+            __m256i sign = _mm256_srai_epi16(v, 15);
+            __m256i key = _mm256_sub_epi16(_mm256_xor_si256(magnitude, sign), sign);
+            return _mm256_or_si256(_mm256_cmpgt_epi16(threshold, key), _mm256_cmpgt_epi16(magnitude, infinity));
+        }
+
+        // SSE2 is part of x86-64, so these kernels are also used for the
+        // remainders of the wider ones.
+        template<class T>
+        DUALMC_TARGET("sse2")
+        inline size_t ClassifyRowSSE2(const T* row, size_t count, T iso, uint8_t* inside) noexcept
+        {
+            const __m128i ones = _mm_set1_epi8(1);
+            size_t x = 0;
+            if constexpr (std::is_same_v<T, uint8_t>)
+            {
+                // v >= iso <=> saturate(iso - v) == 0
+                const __m128i threshold = _mm_set1_epi8(static_cast<char>(iso));
+                for (; x + 16 <= count; x += 16)
+                {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                    __m128i mask = _mm_cmpeq_epi8(_mm_subs_epu8(threshold, v), _mm_setzero_si128());
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_and_si128(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, uint16_t>)
+            {
+                const __m128i threshold = _mm_set1_epi16(static_cast<short>(iso));
+                for (; x + 16 <= count; x += 16)
+                {
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 8));
+                    __m128i maskA = _mm_cmpeq_epi16(_mm_subs_epu16(threshold, a), _mm_setzero_si128());
+                    __m128i maskB = _mm_cmpeq_epi16(_mm_subs_epu16(threshold, b), _mm_setzero_si128());
+                    __m128i mask = _mm_packs_epi16(maskA, maskB);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_and_si128(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, int16_t>)
+            {
+                if (iso == 0)
+                {
+                    // the saturating pack keeps the sign bits
+                    const __m128i minusOne = _mm_set1_epi8(-1);
+                    for (; x + 16 <= count; x += 16)
+                    {
+                        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 8));
+                        __m128i mask = _mm_cmpgt_epi8(_mm_packs_epi16(a, b), minusOne);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_and_si128(mask, ones));
+                    }
+                }
+                else
+                {
+                    const __m128i threshold = _mm_set1_epi16(iso);
+                    for (; x + 16 <= count; x += 16)
+                    {
+                        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 8));
+                        __m128i outside = _mm_packs_epi16(_mm_cmplt_epi16(a, threshold), _mm_cmplt_epi16(b, threshold));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_andnot_si128(outside, ones));
+                    }
+                }
+            }
+            else if constexpr (IsHalf<T>)
+            {
+                const uint16_t isoBits = std::bit_cast<uint16_t>(iso);
+                if ((isoBits & 0x7fff) > HalfInfinityBits)
+                    return 0;
+                const __m128i infinity = _mm_set1_epi16(static_cast<short>(HalfInfinityBits));
+                if ((isoBits & 0x7fff) == 0)
+                {
+                    // v >= 0 <=> the sign bit is clear and v is no NaN, or v is -0
+                    const __m128i negativeZero = _mm_set1_epi16(static_cast<short>(HalfNegativeZeroBits));
+                    for (; x + 16 <= count; x += 16)
+                    {
+                        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 8));
+                        __m128i mask = _mm_packs_epi16(HalfNonNegativeSSE2(a, infinity, negativeZero), HalfNonNegativeSSE2(b, infinity, negativeZero));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_and_si128(mask, ones));
+                    }
+                }
+                else
+                {
+                    // v < iso <=> key(v) < key(iso), and NaN voxels are outside
+                    const __m128i threshold = _mm_set1_epi16(HalfKey(isoBits));
+                    for (; x + 16 <= count; x += 16)
+                    {
+                        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 8));
+                        __m128i mask = _mm_packs_epi16(HalfBelowSSE2(a, threshold, infinity), HalfBelowSSE2(b, threshold, infinity));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_andnot_si128(mask, ones));
+                    }
+                }
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                const __m128d threshold = _mm_set1_pd(iso);
+                auto compare = CompareDoubleSSE2;
+                for (; x + 16 <= count; x += 16)
+                {
+                    __m128i ab = _mm_packs_epi32(compare(row + x, threshold), compare(row + x + 4, threshold));
+                    __m128i cd = _mm_packs_epi32(compare(row + x + 8, threshold), compare(row + x + 12, threshold));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_and_si128(_mm_packs_epi16(ab, cd), ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, float>)
+            {
+                const __m128 threshold = _mm_set1_ps(iso);
+                for (; x + 16 <= count; x += 16)
+                {
+                    __m128i a = _mm_castps_si128(_mm_cmpge_ps(_mm_loadu_ps(row + x), threshold));
+                    __m128i b = _mm_castps_si128(_mm_cmpge_ps(_mm_loadu_ps(row + x + 4), threshold));
+                    __m128i c = _mm_castps_si128(_mm_cmpge_ps(_mm_loadu_ps(row + x + 8), threshold));
+                    __m128i d = _mm_castps_si128(_mm_cmpge_ps(_mm_loadu_ps(row + x + 12), threshold));
+                    __m128i mask = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_and_si128(mask, ones));
+                }
+            }
+            return x;
+        }
+
+        template<class T>
+        DUALMC_TARGET("avx2")
+        inline size_t ClassifyRowAVX2(const T* row, size_t count, T iso, uint8_t* inside) noexcept
+        {
+            const __m256i ones = _mm256_set1_epi8(1);
+            size_t x = 0;
+            if constexpr (std::is_same_v<T, uint8_t>)
+            {
+                const __m256i threshold = _mm256_set1_epi8(static_cast<char>(iso));
+                for (; x + 32 <= count; x += 32)
+                {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+                    __m256i mask = _mm256_cmpeq_epi8(_mm256_subs_epu8(threshold, v), _mm256_setzero_si256());
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_and_si256(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, uint16_t>)
+            {
+                const __m256i threshold = _mm256_set1_epi16(static_cast<short>(iso));
+                for (; x + 32 <= count; x += 32)
+                {
+                    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+                    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x + 16));
+                    __m256i maskA = _mm256_cmpeq_epi16(_mm256_subs_epu16(threshold, a), _mm256_setzero_si256());
+                    __m256i maskB = _mm256_cmpeq_epi16(_mm256_subs_epu16(threshold, b), _mm256_setzero_si256());
+                    // packing works per 128-bit lane, restore the voxel order afterwards
+                    __m256i mask = _mm256_permute4x64_epi64(_mm256_packs_epi16(maskA, maskB), 0xd8);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_and_si256(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, int16_t>)
+            {
+                if (iso == 0)
+                {
+                    const __m256i minusOne = _mm256_set1_epi8(-1);
+                    for (; x + 32 <= count; x += 32)
+                    {
+                        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+                        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x + 16));
+                        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xd8);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_and_si256(_mm256_cmpgt_epi8(packed, minusOne), ones));
+                    }
+                }
+                else
+                {
+                    const __m256i threshold = _mm256_set1_epi16(iso);
+                    for (; x + 32 <= count; x += 32)
+                    {
+                        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+                        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x + 16));
+                        __m256i outside = _mm256_packs_epi16(_mm256_cmpgt_epi16(threshold, a), _mm256_cmpgt_epi16(threshold, b));
+                        outside = _mm256_permute4x64_epi64(outside, 0xd8);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_andnot_si256(outside, ones));
+                    }
+                }
+            }
+            else if constexpr (IsHalf<T>)
+            {
+                const uint16_t isoBits = std::bit_cast<uint16_t>(iso);
+                if ((isoBits & 0x7fff) > HalfInfinityBits)
+                    return 0;
+                const __m256i infinity = _mm256_set1_epi16(static_cast<short>(HalfInfinityBits));
+                if ((isoBits & 0x7fff) == 0)
+                {
+                    const __m256i negativeZero = _mm256_set1_epi16(static_cast<short>(HalfNegativeZeroBits));
+                    for (; x + 32 <= count; x += 32)
+                    {
+                        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+                        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x + 16));
+                        __m256i mask = _mm256_packs_epi16(HalfNonNegativeAVX2(a, infinity, negativeZero), HalfNonNegativeAVX2(b, infinity, negativeZero));
+                        mask = _mm256_permute4x64_epi64(mask, 0xd8);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_and_si256(mask, ones));
+                    }
+                }
+                else
+                {
+                    const __m256i threshold = _mm256_set1_epi16(HalfKey(isoBits));
+                    for (; x + 32 <= count; x += 32)
+                    {
+                        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+                        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x + 16));
+                        __m256i mask = _mm256_packs_epi16(HalfBelowAVX2(a, threshold, infinity), HalfBelowAVX2(b, threshold, infinity));
+                        mask = _mm256_permute4x64_epi64(mask, 0xd8);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_andnot_si256(mask, ones));
+                    }
+                }
+            }
+            else if constexpr (std::is_same_v<T, float>)
+            {
+                const __m256 threshold = _mm256_set1_ps(iso);
+                const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+                for (; x + 32 <= count; x += 32)
+                {
+                    __m256i a = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(row + x), threshold, _CMP_GE_OQ));
+                    __m256i b = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(row + x + 8), threshold, _CMP_GE_OQ));
+                    __m256i c = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(row + x + 16), threshold, _CMP_GE_OQ));
+                    __m256i d = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(row + x + 24), threshold, _CMP_GE_OQ));
+                    __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+                    __m256i mask = _mm256_permutevar8x32_epi32(packed, order);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_and_si256(mask, ones));
+                }
+            }
+            return x;
+        }
+
+        template<class T>
+        DUALMC_TARGET("avx512f,avx512bw,avx512vl")
+        inline size_t ClassifyRowAVX512(const T* row, size_t count, T iso, uint8_t* inside) noexcept
+        {
+            size_t x = 0;
+            if constexpr (std::is_same_v<T, uint8_t>)
+            {
+                const __m512i ones = _mm512_set1_epi8(1);
+                const __m512i threshold = _mm512_set1_epi8(static_cast<char>(iso));
+                for (; x + 64 <= count; x += 64)
+                {
+                    __mmask64 mask = _mm512_cmpge_epu8_mask(_mm512_loadu_si512(row + x), threshold);
+                    _mm512_storeu_si512(inside + x, _mm512_maskz_mov_epi8(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, uint16_t>)
+            {
+                const __m256i ones = _mm256_set1_epi8(1);
+                const __m512i threshold = _mm512_set1_epi16(static_cast<short>(iso));
+                for (; x + 32 <= count; x += 32)
+                {
+                    __mmask32 mask = _mm512_cmpge_epu16_mask(_mm512_loadu_si512(row + x), threshold);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_maskz_mov_epi8(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, int16_t>)
+            {
+                const __m256i ones = _mm256_set1_epi8(1);
+                if (iso == 0)
+                {
+                    for (; x + 32 <= count; x += 32)
+                    {
+                        __mmask32 negative = _mm512_movepi16_mask(_mm512_loadu_si512(row + x));
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_maskz_mov_epi8(~negative, ones));
+                    }
+                }
+                else
+                {
+                    const __m512i threshold = _mm512_set1_epi16(iso);
+                    for (; x + 32 <= count; x += 32)
+                    {
+                        __mmask32 mask = _mm512_cmpge_epi16_mask(_mm512_loadu_si512(row + x), threshold);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_maskz_mov_epi8(mask, ones));
+                    }
+                }
+            }
+            else if constexpr (IsHalf<T>)
+            {
+                const uint16_t isoBits = std::bit_cast<uint16_t>(iso);
+                if ((isoBits & 0x7fff) > HalfInfinityBits)
+                    return 0;
+                const __m256i ones = _mm256_set1_epi8(1);
+                const __m512i infinity = _mm512_set1_epi16(static_cast<short>(HalfInfinityBits));
+                if ((isoBits & 0x7fff) == 0)
+                {
+                    const __m512i negativeZero = _mm512_set1_epi16(static_cast<short>(HalfNegativeZeroBits));
+                    for (; x + 32 <= count; x += 32)
+                    {
+                        __m512i v = _mm512_loadu_si512(row + x);
+                        __mmask32 mask = _mm512_cmple_epu16_mask(v, infinity) | _mm512_cmpeq_epi16_mask(v, negativeZero);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_maskz_mov_epi8(mask, ones));
+                    }
+                }
+                else
+                {
+                    const __m512i threshold = _mm512_set1_epi16(HalfKey(isoBits));
+                    const __m512i magnitudeMask = _mm512_set1_epi16(0x7fff);
+                    for (; x + 32 <= count; x += 32)
+                    {
+                        __m512i v = _mm512_loadu_si512(row + x);
+                        __m512i magnitude = _mm512_and_si512(v, magnitudeMask);
+                        __m512i key = _mm512_mask_sub_epi16(magnitude, _mm512_movepi16_mask(v), _mm512_setzero_si512(), magnitude);
+                        __mmask32 mask = _mm512_mask_cmpge_epi16_mask(_mm512_cmple_epi16_mask(magnitude, infinity), key, threshold);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(inside + x), _mm256_maskz_mov_epi8(mask, ones));
+                    }
+                }
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                const __m128i ones = _mm_set1_epi8(1);
+                const __m512d threshold = _mm512_set1_pd(iso);
+                for (; x + 8 <= count; x += 8)
+                {
+                    __mmask8 mask = _mm512_cmp_pd_mask(_mm512_loadu_pd(row + x), threshold, _CMP_GE_OQ);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(inside + x), _mm_maskz_mov_epi8(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, float>)
+            {
+                const __m128i ones = _mm_set1_epi8(1);
+                const __m512 threshold = _mm512_set1_ps(iso);
+                for (; x + 16 <= count; x += 16)
+                {
+                    __mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(row + x), threshold, _CMP_GE_OQ);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(inside + x), _mm_maskz_mov_epi8(mask, ones));
+                }
+            }
+            return x;
+        }
+
+        DUALMC_TARGET("sse2")
+        inline __m128i LoadSSE2(const uint8_t* p) noexcept
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        }
+
+        DUALMC_TARGET("avx2")
+        inline __m256i LoadAVX2(const uint8_t* p) noexcept
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        }
+
+        // The masks hold 0 or 1 per byte, so shifting 16-bit lanes by at most
+        // seven bits never moves a bit into the neighboring byte.
+        DUALMC_TARGET("sse2")
+        inline size_t AssembleCubeCodesSSE2(
+            const uint8_t* lower0, const uint8_t* upper0,
+            const uint8_t* lower1, const uint8_t* upper1,
+            size_t count, uint8_t* codes) noexcept
+        {
+            auto load = LoadSSE2;
+            size_t x = 0;
+            for (; x + 16 <= count; x += 16)
+            {
+                __m128i code = _mm_or_si128(load(lower0 + x), _mm_slli_epi16(load(lower0 + x + 1), 1));
+                code = _mm_or_si128(code, _mm_slli_epi16(load(upper0 + x), 2));
+                code = _mm_or_si128(code, _mm_slli_epi16(load(upper0 + x + 1), 3));
+                code = _mm_or_si128(code, _mm_slli_epi16(load(lower1 + x), 4));
+                code = _mm_or_si128(code, _mm_slli_epi16(load(lower1 + x + 1), 5));
+                code = _mm_or_si128(code, _mm_slli_epi16(load(upper1 + x), 6));
+                code = _mm_or_si128(code, _mm_slli_epi16(load(upper1 + x + 1), 7));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(codes + x), code);
+            }
+            return x;
+        }
+
+        DUALMC_TARGET("avx2")
+        inline size_t AssembleCubeCodesAVX2(
+            const uint8_t* lower0, const uint8_t* upper0,
+            const uint8_t* lower1, const uint8_t* upper1,
+            size_t count, uint8_t* codes) noexcept
+        {
+            auto load = LoadAVX2;
+            size_t x = 0;
+            for (; x + 32 <= count; x += 32)
+            {
+                __m256i code = _mm256_or_si256(load(lower0 + x), _mm256_slli_epi16(load(lower0 + x + 1), 1));
+                code = _mm256_or_si256(code, _mm256_slli_epi16(load(upper0 + x), 2));
+                code = _mm256_or_si256(code, _mm256_slli_epi16(load(upper0 + x + 1), 3));
+                code = _mm256_or_si256(code, _mm256_slli_epi16(load(lower1 + x), 4));
+                code = _mm256_or_si256(code, _mm256_slli_epi16(load(lower1 + x + 1), 5));
+                code = _mm256_or_si256(code, _mm256_slli_epi16(load(upper1 + x), 6));
+                code = _mm256_or_si256(code, _mm256_slli_epi16(load(upper1 + x + 1), 7));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(codes + x), code);
+            }
+            return x;
+        }
+#endif // DUALMC_X86
+
+#if defined(DUALMC_NEON)
+        template<class T>
+        inline size_t ClassifyRowNEON(const T* row, size_t count, T iso, uint8_t* inside) noexcept
+        {
+            const uint8x16_t ones = vdupq_n_u8(1);
+            size_t x = 0;
+            if constexpr (std::is_same_v<T, uint8_t>)
+            {
+                const uint8x16_t threshold = vdupq_n_u8(iso);
+                for (; x + 16 <= count; x += 16)
+                {
+                    uint8x16_t mask = vcgeq_u8(vld1q_u8(row + x), threshold);
+                    vst1q_u8(inside + x, vandq_u8(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, uint16_t>)
+            {
+                const uint16x8_t threshold = vdupq_n_u16(iso);
+                for (; x + 16 <= count; x += 16)
+                {
+                    uint16x8_t a = vcgeq_u16(vld1q_u16(row + x), threshold);
+                    uint16x8_t b = vcgeq_u16(vld1q_u16(row + x + 8), threshold);
+                    uint8x16_t mask = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+                    vst1q_u8(inside + x, vandq_u8(mask, ones));
+                }
+            }
+            else if constexpr (std::is_same_v<T, int16_t>)
+            {
+                if (iso == 0)
+                {
+                    // inside voxels have a clear sign bit
+                    for (; x + 16 <= count; x += 16)
+                    {
+                        uint16x8_t a = vshrq_n_u16(vreinterpretq_u16_s16(vld1q_s16(row + x)), 15);
+                        uint16x8_t b = vshrq_n_u16(vreinterpretq_u16_s16(vld1q_s16(row + x + 8)), 15);
+                        vst1q_u8(inside + x, veorq_u8(vcombine_u8(vmovn_u16(a), vmovn_u16(b)), ones));
+                    }
+                }
+                else
+                {
+                    const int16x8_t threshold = vdupq_n_s16(iso);
+                    for (; x + 16 <= count; x += 16)
+                    {
+                        uint16x8_t a = vcgeq_s16(vld1q_s16(row + x), threshold);
+                        uint16x8_t b = vcgeq_s16(vld1q_s16(row + x + 8), threshold);
+                        uint8x16_t mask = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+                        vst1q_u8(inside + x, vandq_u8(mask, ones));
+                    }
+                }
+            }
+            else if constexpr (IsHalf<T>)
+            {
+                const uint16_t isoBits = std::bit_cast<uint16_t>(iso);
+                if ((isoBits & 0x7fff) > HalfInfinityBits)
+                    return 0;
+                const uint16_t* bits = reinterpret_cast<const uint16_t*>(row);
+                const uint16x8_t infinity = vdupq_n_u16(HalfInfinityBits);
+                if ((isoBits & 0x7fff) == 0)
+                {
+                    const uint16x8_t negativeZero = vdupq_n_u16(HalfNegativeZeroBits);
+                    for (; x + 16 <= count; x += 16)
+                    {
+                        uint16x8_t a = vld1q_u16(bits + x);
+                        uint16x8_t b = vld1q_u16(bits + x + 8);
+                        a = vorrq_u16(vcleq_u16(a, infinity), vceqq_u16(a, negativeZero));
+                        b = vorrq_u16(vcleq_u16(b, infinity), vceqq_u16(b, negativeZero));
+                        uint8x16_t mask = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+                        vst1q_u8(inside + x, vandq_u8(mask, ones));
+                    }
+                }
+                else
+                {
+                    const int16x8_t threshold = vdupq_n_s16(HalfKey(isoBits));
+                    const uint16x8_t magnitudeMask = vdupq_n_u16(0x7fff);
+                    auto classify = [&](uint16x8_t v)
+                    {
+                        uint16x8_t magnitude = vandq_u16(v, magnitudeMask);
+                        int16x8_t key = vreinterpretq_s16_u16(magnitude);
+                        key = vbslq_s16(vcltq_s16(vreinterpretq_s16_u16(v), vdupq_n_s16(0)), vnegq_s16(key), key);
+                        return vandq_u16(vcgeq_s16(key, threshold), vcleq_u16(magnitude, infinity));
+                    };
+                    for (; x + 16 <= count; x += 16)
+                    {
+                        uint16x8_t a = classify(vld1q_u16(bits + x));
+                        uint16x8_t b = classify(vld1q_u16(bits + x + 8));
+                        uint8x16_t mask = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+                        vst1q_u8(inside + x, vandq_u8(mask, ones));
+                    }
+                }
+            }
+#if defined(__aarch64__)
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                const float64x2_t threshold = vdupq_n_f64(iso);
+                for (; x + 8 <= count; x += 8)
+                {
+                    uint32x4_t ab = vcombine_u32(
+                        vmovn_u64(vcgeq_f64(vld1q_f64(row + x), threshold)),
+                        vmovn_u64(vcgeq_f64(vld1q_f64(row + x + 2), threshold)));
+                    uint32x4_t cd = vcombine_u32(
+                        vmovn_u64(vcgeq_f64(vld1q_f64(row + x + 4), threshold)),
+                        vmovn_u64(vcgeq_f64(vld1q_f64(row + x + 6), threshold)));
+                    uint8x8_t mask = vmovn_u16(vcombine_u16(vmovn_u32(ab), vmovn_u32(cd)));
+                    vst1_u8(inside + x, vand_u8(mask, vget_low_u8(ones)));
+                }
+            }
+#endif
+            else if constexpr (std::is_same_v<T, float>)
+            {
+                const float32x4_t threshold = vdupq_n_f32(iso);
+                for (; x + 16 <= count; x += 16)
+                {
+                    uint16x8_t ab = vcombine_u16(
+                        vmovn_u32(vcgeq_f32(vld1q_f32(row + x), threshold)),
+                        vmovn_u32(vcgeq_f32(vld1q_f32(row + x + 4), threshold)));
+                    uint16x8_t cd = vcombine_u16(
+                        vmovn_u32(vcgeq_f32(vld1q_f32(row + x + 8), threshold)),
+                        vmovn_u32(vcgeq_f32(vld1q_f32(row + x + 12), threshold)));
+                    uint8x16_t mask = vcombine_u8(vmovn_u16(ab), vmovn_u16(cd));
+                    vst1q_u8(inside + x, vandq_u8(mask, ones));
+                }
+            }
+            return x;
+        }
+
+        inline size_t AssembleCubeCodesNEON(
+            const uint8_t* lower0, const uint8_t* upper0,
+            const uint8_t* lower1, const uint8_t* upper1,
+            size_t count, uint8_t* codes) noexcept
+        {
+            size_t x = 0;
+            for (; x + 16 <= count; x += 16)
+            {
+                uint8x16_t code = vorrq_u8(vld1q_u8(lower0 + x), vshlq_n_u8(vld1q_u8(lower0 + x + 1), 1));
+                code = vorrq_u8(code, vshlq_n_u8(vld1q_u8(upper0 + x), 2));
+                code = vorrq_u8(code, vshlq_n_u8(vld1q_u8(upper0 + x + 1), 3));
+                code = vorrq_u8(code, vshlq_n_u8(vld1q_u8(lower1 + x), 4));
+                code = vorrq_u8(code, vshlq_n_u8(vld1q_u8(lower1 + x + 1), 5));
+                code = vorrq_u8(code, vshlq_n_u8(vld1q_u8(upper1 + x), 6));
+                code = vorrq_u8(code, vshlq_n_u8(vld1q_u8(upper1 + x + 1), 7));
+                vst1q_u8(codes + x, code);
+            }
+            return x;
+        }
+#endif // DUALMC_NEON
+    } // END: namespace detail
+
+    /// Set inside[x] to 1 if row[x] >= iso and to 0 otherwise for x in [0,count)
+    /// using the kernel of the given instruction set.
+    template<class T>
+    inline void ClassifyRow(InstructionSet instructionSet, const T* row, size_t count, T iso, uint8_t* inside) noexcept
+    {
+        size_t x = 0;
+        if constexpr (HasVectorizedClassification<T>)
+        {
+#if defined(DUALMC_X86)
+            if (instructionSet == InstructionSet::AVX512)
+                x = detail::ClassifyRowAVX512(row, count, iso, inside);
+            else if (instructionSet == InstructionSet::AVX2)
+                x = detail::ClassifyRowAVX2(row, count, iso, inside);
+            if (instructionSet != InstructionSet::Scalar)
+                x += detail::ClassifyRowSSE2(row + x, count - x, iso, inside + x);
+#elif defined(DUALMC_NEON)
+            if (instructionSet == InstructionSet::NEON)
+                x = detail::ClassifyRowNEON(row, count, iso, inside);
+#endif
+        }
+        (void)instructionSet;
+        detail::ClassifyRowScalar(row, count, iso, inside, x);
+    }
+
+    /// Classify a voxel row with the kernel of the active instruction set.
+    template<class T>
+    inline void ClassifyRow(const T* row, size_t count, T iso, uint8_t* inside) noexcept
+    {
+        ClassifyRow(ActiveInstructionSet(), row, count, iso, inside);
+    }
+
+    /// Assemble the cube codes of count cells from the inside masks of the voxel
+    /// rows (y,z), (y+1,z), (y,z+1) and (y+1,z+1), which hold count + 1 voxels,
+    /// using the kernel of the given instruction set.
+    inline void AssembleCubeCodes(
+        InstructionSet instructionSet,
+        const uint8_t* lower0, const uint8_t* upper0,
+        const uint8_t* lower1, const uint8_t* upper1,
+        size_t count, uint8_t* codes) noexcept
+    {
+        size_t x = 0;
+#if defined(DUALMC_X86)
+        if (instructionSet == InstructionSet::AVX512 || instructionSet == InstructionSet::AVX2)
+            x = detail::AssembleCubeCodesAVX2(lower0, upper0, lower1, upper1, count, codes);
+        if (instructionSet != InstructionSet::Scalar)
+            x += detail::AssembleCubeCodesSSE2(lower0 + x, upper0 + x, lower1 + x, upper1 + x, count - x, codes + x);
+#elif defined(DUALMC_NEON)
+        if (instructionSet == InstructionSet::NEON)
+            x = detail::AssembleCubeCodesNEON(lower0, upper0, lower1, upper1, count, codes);
+#endif
+        (void)instructionSet;
+        detail::AssembleCubeCodesScalar(lower0, upper0, lower1, upper1, count, codes, x);
+    }
+
+    /// Assemble cube codes with the kernel of the active instruction set.
+    inline void AssembleCubeCodes(
+        const uint8_t* lower0, const uint8_t* upper0,
+        const uint8_t* lower1, const uint8_t* upper1,
+        size_t count, uint8_t* codes) noexcept
+    {
+        AssembleCubeCodes(ActiveInstructionSet(), lower0, upper0, lower1, upper1, count, codes);
+    }
+
+} // END: namespace kernels
+} // END: namespace dualmc
+
+#endif // DUALMC_CLASSIFY_H_INCLUDED
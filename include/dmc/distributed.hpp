@@ -0,0 +1,361 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_DISTRIBUTED_H_INCLUDED
+#define DUALMC_DISTRIBUTED_H_INCLUDED
+
+/// \file   distributed.hpp
+/// Extraction of domain-decomposed volumes, e.g. of the ranks of an MPI job,
+/// into mesh pieces with global vertex indices. The exchange of the pieces
+/// and seams between the ranks is left to the transport of the application.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+
+// stl includes
+#include <vector>
+#include <span>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    /// \class  DistributedMesher
+    /// Extracts the surface of a volume, which is split into subdomains of
+    /// cells, e.g. one per rank of a distributed simulation. Each subdomain is
+    /// extracted from its voxels and a ghost layer with Mesher::BuildSubdomain,
+    /// so its faces and vertices are the ones of Build on the whole volume.
+    /// A piece holds the vertices of the dual points of its cells first, in
+    /// the order of extraction, followed by the ghosts of the dual points of
+    /// neighbors, which its faces reference. The global index of an owned
+    /// vertex is its index plus the number of owned vertices of the pieces
+    /// before it, e.g. of the lower ranks, so global indices only depend on
+    /// the decomposition. Ghosts either are resolved to the global indices of
+    /// their owners from the seams of the neighbors, which gives the pieces
+    /// and a stitching index, or removed by merging the pieces.
+    template<class T, MeshIndex I = uint32_t>
+    requires VoxelType<T>
+    class DistributedMesher
+    {
+    public:
+        using VolumeDataType = T;
+        using IndexType = I;
+        using MeshType = BasicMesh<IndexType>;
+
+        /// Mesh of the faces of the cells in [cellBegin,cellEnd). keys identify
+        /// the dual points of the vertices in the whole volume, vertices
+        /// [0,ownedCount) are the dual points of cells of the piece.
+        struct Piece
+        {
+            MeshType mesh;
+            std::vector<uint64_t> keys;
+            size_t ownedCount = 0;
+            int3 cellBegin{0, 0, 0};
+            int3 cellEnd{0, 0, 0};
+        };
+
+        /// Owned vertex of a piece, which may be a ghost of its neighbors.
+        struct SeamVertex
+        {
+            uint64_t key;
+            uint64_t globalIndex;
+        };
+
+        /// Extract subdomains of a volume of the given dimension.
+        explicit DistributedMesher(const int3& dimension) : dimension(dimension)
+        {
+            assert(!(dimension[0] < 0 || dimension[1] < 0 || dimension[2] < 0) && "Dimension is invalid");
+        }
+
+        void SetNormals(Normals value) noexcept { mesher.SetNormals(value); }
+        void SetPlacement(Placement value) noexcept { mesher.SetPlacement(value); }
+
+        /// Voxels [begin,end) a subdomain of the cells in [cellBegin,cellEnd)
+        /// needs, including its ghost layer of two voxels below and three
+        /// voxels above.
+        [[nodiscard]] std::pair<int3, int3> GetSubdomainVoxels(const int3& cellBegin, const int3& cellEnd) const noexcept
+        {
+            return Mesher<VolumeDataType, IndexType>::GetSubdomainVoxels(dimension, cellBegin, GetExtendedEnd(cellEnd));
+        }
+
+        /// Extract the piece of the cells in [cellBegin,cellEnd) from voxels
+        /// starting at voxelOrigin, which cover GetSubdomainVoxels.
+        void Build(
+            const VolumeView<VolumeDataType>& voxels,
+            const int3& voxelOrigin,
+            VolumeDataType iso,
+            const int3& cellBegin,
+            const int3& cellEnd,
+            Piece& piece,
+            Topology topology = Topology::Triangles,
+            Manifold manifold = Manifold::On)
+        {
+            // the faces of the upper neighbors reference dual points of the
+            // cells of the piece, so these are created by extracting one more
+            // cell layer, whose faces are dropped
+            MeshType& mesh = piece.mesh;
+            mesher.BuildSubdomain(voxels, voxelOrigin, dimension, iso, cellBegin, GetExtendedEnd(cellEnd), mesh, &dualPoints, topology, manifold);
+            piece.cellBegin = cellBegin;
+            piece.cellEnd = cellEnd;
+
+            // owned vertices and ghosts are a subset of the extracted vertices,
+            // which have to fit below the two markers unused and ghost
+            const size_t vertexCount = mesh.vertices.size();
+            CheckVertexCount<IndexType>(vertexCount, 2);
+
+            // a face belongs to the cell of the lower end of its dual edge, which
+            // is the maximum of the cells of its dual points
+            constexpr IndexType unused = std::numeric_limits<IndexType>::max();
+            remap.assign(vertexCount, unused);
+            size_t owned = 0;
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                if (IsInside(dualPoints[v].cell, cellBegin, cellEnd))
+                    remap[v] = static_cast<IndexType>(owned++);
+            }
+
+            const size_t cornerCount = topology == Topology::Quads ? 4 : 3;
+            size_t indexCount = 0;
+            for (size_t face = 0; face < mesh.indices.size(); face += cornerCount)
+            {
+                int3 cell = dualPoints[mesh.indices[face]].cell;
+                for (size_t corner = 1; corner < cornerCount; ++corner)
+                {
+                    const int3& cornerCell = dualPoints[mesh.indices[face + corner]].cell;
+                    for (int32_t i = 0; i < 3; ++i)
+                    {
+                        cell[i] = std::max(cell[i], cornerCell[i]);
+                    }
+                }
+                if (!IsInside(cell, cellBegin, cellEnd))
+                    continue;
+                for (size_t corner = 0; corner < cornerCount; ++corner)
+                {
+                    mesh.indices[indexCount++] = mesh.indices[face + corner];
+                }
+            }
+            mesh.indices.resize(indexCount);
+
+            // ghosts referenced by the remaining faces follow the owned vertices,
+            // both in the order of extraction
+            constexpr IndexType ghost = unused - 1;
+            for (IndexType index : mesh.indices)
+            {
+                if (remap[index] == unused)
+                    remap[index] = ghost;
+            }
+            size_t kept = owned;
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                if (remap[v] == ghost)
+                    remap[v] = static_cast<IndexType>(kept++);
+            }
+            order.resize(kept);
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                if (remap[v] != unused)
+                    order[remap[v]] = static_cast<IndexType>(v);
+            }
+
+            vertices.resize(kept);
+            normals.resize(mesh.normals.empty() ? 0 : kept);
+            piece.keys.resize(kept);
+            for (size_t v = 0; v < kept; ++v)
+            {
+                vertices[v] = mesh.vertices[order[v]];
+                if (!normals.empty())
+                    normals[v] = mesh.normals[order[v]];
+                piece.keys[v] = GetKey(dualPoints[order[v]]);
+            }
+            std::swap(mesh.vertices, vertices);
+            std::swap(mesh.normals, normals);
+            for (IndexType& index : mesh.indices)
+            {
+                index = remap[index];
+            }
+            piece.ownedCount = owned;
+        }
+
+        /// Get the owned vertices of a piece, which neighbors may reference as
+        /// ghosts, with their global indices. These are the dual points of
+        /// the cells in the upper layers of the piece. vertexOffset is the
+        /// number of owned vertices of the pieces before it.
+        void GetSeamVertices(const Piece& piece, uint64_t vertexOffset, std::vector<SeamVertex>& seams) const
+        {
+            seams.clear();
+            for (size_t v = 0; v < piece.ownedCount; ++v)
+            {
+                const int3 cell = GetCell(piece.keys[v]);
+                bool seam = false;
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    seam = seam || cell[i] == piece.cellEnd[i] - 1;
+                }
+                if (seam)
+                {
+                    seams.push_back({piece.keys[v], vertexOffset + v});
+                }
+            }
+        }
+
+        /// Look up the global indices of the ghosts of a piece in the seams of
+        /// its neighbors, which gives the stitching index of the piece. Returns
+        /// false if some ghost is missing from the seams.
+        static bool ResolveGhosts(const Piece& piece, std::span<const SeamVertex> seams, std::vector<uint64_t>& ghostIndices)
+        {
+            std::unordered_map<uint64_t, uint64_t> globalIndices;
+            globalIndices.reserve(seams.size());
+            for (const SeamVertex& seam : seams)
+            {
+                globalIndices.emplace(seam.key, seam.globalIndex);
+            }
+
+            bool resolved = true;
+            ghostIndices.resize(piece.keys.size() - piece.ownedCount);
+            for (size_t ghost = 0; ghost < ghostIndices.size(); ++ghost)
+            {
+                auto found = globalIndices.find(piece.keys[piece.ownedCount + ghost]);
+                resolved = resolved && found != globalIndices.end();
+                ghostIndices[ghost] = found != globalIndices.end() ? found->second : uint64_t(-1);
+            }
+            return resolved;
+        }
+
+        /// Translate the indices of the faces of a piece to global indices
+        /// with the stitching index of ResolveGhosts.
+        static void GetGlobalIndices(const Piece& piece, uint64_t vertexOffset, std::span<const uint64_t> ghostIndices, std::vector<uint64_t>& indices)
+        {
+            assert(ghostIndices.size() == piece.keys.size() - piece.ownedCount && "Stitching index does not match the piece");
+            indices.resize(piece.mesh.indices.size());
+            std::transform(piece.mesh.indices.begin(), piece.mesh.indices.end(), indices.begin(), [&](IndexType index)
+            {
+                return size_t(index) < piece.ownedCount ? vertexOffset + index : ghostIndices[size_t(index) - piece.ownedCount];
+            });
+        }
+
+        /// Merge the pieces a and b, which come in this order, into result,
+        /// e.g. as a step of a reduction. Ghosts owned by the other piece are
+        /// replaced by its vertices. Merging all pieces in their order, in any
+        /// grouping, gives a mesh without ghosts, whose vertex indices are
+        /// the global indices. Throws std::length_error if the merged vertices
+        /// do not fit into the index type.
+        static void Merge(const Piece& a, const Piece& b, Piece& result)
+        {
+            assert(&result != &a && &result != &b && "Result has to be a separate piece");
+            const bool withNormals = !a.mesh.normals.empty() || !b.mesh.normals.empty();
+            assert((a.mesh.normals.size() == a.mesh.vertices.size() || a.mesh.vertices.empty() || !withNormals) &&
+                (b.mesh.normals.size() == b.mesh.vertices.size() || b.mesh.vertices.empty() || !withNormals) && "Pieces differ in their normals");
+
+            MeshType& mesh = result.mesh;
+            mesh.vertices.clear();
+            mesh.indices.clear();
+            mesh.normals.clear();
+            result.keys.clear();
+            result.ownedCount = a.ownedCount + b.ownedCount;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                result.cellBegin[i] = std::min(a.cellBegin[i], b.cellBegin[i]);
+                result.cellEnd[i] = std::max(a.cellEnd[i], b.cellEnd[i]);
+            }
+
+            // owned vertices of a and b, then the ghosts, which are still missing
+            std::unordered_map<uint64_t, size_t> merged;
+            merged.reserve(a.keys.size() + b.keys.size());
+            auto addOwned = [&](const Piece& piece)
+            {
+                for (size_t v = 0; v < piece.ownedCount; ++v)
+                {
+                    merged.emplace(piece.keys[v], result.keys.size());
+                    AddVertex(result, piece, v, withNormals);
+                }
+            };
+            addOwned(a);
+            addOwned(b);
+
+            // ghosts follow all owned vertices, so these keep their global order
+            auto addGhosts = [&](const Piece& piece, std::vector<size_t>& ghostRemap)
+            {
+                ghostRemap.resize(piece.keys.size() - piece.ownedCount);
+                for (size_t ghost = 0; ghost < ghostRemap.size(); ++ghost)
+                {
+                    const size_t v = piece.ownedCount + ghost;
+                    auto [found, inserted] = merged.emplace(piece.keys[v], result.keys.size());
+                    if (inserted)
+                    {
+                        AddVertex(result, piece, v, withNormals);
+                    }
+                    ghostRemap[ghost] = found->second;
+                }
+            };
+            std::vector<size_t> ghostRemapA;
+            std::vector<size_t> ghostRemapB;
+            addGhosts(a, ghostRemapA);
+            addGhosts(b, ghostRemapB);
+
+            // all vertices are known before any index is written
+            CheckVertexCount<IndexType>(mesh.vertices.size());
+            auto addFaces = [&](const Piece& piece, size_t offset, const std::vector<size_t>& ghostRemap)
+            {
+                for (IndexType index : piece.mesh.indices)
+                {
+                    const size_t mergedIndex = size_t(index) < piece.ownedCount ? offset + size_t(index) : ghostRemap[size_t(index) - piece.ownedCount];
+                    mesh.indices.push_back(static_cast<IndexType>(mergedIndex));
+                }
+            };
+            addFaces(a, 0, ghostRemapA);
+            addFaces(b, a.ownedCount, ghostRemapB);
+        }
+
+    private:
+        static int3 GetExtendedEnd(const int3& cellEnd) noexcept
+        {
+            return {cellEnd[0] + 1, cellEnd[1] + 1, cellEnd[2] + 1};
+        }
+
+        static bool IsInside(const int3& cell, const int3& begin, const int3& end) noexcept
+        {
+            return cell[0] >= begin[0] && cell[0] < end[0] && cell[1] >= begin[1] && cell[1] < end[1] && cell[2] >= begin[2] && cell[2] < end[2];
+        }
+
+        static void AddVertex(Piece& result, const Piece& piece, size_t v, bool withNormals)
+        {
+            result.mesh.vertices.push_back(piece.mesh.vertices[v]);
+            if (withNormals)
+                result.mesh.normals.push_back(piece.mesh.normals[v]);
+            result.keys.push_back(piece.keys[v]);
+        }
+
+        /// Key of a dual point, the linear index of its cell in the volume and
+        /// its slot.
+        uint64_t GetKey(const DualPointId& id) const noexcept
+        {
+            const uint64_t cell = (uint64_t(id.cell[2]) * uint64_t(dimension[1]) + uint64_t(id.cell[1])) * uint64_t(dimension[0]) + uint64_t(id.cell[0]);
+            return cell * 4 + uint64_t(id.slot);
+        }
+
+        int3 GetCell(uint64_t key) const noexcept
+        {
+            const uint64_t cell = key / 4;
+            const uint64_t row = cell / uint64_t(dimension[0]);
+            return {int32_t(cell % uint64_t(dimension[0])), int32_t(row % uint64_t(dimension[1])), int32_t(row / uint64_t(dimension[1]))};
+        }
+
+        int3 dimension;
+        Mesher<VolumeDataType, IndexType> mesher;
+        /// scratch buffers of Build
+        std::vector<DualPointId> dualPoints;
+        std::vector<IndexType> remap;
+        std::vector<IndexType> order;
+        std::vector<Vertex> vertices;
+        std::vector<float3> normals;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_DISTRIBUTED_H_INCLUDED
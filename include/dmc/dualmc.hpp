@@ -13,56 +13,209 @@
 // c includes
 #include <cstdint>
 #include <cassert>
+#include <cmath>
 
 
 // stl includes
-#include <unordered_map>
 #include <vector>
 #include <span>
 #include <array>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <bit>
+#include <unordered_map>
+
+// dual mc includes
+#include "types.hpp"
+#include "classify.hpp"
+#include "minmax_pyramid.hpp"
+#include "volume_view.hpp"
+#include "bricked_volume.hpp"
+#include "qef.hpp"
+#include "cells.hpp"
+#include "tables.hpp"
+#include "stats.hpp"
 
 namespace dualmc 
 {
-	using float3 = std::array<float, 3>;
-	using int3 = std::array<int32_t, 3>;
-
-    constexpr float3 operator+(const float3& a, const float3& b) 
-    {
-        return {a[0] + b[0], a[1] + b[1], a[2] + b[2]};
-    }
-    
-    constexpr float3 operator-(const float3& a, const float3& b) 
-    {
-        return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
-    }
-
-    constexpr float3 operator*(const float3& a, float s) 
-    {
-        return {a[0] * s, a[1] * s, a[2] * s};
-    }
-
-    constexpr float3& operator+=(float3& a, const float3& b) 
-    {
-        a[0] += b[0]; a[1] += b[1]; a[2] += b[2];
-        return a;
-    }
-
 	struct Vertex
 	{
         Vertex() = default;
 
 		float3 position;
-		// TODO: Normals
 	};
 
 	enum class Topology : uint8_t { Triangles, Quads };
 
-    struct Mesh
+	/// Select between the original dual marching cubes algorithm and the
+	/// manifold variant of Rephael Wenger.
+	enum class Manifold : uint8_t { Off, On };
+
+	/// Select if vertex normals are computed from the gradient of the volume.
+	enum class Normals : uint8_t { Off, On };
+
+	/// Select if dual points are placed at the mean of the edge intersections
+	/// or at the minimum of the QEF of the planes through them, which
+	/// reproduces sharp features.
+	enum class Placement : uint8_t { Mean, Qef };
+
+    /// Vertex indices of a mesh are 16, 32 or 64 bit wide.
+    template<class I>
+    concept MeshIndex = std::is_same_v<I, uint16_t> || std::is_same_v<I, uint32_t> || std::is_same_v<I, uint64_t>;
+
+    template<MeshIndex I>
+    struct BasicMesh
 	{
+		using IndexType = I;
+
 		std::vector<Vertex> vertices;
-		std::vector<uint32_t> indices;
+		std::vector<IndexType> indices;
+		/// Unit normals of the vertices, if extracted with Normals::On.
+		/// Empty otherwise.
+		std::vector<float3> normals;
 	};
 
+    /// Mesh with compact 32-bit indices, which is sufficient for all but
+    /// the largest volumes.
+    using Mesh = BasicMesh<uint32_t>;
+    /// Mesh with 16-bit indices for small chunks with at most 2^16-2 vertices.
+    using Mesh16 = BasicMesh<uint16_t>;
+    /// Mesh with 64-bit indices for surfaces with more than 2^32 vertices.
+    using Mesh64 = BasicMesh<uint64_t>;
+
+    /// Number of vertices and indices of an extracted mesh.
+    struct MeshSize
+    {
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+    };
+
+    /// Cell and slot of the dual point of a vertex, which identify the
+    /// vertex in the whole volume.
+    struct DualPointId
+    {
+        int3 cell;
+        int32_t slot;
+    };
+
+    /// Mesh of the faces of the cells in [cellBegin,cellEnd), e.g. from
+    /// Mesher::BuildRegion, with the dual points of its vertices.
+    template<MeshIndex I>
+    struct MeshRegion
+    {
+        const BasicMesh<I>* mesh = nullptr;
+        const std::vector<DualPointId>* dualPoints = nullptr;
+        int3 cellBegin{0, 0, 0};
+        int3 cellEnd{0, 0, 0};
+    };
+
+    /// Concatenates meshes into a single mesh, without welding their vertices.
+    /// Normals are kept if all meshes have them. Throws std::length_error if
+    /// the vertices do not fit into the index type.
+    template<MeshIndex I>
+    void ConcatenateMeshes(std::span<const BasicMesh<I>> parts, BasicMesh<I>& mesh)
+    {
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        bool normals = true;
+        for (const BasicMesh<I>& part : parts)
+        {
+            vertexCount += part.vertices.size();
+            indexCount += part.indices.size();
+            normals = normals && part.normals.size() == part.vertices.size();
+        }
+        CheckVertexCount<I>(vertexCount);
+
+        mesh.vertices.resize(vertexCount);
+        mesh.normals.resize(normals ? vertexCount : 0);
+        mesh.indices.resize(indexCount);
+        Vertex* vertices = mesh.vertices.data();
+        float3* vertexNormals = mesh.normals.data();
+        I* indices = mesh.indices.data();
+        I offset = 0;
+        for (const BasicMesh<I>& part : parts)
+        {
+            vertices = std::copy(part.vertices.begin(), part.vertices.end(), vertices);
+            if (normals)
+                vertexNormals = std::copy(part.normals.begin(), part.normals.end(), vertexNormals);
+            indices = std::transform(part.indices.begin(), part.indices.end(), indices,
+                [offset](I index) { return static_cast<I>(index + offset); });
+            offset = static_cast<I>(offset + part.vertices.size());
+        }
+    }
+
+    /// Joins the meshes of regions of a volume with cellCount cells into a
+    /// single mesh. A dual point referenced by several regions is kept once,
+    /// where it first occurs, so regions tiling the cells in z,y,x order give
+    /// the mesh of Mesher::Build. Normals are kept if all regions have them.
+    /// Throws std::length_error if the vertices do not fit into the index type.
+    template<MeshIndex I>
+    void WeldMeshes(std::span<const MeshRegion<I>> regions, const int3& cellCount, BasicMesh<I>& mesh)
+    {
+        // only dual points in the boundary layers of a region or outside of it
+        // can be referenced by other regions
+        auto isShared = [&cellCount](const MeshRegion<I>& region, const int3& cell)
+        {
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                if ((cell[i] <= region.cellBegin[i] && region.cellBegin[i] > 0) ||
+                    (cell[i] >= region.cellEnd[i] - 1 && region.cellEnd[i] < cellCount[i]))
+                    return true;
+            }
+            return false;
+        };
+
+        // indices of the vertices of all regions in the mesh
+        std::vector<size_t> remap;
+        std::unordered_map<uint64_t, size_t> shared;
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        bool normals = true;
+        for (const MeshRegion<I>& region : regions)
+        {
+            const BasicMesh<I>& part = *region.mesh;
+            const std::vector<DualPointId>& dualPoints = *region.dualPoints;
+            assert(dualPoints.size() == part.vertices.size() && "Dual points do not match the mesh");
+            for (const DualPointId& dualPoint : dualPoints)
+            {
+                if (!isShared(region, dualPoint.cell))
+                {
+                    remap.push_back(vertexCount++);
+                    continue;
+                }
+                const uint64_t cell = (uint64_t(dualPoint.cell[2]) * uint64_t(cellCount[1]) + uint64_t(dualPoint.cell[1])) * uint64_t(cellCount[0]) + uint64_t(dualPoint.cell[0]);
+                auto [found, inserted] = shared.emplace(cell * 4 + uint64_t(dualPoint.slot), vertexCount);
+                vertexCount += inserted ? 1 : 0;
+                remap.push_back(found->second);
+            }
+            indexCount += part.indices.size();
+            normals = normals && part.normals.size() == part.vertices.size();
+        }
+        CheckVertexCount<I>(vertexCount);
+
+        mesh.vertices.resize(vertexCount);
+        mesh.normals.resize(normals ? vertexCount : 0);
+        mesh.indices.resize(indexCount);
+        const size_t* regionRemap = remap.data();
+        I* indices = mesh.indices.data();
+        for (const MeshRegion<I>& region : regions)
+        {
+            const BasicMesh<I>& part = *region.mesh;
+            for (size_t v = 0; v < part.vertices.size(); ++v)
+            {
+                mesh.vertices[regionRemap[v]] = part.vertices[v];
+                if (normals)
+                    mesh.normals[regionRemap[v]] = part.normals[v];
+            }
+            indices = std::transform(part.indices.begin(), part.indices.end(), indices,
+                [regionRemap](I index) { return static_cast<I>(regionRemap[index]); });
+            regionRemap += part.vertices.size();
+        }
+    }
+
 
     /// \class  DualMC
     /// \author Dominik Wodniok
@@ -76,744 +229,2131 @@ namespace dualmc
     /// The class optionally can guarantee manifold meshes by taking the Manifold
     /// Dual Marching Cubes approach from Rephael Wenger as described in
     /// chapter 3.3.5 of his book "Isosurfaces: Geometry, Topology, and Algorithms".
-    template<class T>
-    requires std::is_arithmetic_v<T>
+    /// Voxels are always addressed with 64-bit offsets. The width of the mesh
+    /// indices is selected by I, so small volumes keep the compact 32-bit
+    /// layout for the mesh and the shared dual point slices.
+    template<class T, MeshIndex I = uint32_t>
+    requires VoxelType<T>
 	class Mesher 
     {
     public:
 		using VolumeDataType = T;
+		using IndexType = I;
+		using MeshType = BasicMesh<IndexType>;
+
+		/// Fills a z-slice of a streamed volume with its extent[0]*extent[1]
+		/// voxels. Slices are requested once each, in ascending order.
+		using SliceSource = std::function<void(int32_t z, std::span<VolumeDataType> slice)>;
+
+		/// Fills block with the size[0]*size[1]*size[2] voxels of the box starting
+		/// at begin of a larger, possibly unbounded volume, x varying fastest.
+		/// The box covers a chunk and parts of its neighbors.
+		using BlockSource = std::function<void(const int3& begin, const int3& size, std::span<VolumeDataType> block)>;
+
+		/// Receives the vertices and indices of a streamed extraction in batches.
+		/// Indices are global and only reference vertices of the same or of
+		/// earlier batches.
+		using MeshSink = std::function<void(std::span<const Vertex> vertices, std::span<const IndexType> indices)>;
+
+		/// Value range of a box of voxels.
+		using Range = typename MinMaxPyramid<VolumeDataType>::Range;
+
+		/// Samples a procedural volume at the voxels (x+i,y,z) of row.
+		using RowSampler = std::function<void(int32_t x, int32_t y, int32_t z, std::span<VolumeDataType> row)>;
+
+		/// Returns a conservative range of the samples of a procedural volume in
+		/// the inclusive voxel box [min,max], e.g. from a Lipschitz bound or by
+		/// interval arithmetic. Wider ranges only cost additional samples.
+		using RangeBound = std::function<Range(const int3& min, const int3& max)>;
 
 		/// Extracts the iso surface for a given volume and iso value.
 		/// Output is a list of vertices and a list of indices, which connect
-		/// vertices to quads or triangles.
-		[[nodiscard]] Mesh Build(
-			const std::span<VolumeDataType>& data, 
+		/// vertices to quads or triangles. The manifold variant of the algorithm
+		/// is used by default. Each combination of manifold mode and topology
+		/// runs its own specialized face construction.
+		/// An optional min/max pyramid of the volume is used for skipping cells
+		/// of bricks which do not hold surface. The result does not change.
+		[[nodiscard]] MeshType Build(
+			const std::span<const VolumeDataType>& data, 
 			const int3& dimension, 
 			VolumeDataType iso,
-			Topology topology = Topology::Triangles)
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
 		{
-			assert(!(dimension[0] < 0 || dimension[1] < 0 || dimension[2] < 0) && "Dimension is invalid");
-            assert(!data.empty() && "Volume data is empty");
-            assert(data.size() >= (size_t)(dimension[0] * dimension[1] * dimension[2]) && "Volume data is smaller than extent");
-
-            Context ctx{
-                .volume = data,
-                .extent = dimension,
-                .iso = iso,
-                .topology = topology,
-                .mesh = Mesh{}
-            };
-			
-			BuildInternal( ctx);
-			return ctx.mesh;
+			MeshType mesh;
+			Build(data, dimension, iso, mesh, topology, manifold, pyramid);
+			return mesh;
 		}
 
-    private:
-        /// Dual point key structure for hashing of shared vertices
-        struct DualPointKey 
-		{
-            // a dual point can be uniquely identified by ite linearized volume cell
-            // id and point code
-            int32_t linearizedCellID;
-            int32_t pointCode;
-            /// Equal operator for unordered map
-            bool operator==(DualPointKey const& other) const = default;
-        };
-        
-        /// Functor for dual point key hash generation
-        struct DualPointKeyHash 
+		/// Extracts the iso surface of a volume view with arbitrary strides.
+		/// Rows with adjacent voxels are read in place, other volumes are
+		/// gathered one voxel slice at a time, so no copy of the volume is made.
+		[[nodiscard]] MeshType Build(
+			const VolumeView<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			MeshType mesh;
+			Build(volume, iso, mesh, topology, manifold, pyramid);
+			return mesh;
+		}
+
+		/// Extracts the iso surface into a caller-owned mesh, whose previous
+		/// content is replaced. The capacity of the mesh and the scratch buffers
+		/// of the mesher are kept across calls, so repeated extractions of
+		/// similar volumes do not allocate.
+		void Build(
+			const std::span<const VolumeDataType>& data, 
+			const int3& dimension, 
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(data, dimension);
+			Build(VolumeView<VolumeDataType>(data.data(), dimension), iso, mesh, topology, manifold, pyramid);
+		}
+
+		/// Extracts the iso surface of a volume view into a caller-owned mesh.
+		void Build(
+			const VolumeView<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(volume, pyramid);
+			CountSlabs(volume, iso, topology, manifold, pyramid, {0, 0, 0}, GetCellCount(volume.extent), 1);
+			FillSlabs(mesh);
+		}
+
+		/// Extracts the iso surface into caller-owned buffers, e.g. from an arena.
+		/// The required number of vertices and indices is returned. If it exceeds
+		/// the size of the buffers, nothing is written and the call has to be
+		/// repeated with buffers of at least the returned size.
+		[[nodiscard]] MeshSize Build(
+			const std::span<const VolumeDataType>& data, 
+			const int3& dimension, 
+			VolumeDataType iso,
+			std::span<Vertex> vertices,
+			std::span<IndexType> indices,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(data, dimension);
+			return Build(VolumeView<VolumeDataType>(data.data(), dimension), iso, vertices, indices, topology, manifold, pyramid);
+		}
+
+		/// Extracts the iso surface of a volume view into caller-owned buffers.
+		[[nodiscard]] MeshSize Build(
+			const VolumeView<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			std::span<Vertex> vertices,
+			std::span<IndexType> indices,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
 		{
-            size_t operator()(DualPointKey const& k) const 
+			AssertArguments(volume, pyramid);
+			MeshSize size = CountSlabs(volume, iso, topology, manifold, pyramid, {0, 0, 0}, GetCellCount(volume.extent), 1);
+			if (size.vertexCount <= vertices.size() && size.indexCount <= indices.size())
 			{
-                return size_t(k.linearizedCellID) | (size_t(k.pointCode) << 32u);
+				FillSlabs(vertices.data(), indices.data());
+			}
+			return size;
+		}
+
+		/// Extracts the iso surface like Build, but splits the volume into z-slabs
+		/// which are processed on threadCount worker threads. Each worker has its own
+		/// context and writes to its own range of the output mesh. Dual points on
+		/// the seams between slabs are owned by the earlier slab, so the result is
+		/// identical to the one of Build, including vertex order.
+		/// A threadCount of 0 uses the number of hardware threads.
+		[[nodiscard]] MeshType BuildParallel(
+			const std::span<const VolumeDataType>& data, 
+			const int3& dimension, 
+			VolumeDataType iso,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			uint32_t threadCount = 0,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			MeshType mesh;
+			BuildParallel(data, dimension, iso, mesh, topology, manifold, threadCount, pyramid);
+			return mesh;
+		}
+
+		/// Extracts the iso surface of a volume view on threadCount worker threads.
+		[[nodiscard]] MeshType BuildParallel(
+			const VolumeView<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			uint32_t threadCount = 0,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			MeshType mesh;
+			BuildParallel(volume, iso, mesh, topology, manifold, threadCount, pyramid);
+			return mesh;
+		}
+
+		/// Extracts the iso surface on threadCount worker threads into a
+		/// caller-owned mesh, whose previous content is replaced.
+		void BuildParallel(
+			const std::span<const VolumeDataType>& data, 
+			const int3& dimension, 
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			uint32_t threadCount = 0,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(data, dimension);
+			BuildParallel(VolumeView<VolumeDataType>(data.data(), dimension), iso, mesh, topology, manifold, threadCount, pyramid);
+		}
+
+		/// Extracts the iso surface of a volume view on threadCount worker threads
+		/// into a caller-owned mesh.
+		void BuildParallel(
+			const VolumeView<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			uint32_t threadCount = 0,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(volume, pyramid);
+            int3 cellCount = GetCellCount(volume.extent);
+            CountSlabs(volume, iso, topology, manifold, pyramid, {0, 0, 0}, cellCount, GetSlabCount(cellCount, threadCount));
+            FillSlabs(mesh);
+		}
+
+		/// Extracts the part of the iso surface, which belongs to the cells in
+		/// [cellBegin,cellEnd), into a caller-owned mesh. A face belongs to the
+		/// cell of the lower end of its dual edge, so regions tiling the volume
+		/// give all faces of Build exactly once. Dual points referenced by the
+		/// faces of several regions are created in each of their meshes, and
+		/// WeldMeshes joins them again.
+		void BuildRegion(
+			const std::span<const VolumeDataType>& data, 
+			const int3& dimension, 
+			VolumeDataType iso,
+			const int3& cellBegin,
+			const int3& cellEnd,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr,
+			std::vector<DualPointId>* dualPoints = nullptr)
+		{
+			AssertArguments(data, dimension);
+			BuildRegion(VolumeView<VolumeDataType>(data.data(), dimension), iso, cellBegin, cellEnd, mesh, topology, manifold, pyramid, dualPoints);
+		}
+
+		/// Extracts the part of the iso surface of a volume view, which belongs
+		/// to the cells in [cellBegin,cellEnd), into a caller-owned mesh. The
+		/// dual points of the vertices are written to dualPoints, if given,
+		/// which identify the vertices shared with other regions.
+		void BuildRegion(
+			const VolumeView<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			const int3& cellBegin,
+			const int3& cellEnd,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr,
+			std::vector<DualPointId>* dualPoints = nullptr)
+		{
+			AssertArguments(volume, pyramid);
+            auto [begin, end] = ClampRegion(volume.extent, cellBegin, cellEnd);
+			const MeshSize size = CountSlabs(volume, iso, topology, manifold, pyramid, begin, end, 1);
+            if (dualPoints != nullptr)
+            {
+                dualPoints->resize(size.vertexCount);
+                slabs.front().dualPoints = dualPoints->data();
             }
-        };
+			FillSlabs(mesh);
+		}
 
-        struct Context
-        {
-            std::span<VolumeDataType> volume;
-            int3 extent;
-            VolumeDataType iso;
-            Topology topology;
-            Mesh mesh;
-            std::unordered_map<DualPointKey,uint32_t,DualPointKeyHash> pointToIndex;
-        };
+		/// Extracts the iso surface of a bricked volume. Its voxel slices are
+		/// gathered brick by brick, which reads each brick of a slice of bricks
+		/// from few pages of memory.
+		[[nodiscard]] MeshType Build(
+			const BrickedVolume<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			MeshType mesh;
+			Build(volume, iso, mesh, topology, manifold, pyramid);
+			return mesh;
+		}
 
-        /*
-         * Static lookup tables needed for (manifold) dual marching cubes
-
-         *  Coordinate system
-         *
-         *       y
-         *       |
-         *       |
-         *       |
-         *       0-----x
-         *      /
-         *     /
-         *    z
-         *
-
-         * Cell Corners
-         * (Corners are voxels. Number correspond to Morton codes of corner coordinates)
-         *
-         *       2-------------------3
-         *      /|                  /|
-         *     / |                 / |
-         *    /  |                /  |
-         *   6-------------------7   |
-         *   |   |               |   |
-         *   |   |               |   |
-         *   |   |               |   |
-         *   |   |               |   |
-         *   |   0---------------|---1
-         *   |  /                |  /
-         *   | /                 | /
-         *   |/                  |/
-         *   4-------------------5
-         *
-
-
-         *         Cell Edges
-         *  
-         *       o--------4----------o
-         *      /|                  /|
-         *     7 |                 5 |
-         *    /  |                /  |
-         *   o--------6----------o   |
-         *   |   8               |   9
-         *   |   |               |   |
-         *   |   |               |   |
-         *   11  |               10  |
-         *   |   o--------0------|---o
-         *   |  /                |  /
-         *   | 3                 | 1
-         *   |/                  |/
-         *   o--------2----------o
-        */
+		/// Extracts the iso surface of a bricked volume into a caller-owned mesh.
+		void Build(
+			const BrickedVolume<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(volume, pyramid);
+			CountSlabs(volume, iso, topology, manifold, pyramid, {0, 0, 0}, GetCellCount(volume.Extent()), 1);
+			FillSlabs(mesh);
+		}
 
-        /*
-         * Enum with edge codes for a 12-bit voxel edge mask to indicate
-         * grid edges which intersect the ISO surface of classic marching cubes
-        */
-        enum DMCEdgeCode : uint32_t
-        {
-            EDGE0 = 1,
-            EDGE1 = 1 << 1,
-            EDGE2 = 1 << 2,
-            EDGE3 = 1 << 3,
-            EDGE4 = 1 << 4,
-            EDGE5 = 1 << 5,
-            EDGE6 = 1 << 6,
-            EDGE7 = 1 << 7,
-            EDGE8 = 1 << 8,
-            EDGE9 = 1 << 9,
-            EDGE10 = 1 << 10,
-            EDGE11 = 1 << 11
-        };
+		/// Extracts the iso surface of a bricked volume on threadCount worker
+		/// threads into a caller-owned mesh.
+		void BuildParallel(
+			const BrickedVolume<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			uint32_t threadCount = 0,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(volume, pyramid);
+            int3 cellCount = GetCellCount(volume.Extent());
+            CountSlabs(volume, iso, topology, manifold, pyramid, {0, 0, 0}, cellCount, GetSlabCount(cellCount, threadCount));
+            FillSlabs(mesh);
+		}
 
-        /*
-         * Dual Marching Cubes table
-         * Encodes the edge vertices for the 256 marching cubes cases.
-         * A marching cube case produces up to four faces and ,thus, up to four
-         * dual points.
-        */
-        static constexpr std::array<std::array<int32_t, 4>, 256> dualPointsList{{
-            {0, 0, 0, 0}, // 0
-            {EDGE0 | EDGE3 | EDGE8, 0, 0, 0}, // 1
-            {EDGE0 | EDGE1 | EDGE9, 0, 0, 0}, // 2
-            {EDGE1 | EDGE3 | EDGE8 | EDGE9, 0, 0, 0}, // 3
-            {EDGE4 | EDGE7 | EDGE8, 0, 0, 0}, // 4
-            {EDGE0 | EDGE3 | EDGE4 | EDGE7, 0, 0, 0}, // 5
-            {EDGE0 | EDGE1 | EDGE9, EDGE4 | EDGE7 | EDGE8, 0, 0}, // 6
-            {EDGE1 | EDGE3 | EDGE4 | EDGE7 | EDGE9, 0, 0, 0}, // 7
-            {EDGE4 | EDGE5 | EDGE9, 0, 0, 0}, // 8
-            {EDGE0 | EDGE3 | EDGE8, EDGE4 | EDGE5 | EDGE9, 0, 0}, // 9
-            {EDGE0 | EDGE1 | EDGE4 | EDGE5, 0, 0, 0}, // 10
-            {EDGE1 | EDGE3 | EDGE4 | EDGE5 | EDGE8, 0, 0, 0}, // 11
-            {EDGE5 | EDGE7 | EDGE8 | EDGE9, 0, 0, 0}, // 12
-            {EDGE0 | EDGE3 | EDGE5 | EDGE7 | EDGE9, 0, 0, 0}, // 13
-            {EDGE0 | EDGE1 | EDGE5 | EDGE7 | EDGE8, 0, 0, 0}, // 14
-            {EDGE1 | EDGE3 | EDGE5 | EDGE7, 0, 0, 0}, // 15
-            {EDGE2 | EDGE3 | EDGE11, 0, 0, 0}, // 16
-            {EDGE0 | EDGE2 | EDGE8 | EDGE11, 0, 0, 0}, // 17
-            {EDGE0 | EDGE1 | EDGE9, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 18
-            {EDGE1 | EDGE2 | EDGE8 | EDGE9 | EDGE11, 0, 0, 0}, // 19
-            {EDGE4 | EDGE7 | EDGE8, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 20
-            {EDGE0 | EDGE2 | EDGE4 | EDGE7 | EDGE11, 0, 0, 0}, // 21
-            {EDGE0 | EDGE1 | EDGE9, EDGE4 | EDGE7 | EDGE8, EDGE2 | EDGE3 | EDGE11, 0}, // 22
-            {EDGE1 | EDGE2 | EDGE4 | EDGE7 | EDGE9 | EDGE11, 0, 0, 0}, // 23
-            {EDGE4 | EDGE5 | EDGE9, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 24
-            {EDGE0 | EDGE2 | EDGE8 | EDGE11, EDGE4 | EDGE5 | EDGE9, 0, 0}, // 25
-            {EDGE0 | EDGE1 | EDGE4 | EDGE5, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 26
-            {EDGE1 | EDGE2 | EDGE4 | EDGE5 | EDGE8 | EDGE11, 0, 0, 0}, // 27
-            {EDGE5 | EDGE7 | EDGE8 | EDGE9, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 28
-            {EDGE0 | EDGE2 | EDGE5 | EDGE7 | EDGE9 | EDGE11, 0, 0, 0}, // 29
-            {EDGE0 | EDGE1 | EDGE5 | EDGE7 | EDGE8, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 30
-            {EDGE1 | EDGE2 | EDGE5 | EDGE7 | EDGE11, 0, 0, 0}, // 31
-            {EDGE1 | EDGE2 | EDGE10, 0, 0, 0}, // 32
-            {EDGE0 | EDGE3 | EDGE8, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 33
-            {EDGE0 | EDGE2 | EDGE9 | EDGE10, 0, 0, 0}, // 34
-            {EDGE2 | EDGE3 | EDGE8 | EDGE9 | EDGE10, 0, 0, 0}, // 35
-            {EDGE4 | EDGE7 | EDGE8, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 36
-            {EDGE0 | EDGE3 | EDGE4 | EDGE7, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 37
-            {EDGE0 | EDGE2 | EDGE9 | EDGE10, EDGE4 | EDGE7 | EDGE8, 0, 0}, // 38
-            {EDGE2 | EDGE3 | EDGE4 | EDGE7 | EDGE9 | EDGE10, 0, 0, 0}, // 39
-            {EDGE4 | EDGE5 | EDGE9, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 40
-            {EDGE0 | EDGE3 | EDGE8, EDGE4 | EDGE5 | EDGE9, EDGE1 | EDGE2 | EDGE10, 0}, // 41
-            {EDGE0 | EDGE2 | EDGE4 | EDGE5 | EDGE10, 0, 0, 0}, // 42
-            {EDGE2 | EDGE3 | EDGE4 | EDGE5 | EDGE8 | EDGE10, 0, 0, 0}, // 43
-            {EDGE5 | EDGE7 | EDGE8 | EDGE9, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 44
-            {EDGE0 | EDGE3 | EDGE5 | EDGE7 | EDGE9, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 45
-            {EDGE0 | EDGE2 | EDGE5 | EDGE7 | EDGE8 | EDGE10, 0, 0, 0}, // 46
-            {EDGE2 | EDGE3 | EDGE5 | EDGE7 | EDGE10, 0, 0, 0}, // 47
-            {EDGE1 | EDGE3 | EDGE10 | EDGE11, 0, 0, 0}, // 48
-            {EDGE0 | EDGE1 | EDGE8 | EDGE10 | EDGE11, 0, 0, 0}, // 49
-            {EDGE0 | EDGE3 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 50
-            {EDGE8 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 51
-            {EDGE4 | EDGE7 | EDGE8, EDGE1 | EDGE3 | EDGE10 | EDGE11, 0, 0}, // 52
-            {EDGE0 | EDGE1 | EDGE4 | EDGE7 | EDGE10 | EDGE11, 0, 0, 0}, // 53
-            {EDGE0 | EDGE3 | EDGE9 | EDGE10 | EDGE11, EDGE4 | EDGE7 | EDGE8, 0, 0}, // 54
-            {EDGE4 | EDGE7 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 55
-            {EDGE4 | EDGE5 | EDGE9, EDGE1 | EDGE3 | EDGE10 | EDGE11, 0, 0}, // 56
-            {EDGE0 | EDGE1 | EDGE8 | EDGE10 | EDGE11, EDGE4 | EDGE5 | EDGE9, 0, 0}, // 57
-            {EDGE0 | EDGE3 | EDGE4 | EDGE5 | EDGE10 | EDGE11, 0, 0, 0}, // 58
-            {EDGE4 | EDGE5 | EDGE8 | EDGE10 | EDGE11, 0, 0, 0}, // 59
-            {EDGE5 | EDGE7 | EDGE8 | EDGE9, EDGE1 | EDGE3 | EDGE10 | EDGE11, 0, 0}, // 60
-            {EDGE0 | EDGE1 | EDGE5 | EDGE7 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 61
-            {EDGE0 | EDGE3 | EDGE5 | EDGE7 | EDGE8 | EDGE10 | EDGE11, 0, 0, 0}, // 62
-            {EDGE5 | EDGE7 | EDGE10 | EDGE11, 0, 0, 0}, // 63
-            {EDGE6 | EDGE7 | EDGE11, 0, 0, 0}, // 64
-            {EDGE0 | EDGE3 | EDGE8, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 65
-            {EDGE0 | EDGE1 | EDGE9, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 66
-            {EDGE1 | EDGE3 | EDGE8 | EDGE9, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 67
-            {EDGE4 | EDGE6 | EDGE8 | EDGE11, 0, 0, 0}, // 68
-            {EDGE0 | EDGE3 | EDGE4 | EDGE6 | EDGE11, 0, 0, 0}, // 69
-            {EDGE0 | EDGE1 | EDGE9, EDGE4 | EDGE6 | EDGE8 | EDGE11, 0, 0}, // 70
-            {EDGE1 | EDGE3 | EDGE4 | EDGE6 | EDGE9 | EDGE11, 0, 0, 0}, // 71
-            {EDGE4 | EDGE5 | EDGE9, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 72
-            {EDGE0 | EDGE3 | EDGE8, EDGE4 | EDGE5 | EDGE9, EDGE6 | EDGE7 | EDGE11, 0}, // 73
-            {EDGE0 | EDGE1 | EDGE4 | EDGE5, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 74
-            {EDGE1 | EDGE3 | EDGE4 | EDGE5 | EDGE8, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 75
-            {EDGE5 | EDGE6 | EDGE8 | EDGE9 | EDGE11, 0, 0, 0}, // 76
-            {EDGE0 | EDGE3 | EDGE5 | EDGE6 | EDGE9 | EDGE11, 0, 0, 0}, // 77
-            {EDGE0 | EDGE1 | EDGE5 | EDGE6 | EDGE8 | EDGE11, 0, 0, 0}, // 78
-            {EDGE1 | EDGE3 | EDGE5 | EDGE6 | EDGE11, 0, 0, 0}, // 79
-            {EDGE2 | EDGE3 | EDGE6 | EDGE7, 0, 0, 0}, // 80
-            {EDGE0 | EDGE2 | EDGE6 | EDGE7 | EDGE8, 0, 0, 0}, // 81
-            {EDGE0 | EDGE1 | EDGE9, EDGE2 | EDGE3 | EDGE6 | EDGE7, 0, 0}, // 82
-            {EDGE1 | EDGE2 | EDGE6 | EDGE7 | EDGE8 | EDGE9, 0, 0, 0}, // 83
-            {EDGE2 | EDGE3 | EDGE4 | EDGE6 | EDGE8, 0, 0, 0}, // 84
-            {EDGE0 | EDGE2 | EDGE4 | EDGE6, 0, 0, 0}, // 85
-            {EDGE0 | EDGE1 | EDGE9, EDGE2 | EDGE3 | EDGE4 | EDGE6 | EDGE8, 0, 0}, // 86
-            {EDGE1 | EDGE2 | EDGE4 | EDGE6 | EDGE9, 0, 0, 0}, // 87
-            {EDGE4 | EDGE5 | EDGE9, EDGE2 | EDGE3 | EDGE6 | EDGE7, 0, 0}, // 88
-            {EDGE0 | EDGE2 | EDGE6 | EDGE7 | EDGE8, EDGE4 | EDGE5 | EDGE9, 0, 0}, // 89
-            {EDGE0 | EDGE1 | EDGE4 | EDGE5, EDGE2 | EDGE3 | EDGE6 | EDGE7, 0, 0}, // 90
-            {EDGE1 | EDGE2 | EDGE4 | EDGE5 | EDGE6 | EDGE7 | EDGE8, 0, 0, 0}, // 91
-            {EDGE2 | EDGE3 | EDGE5 | EDGE6 | EDGE8 | EDGE9, 0, 0, 0}, // 92
-            {EDGE0 | EDGE2 | EDGE5 | EDGE6 | EDGE9, 0, 0, 0}, // 93
-            {EDGE0 | EDGE1 | EDGE2 | EDGE3 | EDGE5 | EDGE6 | EDGE8, 0, 0, 0}, // 94
-            {EDGE1 | EDGE2 | EDGE5 | EDGE6, 0, 0, 0}, // 95
-            {EDGE1 | EDGE2 | EDGE10, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 96
-            {EDGE0 | EDGE3 | EDGE8, EDGE1 | EDGE2 | EDGE10, EDGE6 | EDGE7 | EDGE11, 0}, // 97
-            {EDGE0 | EDGE2 | EDGE9 | EDGE10, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 98
-            {EDGE2 | EDGE3 | EDGE8 | EDGE9 | EDGE10, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 99
-            {EDGE4 | EDGE6 | EDGE8 | EDGE11, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 100
-            {EDGE0 | EDGE3 | EDGE4 | EDGE6 | EDGE11, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 101
-            {EDGE0 | EDGE2 | EDGE9 | EDGE10, EDGE4 | EDGE6 | EDGE8 | EDGE11, 0, 0}, // 102
-            {EDGE2 | EDGE3 | EDGE4 | EDGE6 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 103
-            {EDGE4 | EDGE5 | EDGE9, EDGE1 | EDGE2 | EDGE10, EDGE6 | EDGE7 | EDGE11, 0}, // 104
-            {EDGE0 | EDGE3 | EDGE8, EDGE4 | EDGE5 | EDGE9, EDGE1 | EDGE2 | EDGE10, EDGE6 | EDGE7 | EDGE11}, // 105
-            {EDGE0 | EDGE2 | EDGE4 | EDGE5 | EDGE10, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 106
-            {EDGE2 | EDGE3 | EDGE4 | EDGE5 | EDGE8 | EDGE10, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 107
-            {EDGE5 | EDGE6 | EDGE8 | EDGE9 | EDGE11, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 108
-            {EDGE0 | EDGE3 | EDGE5 | EDGE6 | EDGE9 | EDGE11, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 109
-            {EDGE0 | EDGE2 | EDGE5 | EDGE6 | EDGE8 | EDGE10 | EDGE11, 0, 0, 0}, // 110
-            {EDGE2 | EDGE3 | EDGE5 | EDGE6 | EDGE10 | EDGE11, 0, 0, 0}, // 111
-            {EDGE1 | EDGE3 | EDGE6 | EDGE7 | EDGE10, 0, 0, 0}, // 112
-            {EDGE0 | EDGE1 | EDGE6 | EDGE7 | EDGE8 | EDGE10, 0, 0, 0}, // 113
-            {EDGE0 | EDGE3 | EDGE6 | EDGE7 | EDGE9 | EDGE10, 0, 0, 0}, // 114
-            {EDGE6 | EDGE7 | EDGE8 | EDGE9 | EDGE10, 0, 0, 0}, // 115
-            {EDGE1 | EDGE3 | EDGE4 | EDGE6 | EDGE8 | EDGE10, 0, 0, 0}, // 116
-            {EDGE0 | EDGE1 | EDGE4 | EDGE6 | EDGE10, 0, 0, 0}, // 117
-            {EDGE0 | EDGE3 | EDGE4 | EDGE6 | EDGE8 | EDGE9 | EDGE10, 0, 0, 0}, // 118
-            {EDGE4 | EDGE6 | EDGE9 | EDGE10, 0, 0, 0}, // 119
-            {EDGE4 | EDGE5 | EDGE9, EDGE1 | EDGE3 | EDGE6 | EDGE7 | EDGE10, 0, 0}, // 120
-            {EDGE0 | EDGE1 | EDGE6 | EDGE7 | EDGE8 | EDGE10, EDGE4 | EDGE5 | EDGE9, 0, 0}, // 121
-            {EDGE0 | EDGE3 | EDGE4 | EDGE5 | EDGE6 | EDGE7 | EDGE10, 0, 0, 0}, // 122
-            {EDGE4 | EDGE5 | EDGE6 | EDGE7 | EDGE8 | EDGE10, 0, 0, 0}, // 123
-            {EDGE1 | EDGE3 | EDGE5 | EDGE6 | EDGE8 | EDGE9 | EDGE10, 0, 0, 0}, // 124
-            {EDGE0 | EDGE1 | EDGE5 | EDGE6 | EDGE9 | EDGE10, 0, 0, 0}, // 125
-            {EDGE0 | EDGE3 | EDGE8, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 126
-            {EDGE5 | EDGE6 | EDGE10, 0, 0, 0}, // 127
-            {EDGE5 | EDGE6 | EDGE10, 0, 0, 0}, // 128
-            {EDGE0 | EDGE3 | EDGE8, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 129
-            {EDGE0 | EDGE1 | EDGE9, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 130
-            {EDGE1 | EDGE3 | EDGE8 | EDGE9, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 131
-            {EDGE4 | EDGE7 | EDGE8, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 132
-            {EDGE0 | EDGE3 | EDGE4 | EDGE7, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 133
-            {EDGE0 | EDGE1 | EDGE9, EDGE4 | EDGE7 | EDGE8, EDGE5 | EDGE6 | EDGE10, 0}, // 134
-            {EDGE1 | EDGE3 | EDGE4 | EDGE7 | EDGE9, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 135
-            {EDGE4 | EDGE6 | EDGE9 | EDGE10, 0, 0, 0}, // 136
-            {EDGE0 | EDGE3 | EDGE8, EDGE4 | EDGE6 | EDGE9 | EDGE10, 0, 0}, // 137
-            {EDGE0 | EDGE1 | EDGE4 | EDGE6 | EDGE10, 0, 0, 0}, // 138
-            {EDGE1 | EDGE3 | EDGE4 | EDGE6 | EDGE8 | EDGE10, 0, 0, 0}, // 139
-            {EDGE6 | EDGE7 | EDGE8 | EDGE9 | EDGE10, 0, 0, 0}, // 140
-            {EDGE0 | EDGE3 | EDGE6 | EDGE7 | EDGE9 | EDGE10, 0, 0, 0}, // 141
-            {EDGE0 | EDGE1 | EDGE6 | EDGE7 | EDGE8 | EDGE10, 0, 0, 0}, // 142
-            {EDGE1 | EDGE3 | EDGE6 | EDGE7 | EDGE10, 0, 0, 0}, // 143
-            {EDGE2 | EDGE3 | EDGE11, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 144
-            {EDGE0 | EDGE2 | EDGE8 | EDGE11, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 145
-            {EDGE0 | EDGE1 | EDGE9, EDGE2 | EDGE3 | EDGE11, EDGE5 | EDGE6 | EDGE10, 0}, // 146
-            {EDGE1 | EDGE2 | EDGE8 | EDGE9 | EDGE11, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 147
-            {EDGE4 | EDGE7 | EDGE8, EDGE2 | EDGE3 | EDGE11, EDGE5 | EDGE6 | EDGE10, 0}, // 148
-            {EDGE0 | EDGE2 | EDGE4 | EDGE7 | EDGE11, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 149
-            {EDGE0 | EDGE1 | EDGE9, EDGE4 | EDGE7 | EDGE8, EDGE2 | EDGE3 | EDGE11, EDGE5 | EDGE6 | EDGE10}, // 150
-            {EDGE1 | EDGE2 | EDGE4 | EDGE7 | EDGE9 | EDGE11, EDGE5 | EDGE6 | EDGE10, 0, 0}, // 151
-            {EDGE4 | EDGE6 | EDGE9 | EDGE10, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 152
-            {EDGE0 | EDGE2 | EDGE8 | EDGE11, EDGE4 | EDGE6 | EDGE9 | EDGE10, 0, 0}, // 153
-            {EDGE0 | EDGE1 | EDGE4 | EDGE6 | EDGE10, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 154
-            {EDGE1 | EDGE2 | EDGE4 | EDGE6 | EDGE8 | EDGE10 | EDGE11, 0, 0, 0}, // 155
-            {EDGE6 | EDGE7 | EDGE8 | EDGE9 | EDGE10, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 156
-            {EDGE0 | EDGE2 | EDGE6 | EDGE7 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 157
-            {EDGE0 | EDGE1 | EDGE6 | EDGE7 | EDGE8 | EDGE10, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 158
-            {EDGE1 | EDGE2 | EDGE6 | EDGE7 | EDGE10 | EDGE11, 0, 0, 0}, // 159
-            {EDGE1 | EDGE2 | EDGE5 | EDGE6, 0, 0, 0}, // 160
-            {EDGE0 | EDGE3 | EDGE8, EDGE1 | EDGE2 | EDGE5 | EDGE6, 0, 0}, // 161
-            {EDGE0 | EDGE2 | EDGE5 | EDGE6 | EDGE9, 0, 0, 0}, // 162
-            {EDGE2 | EDGE3 | EDGE5 | EDGE6 | EDGE8 | EDGE9, 0, 0, 0}, // 163
-            {EDGE4 | EDGE7 | EDGE8, EDGE1 | EDGE2 | EDGE5 | EDGE6, 0, 0}, // 164
-            {EDGE0 | EDGE3 | EDGE4 | EDGE7, EDGE1 | EDGE2 | EDGE5 | EDGE6, 0, 0}, // 165
-            {EDGE0 | EDGE2 | EDGE5 | EDGE6 | EDGE9, EDGE4 | EDGE7 | EDGE8, 0, 0}, // 166
-            {EDGE2 | EDGE3 | EDGE4 | EDGE5 | EDGE6 | EDGE7 | EDGE9, 0, 0, 0}, // 167
-            {EDGE1 | EDGE2 | EDGE4 | EDGE6 | EDGE9, 0, 0, 0}, // 168
-            {EDGE0 | EDGE3 | EDGE8, EDGE1 | EDGE2 | EDGE4 | EDGE6 | EDGE9, 0, 0}, // 169
-            {EDGE0 | EDGE2 | EDGE4 | EDGE6, 0, 0, 0}, // 170
-            {EDGE2 | EDGE3 | EDGE4 | EDGE6 | EDGE8, 0, 0, 0}, // 171
-            {EDGE1 | EDGE2 | EDGE6 | EDGE7 | EDGE8 | EDGE9, 0, 0, 0}, // 172
-            {EDGE0 | EDGE1 | EDGE2 | EDGE3 | EDGE6 | EDGE7 | EDGE9, 0, 0, 0}, // 173
-            {EDGE0 | EDGE2 | EDGE6 | EDGE7 | EDGE8, 0, 0, 0}, // 174
-            {EDGE2 | EDGE3 | EDGE6 | EDGE7, 0, 0, 0}, // 175
-            {EDGE1 | EDGE3 | EDGE5 | EDGE6 | EDGE11, 0, 0, 0}, // 176
-            {EDGE0 | EDGE1 | EDGE5 | EDGE6 | EDGE8 | EDGE11, 0, 0, 0}, // 177
-            {EDGE0 | EDGE3 | EDGE5 | EDGE6 | EDGE9 | EDGE11, 0, 0, 0}, // 178
-            {EDGE5 | EDGE6 | EDGE8 | EDGE9 | EDGE11, 0, 0, 0}, // 179
-            {EDGE4 | EDGE7 | EDGE8, EDGE1 | EDGE3 | EDGE5 | EDGE6 | EDGE11, 0, 0}, // 180
-            {EDGE0 | EDGE1 | EDGE4 | EDGE5 | EDGE6 | EDGE7 | EDGE11, 0, 0, 0}, // 181
-            {EDGE0 | EDGE3 | EDGE5 | EDGE6 | EDGE9 | EDGE11, EDGE4 | EDGE7 | EDGE8, 0, 0}, // 182
-            {EDGE4 | EDGE5 | EDGE6 | EDGE7 | EDGE9 | EDGE11, 0, 0, 0}, // 183
-            {EDGE1 | EDGE3 | EDGE4 | EDGE6 | EDGE9 | EDGE11, 0, 0, 0}, // 184
-            {EDGE0 | EDGE1 | EDGE4 | EDGE6 | EDGE8 | EDGE9 | EDGE11, 0, 0, 0}, // 185
-            {EDGE0 | EDGE3 | EDGE4 | EDGE6 | EDGE11, 0, 0, 0}, // 186
-            {EDGE4 | EDGE6 | EDGE8 | EDGE11, 0, 0, 0}, // 187
-            {EDGE1 | EDGE3 | EDGE6 | EDGE7 | EDGE8 | EDGE9 | EDGE11, 0, 0, 0}, // 188
-            {EDGE0 | EDGE1 | EDGE9, EDGE6 | EDGE7 | EDGE11, 0, 0}, // 189
-            {EDGE0 | EDGE3 | EDGE6 | EDGE7 | EDGE8 | EDGE11, 0, 0, 0}, // 190
-            {EDGE6 | EDGE7 | EDGE11, 0, 0, 0}, // 191
-            {EDGE5 | EDGE7 | EDGE10 | EDGE11, 0, 0, 0}, // 192
-            {EDGE0 | EDGE3 | EDGE8, EDGE5 | EDGE7 | EDGE10 | EDGE11, 0, 0}, // 193
-            {EDGE0 | EDGE1 | EDGE9, EDGE5 | EDGE7 | EDGE10 | EDGE11, 0, 0}, // 194
-            {EDGE1 | EDGE3 | EDGE8 | EDGE9, EDGE5 | EDGE7 | EDGE10 | EDGE11, 0, 0}, // 195
-            {EDGE4 | EDGE5 | EDGE8 | EDGE10 | EDGE11, 0, 0, 0}, // 196
-            {EDGE0 | EDGE3 | EDGE4 | EDGE5 | EDGE10 | EDGE11, 0, 0, 0}, // 197
-            {EDGE0 | EDGE1 | EDGE9, EDGE4 | EDGE5 | EDGE8 | EDGE10 | EDGE11, 0, 0}, // 198
-            {EDGE1 | EDGE3 | EDGE4 | EDGE5 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 199
-            {EDGE4 | EDGE7 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 200
-            {EDGE0 | EDGE3 | EDGE8, EDGE4 | EDGE7 | EDGE9 | EDGE10 | EDGE11, 0, 0}, // 201
-            {EDGE0 | EDGE1 | EDGE4 | EDGE7 | EDGE10 | EDGE11, 0, 0, 0}, // 202
-            {EDGE1 | EDGE3 | EDGE4 | EDGE7 | EDGE8 | EDGE10 | EDGE11, 0, 0, 0}, // 203
-            {EDGE8 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 204
-            {EDGE0 | EDGE3 | EDGE9 | EDGE10 | EDGE11, 0, 0, 0}, // 205
-            {EDGE0 | EDGE1 | EDGE8 | EDGE10 | EDGE11, 0, 0, 0}, // 206
-            {EDGE1 | EDGE3 | EDGE10 | EDGE11, 0, 0, 0}, // 207
-            {EDGE2 | EDGE3 | EDGE5 | EDGE7 | EDGE10, 0, 0, 0}, // 208
-            {EDGE0 | EDGE2 | EDGE5 | EDGE7 | EDGE8 | EDGE10, 0, 0, 0}, // 209
-            {EDGE0 | EDGE1 | EDGE9, EDGE2 | EDGE3 | EDGE5 | EDGE7 | EDGE10, 0, 0}, // 210
-            {EDGE1 | EDGE2 | EDGE5 | EDGE7 | EDGE8 | EDGE9 | EDGE10, 0, 0, 0}, // 211
-            {EDGE2 | EDGE3 | EDGE4 | EDGE5 | EDGE8 | EDGE10, 0, 0, 0}, // 212
-            {EDGE0 | EDGE2 | EDGE4 | EDGE5 | EDGE10, 0, 0, 0}, // 213
-            {EDGE0 | EDGE1 | EDGE9, EDGE2 | EDGE3 | EDGE4 | EDGE5 | EDGE8 | EDGE10, 0, 0}, // 214
-            {EDGE1 | EDGE2 | EDGE4 | EDGE5 | EDGE9 | EDGE10, 0, 0, 0}, // 215
-            {EDGE2 | EDGE3 | EDGE4 | EDGE7 | EDGE9 | EDGE10, 0, 0, 0}, // 216
-            {EDGE0 | EDGE2 | EDGE4 | EDGE7 | EDGE8 | EDGE9 | EDGE10, 0, 0, 0}, // 217
-            {EDGE0 | EDGE1 | EDGE2 | EDGE3 | EDGE4 | EDGE7 | EDGE10, 0, 0, 0}, // 218
-            {EDGE4 | EDGE7 | EDGE8, EDGE1 | EDGE2 | EDGE10, 0, 0}, // 219
-            {EDGE2 | EDGE3 | EDGE8 | EDGE9 | EDGE10, 0, 0, 0}, // 220
-            {EDGE0 | EDGE2 | EDGE9 | EDGE10, 0, 0, 0}, // 221
-            {EDGE0 | EDGE1 | EDGE2 | EDGE3 | EDGE8 | EDGE10, 0, 0, 0}, // 222
-            {EDGE1 | EDGE2 | EDGE10, 0, 0, 0}, // 223
-            {EDGE1 | EDGE2 | EDGE5 | EDGE7 | EDGE11, 0, 0, 0}, // 224
-            {EDGE0 | EDGE3 | EDGE8, EDGE1 | EDGE2 | EDGE5 | EDGE7 | EDGE11, 0, 0}, // 225
-            {EDGE0 | EDGE2 | EDGE5 | EDGE7 | EDGE9 | EDGE11, 0, 0, 0}, // 226
-            {EDGE2 | EDGE3 | EDGE5 | EDGE7 | EDGE8 | EDGE9 | EDGE11, 0, 0, 0}, // 227
-            {EDGE1 | EDGE2 | EDGE4 | EDGE5 | EDGE8 | EDGE11, 0, 0, 0}, // 228
-            {EDGE0 | EDGE1 | EDGE2 | EDGE3 | EDGE4 | EDGE5 | EDGE11, 0, 0, 0}, // 229
-            {EDGE0 | EDGE2 | EDGE4 | EDGE5 | EDGE8 | EDGE9 | EDGE11, 0, 0, 0}, // 230
-            {EDGE4 | EDGE5 | EDGE9, EDGE2 | EDGE3 | EDGE11, 0, 0}, // 231
-            {EDGE1 | EDGE2 | EDGE4 | EDGE7 | EDGE9 | EDGE11, 0, 0, 0}, // 232
-            {EDGE0 | EDGE3 | EDGE8, EDGE1 | EDGE2 | EDGE4 | EDGE7 | EDGE9 | EDGE11, 0, 0}, // 233
-            {EDGE0 | EDGE2 | EDGE4 | EDGE7 | EDGE11, 0, 0, 0}, // 234
-            {EDGE2 | EDGE3 | EDGE4 | EDGE7 | EDGE8 | EDGE11, 0, 0, 0}, // 235
-            {EDGE1 | EDGE2 | EDGE8 | EDGE9 | EDGE11, 0, 0, 0}, // 236
-            {EDGE0 | EDGE1 | EDGE2 | EDGE3 | EDGE9 | EDGE11, 0, 0, 0}, // 237
-            {EDGE0 | EDGE2 | EDGE8 | EDGE11, 0, 0, 0}, // 238
-            {EDGE2 | EDGE3 | EDGE11, 0, 0, 0}, // 239
-            {EDGE1 | EDGE3 | EDGE5 | EDGE7, 0, 0, 0}, // 240
-            {EDGE0 | EDGE1 | EDGE5 | EDGE7 | EDGE8, 0, 0, 0}, // 241
-            {EDGE0 | EDGE3 | EDGE5 | EDGE7 | EDGE9, 0, 0, 0}, // 242
-            {EDGE5 | EDGE7 | EDGE8 | EDGE9, 0, 0, 0}, // 243
-            {EDGE1 | EDGE3 | EDGE4 | EDGE5 | EDGE8, 0, 0, 0}, // 244
-            {EDGE0 | EDGE1 | EDGE4 | EDGE5, 0, 0, 0}, // 245
-            {EDGE0 | EDGE3 | EDGE4 | EDGE5 | EDGE8 | EDGE9, 0, 0, 0}, // 246
-            {EDGE4 | EDGE5 | EDGE9, 0, 0, 0}, // 247
-            {EDGE1 | EDGE3 | EDGE4 | EDGE7 | EDGE9, 0, 0, 0}, // 248
-            {EDGE0 | EDGE1 | EDGE4 | EDGE7 | EDGE8 | EDGE9, 0, 0, 0}, // 249
-            {EDGE0 | EDGE3 | EDGE4 | EDGE7, 0, 0, 0}, // 250
-            {EDGE4 | EDGE7 | EDGE8, 0, 0, 0}, // 251
-            {EDGE1 | EDGE3 | EDGE8 | EDGE9, 0, 0, 0}, // 252
-            {EDGE0 | EDGE1 | EDGE9, 0, 0, 0}, // 253
-            {EDGE0 | EDGE3 | EDGE8, 0, 0, 0}, // 254
-            {0, 0, 0, 0} // 255
-        }};
-        
-        /*
-         * Table which encodes the ambiguous face of cube configurations, which
-         * can cause non-manifold meshes.
-         * Needed for manifold dual marching cubes.
-         * Non-problematic configurations have a value of 255.
-         * The first bit of each value actually encodes a positive or negative
-         * direction while the second and third bit enumerate the axis.
-        */
-        static constexpr std::array<uint8_t, 256> problematicConfigs{
-            255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-            255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-            255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-            255,255,255,255,255,255,255,255,255,255,255,255,255,1,0,255,
-            255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-            255,255,255,255,255,255,255,255,255,255,255,3,255,255,2,255,
-            255,255,255,255,255,255,255,5,255,255,255,255,255,255,5,5,
-            255,255,255,255,255,255,4,255,255,255,3,3,1,1,255,255,
-            255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-            255,255,255,255,255,255,255,255,255,255,255,5,255,5,255,5,
-            255,255,255,255,255,255,255,3,255,255,255,255,255,2,255,255,
-            255,255,255,255,255,3,255,3,255,4,255,255,0,255,0,255,
-            255,255,255,255,255,255,255,1,255,255,255,0,255,255,255,255,
-            255,255,255,1,255,255,255,1,255,4,2,255,255,255,2,255,
-            255,255,255,0,255,2,4,255,255,255,255,0,255,2,255,255,
-            255,255,255,255,255,255,4,255,255,4,255,255,255,255,255,255
-        };
+		/// Extracts the part of the iso surface of a bricked volume, which belongs
+		/// to the cells in [cellBegin,cellEnd), into a caller-owned mesh.
+		void BuildRegion(
+			const BrickedVolume<VolumeDataType>& volume, 
+			VolumeDataType iso,
+			const int3& cellBegin,
+			const int3& cellEnd,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(volume, pyramid);
+            auto [begin, end] = ClampRegion(volume.Extent(), cellBegin, cellEnd);
+			CountSlabs(volume, iso, topology, manifold, pyramid, begin, end, 1);
+			FillSlabs(mesh);
+		}
 
-		void BuildInternal(Context& ctx)
+		/// Extracts the iso surfaces of several iso values, e.g. the levels of an
+		/// analysis, in one traversal of the volume. Returns a mesh per iso value,
+		/// which is identical to the mesh of Build with that iso value.
+		[[nodiscard]] std::vector<MeshType> BuildMany(
+			const std::span<const VolumeDataType>& data, 
+			const int3& dimension, 
+			std::span<const VolumeDataType> isos,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
 		{
-            int32_t dimX = ctx.extent[0] - 2;
-			int32_t dimY = ctx.extent[1] - 2;
-			int32_t dimZ = ctx.extent[2] - 2;
+			AssertArguments(data, dimension);
+			return BuildMany(VolumeView<VolumeDataType>(data.data(), dimension), isos, topology, manifold, pyramid);
+		}
 
-			int32_t reducedX = dimX - 2;
-			int32_t reducedY = dimY - 2;
-			int32_t reducedZ = dimZ - 2;
+		/// Extracts the iso surfaces of several iso values of a volume view.
+		[[nodiscard]] std::vector<MeshType> BuildMany(
+			const VolumeView<VolumeDataType>& volume, 
+			std::span<const VolumeDataType> isos,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			std::vector<MeshType> meshes(isos.size());
+			BuildMany(volume, isos, meshes, topology, manifold, pyramid);
+			return meshes;
+		}
 
-			// iterate voxels
-			for (int32_t z = 0; z < reducedZ; ++z)
-			{
-				for (int32_t y = 0; y < reducedY; ++y)
-				{
-					for (int32_t x = 0; x < reducedX; ++x) 
-					{
-						// construct quads for x edge
-						if (z > 0 && y > 0) 
-						{
-							auto [entering, exiting] = GetStatus(ctx,x, y, z, 1, 0, 0);
-							if (entering || exiting) 
-							{
-								ConstructFace(
-									ctx,
-                                    entering,
-                                    {
-                                        int3{x, y, z}, 
-                                        int3{x, y, z - 1}, 
-                                        int3{x, y - 1, z - 1}, 
-                                        int3{x, y - 1, z}
-                                    },
-                                    {EDGE0,EDGE2,EDGE6,EDGE4}
-                                );
-							}
-						}
+		/// Extracts the iso surfaces of several iso values of a volume view into
+		/// caller-owned meshes, one per iso value. The extractions of the iso
+		/// values take their z steps in turn and share the voxel slices, so each
+		/// slice is fetched from memory once instead of once per iso value. The
+		/// value ranges of its voxel rows are computed once as well, and each
+		/// iso value only classifies the cell rows straddling it.
+		void BuildMany(
+			const VolumeView<VolumeDataType>& volume, 
+			std::span<const VolumeDataType> isos,
+			std::span<MeshType> meshes,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On,
+			const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+		{
+			AssertArguments(volume, pyramid);
+            assert(meshes.size() >= isos.size() && "Fewer meshes than iso values");
+            if (isos.empty())
+                return;
 
-						// construct quads for y edge
-						if (z > 0 && x > 0) 
-						{
-							auto [entering, exiting] = GetStatus(ctx,x, y, z, 0, 1, 0);
-							if (entering || exiting) 
-							{
-								ConstructFace(
-                                    ctx,
-                                    exiting,
-                                    {
-                                        int3{x, y, z}, 
-                                        int3{x, y, z - 1}, 
-                                        int3{x - 1, y, z - 1}, 
-                                        int3{x - 1, y, z}
-                                    },
-                                    {EDGE8,EDGE11,EDGE10,EDGE9}
-                                );
-							}
-						}
+            // one context per iso value, which all cover the whole volume
+            slabs.resize(isos.size());
+            for (size_t i = 0; i < isos.size(); ++i)
+            {
+                InitializeSlab(slabs[i], volume, isos[i], topology, manifold, pyramid, {0, 0, 0}, GetCellCount(volume.extent));
+                slabs[i].leader = &slabs.front();
+            }
+            passStats = {};
+            {
+                stats::ScopedTimer timer(passStats.countTime);
+                DispatchSlab<Pass::Count>(std::span<Context>(slabs));
+            }
 
-						// construct quads for z edge
-						if (x > 0 && y > 0) 
-						{
-							auto [entering, exiting] = GetStatus(ctx,x, y, z, 0, 0, 1);
-							if (entering || exiting) 
-							{
-								ConstructFace(
-                                    ctx,
-                                    exiting,
-                                    {
-                                        int3{x, y, z}, 
-                                        {x - 1, y, z}, 
-                                        {x - 1, y - 1, z}, 
-                                        int3{x, y - 1, z}
-                                    },
-                                    {EDGE3,EDGE1,EDGE5,EDGE7}
-                                );
-							}
-						}
-					}
-				}
-			}
+            for (size_t i = 0; i < isos.size(); ++i)
+            {
+                Context& slab = slabs[i];
+                MeshType& mesh = meshes[i];
+                CheckVertexCount<IndexType>(slab.vertexCount, ReservedIndexCount);
+                ResizeMesh(mesh, slab.vertexCount, slab.indexCount);
+                slab.vertices = mesh.vertices.data();
+                slab.indices = mesh.indices.data();
+                slab.normals = normals == Normals::On ? mesh.normals.data() : nullptr;
+                slab.vertexCount = 0;
+                slab.indexCount = 0;
+            }
+            stats::ScopedTimer timer(passStats.fillTime);
+            DispatchSlab<Pass::Fill>(std::span<Context>(slabs));
 		}
 
-		/// get the 8-bit in-out mask for the voxel corners of the cell cube at (cx,cy,cz)
-		/// and the given iso value
-		int32_t GetCellCode(const int3& cell, const Context& ctx) const noexcept
-		{
-			// determine for each cube corner if it is outside or inside
-			int32_t code = 0;
-			if (ctx.volume[CalculateLinearIndex(cell[0], cell[1], cell[2],ctx.extent)] >= ctx.iso)
-				code |= 1;
-			if (ctx.volume[CalculateLinearIndex(cell[0] + 1, cell[1], cell[2],ctx.extent)] >= ctx.iso)
-				code |= 2;
-			if (ctx.volume[CalculateLinearIndex(cell[0], cell[1] + 1, cell[2],ctx.extent)] >= ctx.iso)
-				code |= 4;
-			if (ctx.volume[CalculateLinearIndex(cell[0] + 1, cell[1] + 1, cell[2],ctx.extent)] >= ctx.iso)
-				code |= 8;
-			if (ctx.volume[CalculateLinearIndex(cell[0], cell[1], cell[2] + 1,ctx.extent)] >= ctx.iso)
-				code |= 16;
-			if (ctx.volume[CalculateLinearIndex(cell[0] + 1, cell[1], cell[2] + 1,ctx.extent)] >= ctx.iso)
-				code |= 32;
-			if (ctx.volume[CalculateLinearIndex(cell[0], cell[1] + 1, cell[2] + 1,ctx.extent)] >= ctx.iso)
-				code |= 64;
-			if (ctx.volume[CalculateLinearIndex(cell[0] + 1, cell[1] + 1, cell[2] + 1,ctx.extent)] >= ctx.iso)
-				code |= 128;
-			return code;
-		}
-
-		/// Get the 12-bit dual point code mask, which encodes the traditional
-		/// marching cube vertices of the traditional marching cubes face which
-		/// corresponds to the dual point.
-		/// This is also where the manifold dual marching cubes algorithm is
-		/// implemented.
-		int32_t GetDualPointCode(const int3& cell, const Context& ctx, DMCEdgeCode edge) const
-		{
-			int32_t cubeCode = GetCellCode(cell, ctx);
-
-            // The Manifold Dual Marching Cubes approach from Rephael Wenger as described in
-            // chapter 3.3.5 of his book "Isosurfaces: Geometry, Topology, and Algorithms"
-            // is implemente here.
-            // If a problematic C16 or C19 configuration shares the ambiguous face 
-            // with another C16 or C19 configuration we simply invert the cube code
-            // before looking up dual points. Doing this for these pairs ensures
-            // manifold meshes.
-            // But this removes the dualism to marching cubes.
-
-            // check if we have a potentially problematic configuration
-            uint8_t direction = problematicConfigs[uint8_t(cubeCode)];
-            // If the direction code is in {0,...,5} we have a C16 or C19 configuration.
-            if (direction != 255) 
-            {
-                // We have to check the neighboring cube, which shares the ambiguous
-                // face. For this we decode the direction. This could also be done
-                // with another lookup table.
-                // copy current cube coordinates into an array.
-                int3 neighborCoords = cell;
-                // get the dimension of the non-zero coordinate axis
-                uint32_t component = direction >> 1;
-                // get the sign of the direction
-                int32_t delta = (direction & 1) == 1 ? 1 : -1;
-                // modify the correspong cube coordinate
-                neighborCoords[component] += delta;
-                // have we left the volume in this direction?
-                if (neighborCoords[component] >= 0 && neighborCoords[component] < (ctx.extent[component] - 1)) 
-                {
-                    // get the cube configuration of the relevant neighbor
-                    int32_t neighborCubeCode = GetCellCode(neighborCoords, ctx);
-                    // Look up the neighbor configuration ambiguous face direction.
-                    // If the direction is valid we have a C16 or C19 neighbor.
-                    // As C16 and C19 have exactly one ambiguous face this face is
-                    // guaranteed to be shared for the pair.
-                    if (problematicConfigs[uint8_t(neighborCubeCode)] != 255) 
-                    {
-                        // replace the cube configuration with its inverse.
-                        cubeCode ^= 0xff;
-                    }
-                }
+		/// Extracts the faces of the cells in [chunkOrigin,chunkOrigin+chunkSize)
+		/// of a larger volume, e.g. a chunk of a terrain. Instead of trimming the
+		/// cells at its border like Build, the chunk is padded by two voxels on
+		/// each side, which are fetched from source together with the chunk.
+		/// Vertices are given in the coordinates of the larger volume and only
+		/// depend on the voxels around them, so the dual points on the border
+		/// of neighboring chunks are bit-identical and their meshes join without
+		/// cracks. Chunks may be meshed independently and in any order, with one
+		/// mesher per thread.
+		void BuildChunk(
+			const BlockSource& source,
+			const int3& chunkOrigin,
+			const int3& chunkSize,
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On)
+		{
+			assert(!(chunkSize[0] < 0 || chunkSize[1] < 0 || chunkSize[2] < 0) && "Chunk size is invalid");
+            assert(source && "Block source is missing");
+
+            // The faces of the chunk reference the cells up to two cells below and
+            // one cell above it, whose corners are the voxels in the padded block.
+            int3 blockBegin;
+            int3 blockSize;
+            int3 cellBegin{2, 2, 2};
+            int3 cellEnd;
+            int3 cellCount;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                blockBegin[i] = chunkOrigin[i] - 2;
+                blockSize[i] = chunkSize[i] + 4;
+                cellEnd[i] = chunkSize[i] + 2;
+                cellCount[i] = chunkSize[i] + 2;
             }
+            chunkBlock.resize(size_t(blockSize[0]) * size_t(blockSize[1]) * size_t(blockSize[2]));
+            source(blockBegin, blockSize, std::span<VolumeDataType>(chunkBlock));
 
-			for (int32_t i = 0; i < 4; ++i)
-			{
-				if (dualPointsList[cubeCode][i] & edge) 
-				{
-					return dualPointsList[cubeCode][i];
-				}
-			}
-			return 0;
+            SplitSlabs(VolumeView<VolumeDataType>(chunkBlock.data(), blockSize), iso, topology, manifold, nullptr, cellBegin, cellEnd, 1);
+            slabs.front().cellCount = cellCount;
+            slabs.front().cellOffset = blockBegin;
+            CountSlabs();
+            FillSlabs(mesh);
 		}
 
-		/// Given a dual point code and iso value, compute the dual point.
-		void CalculateDualPoint(const int3& cell, const Context& ctx, int32_t pointCode, Vertex &v) const
+		/// Extracts the faces of the cells in [cellBegin,cellEnd) of a volume of
+		/// the given dimension, of which only the voxels of a subdomain with its
+		/// ghost layers are in memory, e.g. on a rank of a distributed
+		/// simulation. voxels holds the voxels starting at voxelOrigin, which
+		/// have to cover the box of GetSubdomainVoxels. Faces and vertices are
+		/// the ones of Build on the whole volume, in its coordinates, so
+		/// subdomains tiling the cells give all faces of Build exactly once.
+		/// The dual points of the vertices are written to dualPoints, if given.
+		void BuildSubdomain(
+			const VolumeView<VolumeDataType>& voxels,
+			const int3& voxelOrigin,
+			const int3& dimension,
+			VolumeDataType iso,
+			const int3& cellBegin,
+			const int3& cellEnd,
+			MeshType& mesh,
+			std::vector<DualPointId>* dualPoints = nullptr,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On)
 		{
-			// compute the dual point as the mean of the face vertices belonging to the
-			// original marching cubes face
-			float3 p{0,0,0};
-			int32_t points = 0;
+			assert(!(dimension[0] < 0 || dimension[1] < 0 || dimension[2] < 0) && "Dimension is invalid");
+            auto [begin, end] = ClampRegion(dimension, cellBegin, cellEnd);
+            [[maybe_unused]] auto [voxelBegin, voxelEnd] = GetSubdomainVoxels(dimension, begin, end);
+            int3 localBegin;
+            int3 localEnd;
+            int3 cellCount = GetCellCount(dimension);
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                assert(voxelOrigin[i] <= voxelBegin[i] && voxelOrigin[i] + voxels.extent[i] >= voxelEnd[i] && "Voxels do not cover the subdomain");
+                localBegin[i] = begin[i] - voxelOrigin[i];
+                localEnd[i] = end[i] - voxelOrigin[i];
+                cellCount[i] -= voxelOrigin[i];
+            }
 
-            auto val = [&](int32_t dx, int32_t dy, int32_t dz) 
+            // as for chunks, cells are addressed in the voxels and offset to the
+            // coordinates of the volume
+            SplitSlabs(voxels, iso, topology, manifold, nullptr, localBegin, localEnd, 1);
+            Context& ctx = slabs.front();
+            ctx.cellCount = cellCount;
+            ctx.cellOffset = voxelOrigin;
+            const MeshSize size = CountSlabs();
+            if (dualPoints != nullptr)
             {
-                return (float)ctx.volume[CalculateLinearIndex(cell[0] + dx, cell[1] + dy, cell[2] + dz, ctx.extent)];
-            };
+                dualPoints->resize(size.vertexCount);
+                ctx.dualPoints = dualPoints->data();
+            }
+            FillSlabs(mesh);
+		}
 
-            auto interpolate = [&](float valA, float valB) 
+		/// Get the box [begin,end) of the voxels, which BuildSubdomain reads for
+		/// the cells in [cellBegin,cellEnd). It extends the cells by a ghost
+		/// layer of two voxels on each side, as faces reference the
+		/// dual points of the cells below and the manifold test reads the
+		/// neighbors of cells, clamped to the volume.
+		[[nodiscard]] static std::pair<int3, int3> GetSubdomainVoxels(const int3& dimension, const int3& cellBegin, const int3& cellEnd) noexcept
+		{
+            int3 begin;
+            int3 end;
+            for (int32_t i = 0; i < 3; ++i)
             {
-                 return ((float)ctx.iso - valA) / (valB - valA);
-            };
+                begin[i] = std::clamp(cellBegin[i] - 2, 0, dimension[i]);
+                end[i] = std::clamp(cellEnd[i] + 2, begin[i], dimension[i]);
+            }
+            return {begin, end};
+		}
 
-			// sum edge intersection vertices using the point code
-			struct EdgeDef {
-                int8_t axis;      // 0=x, 1=y, 2=z
-                int8_t oX, oY, oZ; // Origin coordinates
-            };
+		/// Extracts the iso surface of a volume, which is not held in memory.
+		/// The voxel slices are fetched from source one at a time and at most five
+		/// of them are kept. Vertices and faces are passed to sink after each
+		/// voxel slice, so memory is bounded by the slice size. Concatenating the
+		/// batches gives the same mesh as Build. The size of the mesh is returned.
+		MeshSize BuildStreamed(
+			const SliceSource& source,
+			const int3& dimension,
+			VolumeDataType iso,
+			const MeshSink& sink,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On)
+		{
+			assert(!(dimension[0] < 0 || dimension[1] < 0 || dimension[2] < 0) && "Dimension is invalid");
+            assert(source && sink && "Slice source or mesh sink is missing");
 
-            // Table mapping edge index (0-11) to axis and origin
-            static constexpr std::array<EdgeDef, 12> edgeTable = {{
-                {0, 0,0,0}, {2, 1,0,0}, {0, 0,0,1}, {2, 0,0,0}, // Edges 0-3
-                {0, 0,1,0}, {2, 1,1,0}, {0, 0,1,1}, {2, 0,1,0}, // Edges 4-7
-                {1, 0,0,0}, {1, 1,0,0}, {1, 1,0,1}, {1, 0,0,1}  // Edges 8-11
-            }};
+            slabs.resize(1);
+            Context& ctx = slabs.front();
+            InitializeSlab(ctx, VolumeView<VolumeDataType>(nullptr, dimension), iso, topology, manifold, nullptr, {0, 0, 0}, GetCellCount(dimension));
+            ctx.source = &source;
+            ctx.sink = &sink;
 
-            for (int i = 0; i < 12; ++i) 
+            passStats = {};
             {
-                if (pointCode & (1 << i)) 
-                {
-                    const auto& edge = edgeTable[i];
-                    
-                    // Value at edge origin
-                    float v1 = val(edge.oX, edge.oY, edge.oZ);
-                    
-                    // Value at edge end (origin + axis direction)
-                    float v2 = val(
-                        edge.oX + (edge.axis == 0), 
-                        edge.oY + (edge.axis == 1), 
-                        edge.oZ + (edge.axis == 2)
-                    );
-
-                    // Base position is the edge origin
-                    float3 pos = {static_cast<float>(edge.oX), static_cast<float>(edge.oY), static_cast<float>(edge.oZ)};
-                    
-                    // Add interpolated offset along the axis
-                    pos[edge.axis] += interpolate(v1, v2);
-                    
-                    p = p + pos;
-                    points++;
-                }
+                stats::ScopedTimer timer(passStats.fillTime);
+                DispatchSlab<Pass::Stream>(ctx);
             }
+            return {ctx.vertexCount, ctx.indexCount};
+		}
 
-			// divide by number of accumulated points
-			float invPoints = 1.0f / (float)points;
-			p = p * invPoints;
+		/// Extracts the iso surface of a procedural volume, whose voxel (x,y,z)
+		/// is field(x,y,z). Samples are taken lazily while the voxel slices are
+		/// reached, and only in row segments, which the bound can not rule out
+		/// of holding surface. Without a bound all voxels are sampled. The mesh
+		/// is the one of Build on the densely sampled volume, so the cost
+		/// follows the size of the surface instead of the volume. Like streamed
+		/// extractions, field extractions do not compute normals.
+		template<class F>
+		requires std::is_invocable_r_v<VolumeDataType, const F&, int32_t, int32_t, int32_t>
+		[[nodiscard]] MeshType BuildField(
+			const F& field,
+			const RangeBound& bound,
+			const int3& dimension,
+			VolumeDataType iso,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On)
+		{
+			MeshType mesh;
+			BuildField(field, bound, dimension, iso, mesh, topology, manifold);
+			return mesh;
+		}
 
-			v.position = {
-				static_cast<float>(cell[0]) + p[0], 
-				static_cast<float>(cell[1]) + p[1], 
-				static_cast<float>(cell[2]) + p[2]
+		/// Extracts the iso surface of a procedural volume into a caller-owned mesh.
+		template<class F>
+		requires std::is_invocable_r_v<VolumeDataType, const F&, int32_t, int32_t, int32_t>
+		void BuildField(
+			const F& field,
+			const RangeBound& bound,
+			const int3& dimension,
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On)
+		{
+			const RowSampler sampler = [&field](int32_t x, int32_t y, int32_t z, std::span<VolumeDataType> row)
+			{
+				for (size_t i = 0; i < row.size(); ++i)
+				{
+					row[i] = field(x + static_cast<int32_t>(i), y, z);
+				}
 			};
+			BuildField(sampler, bound, dimension, iso, mesh, topology, manifold);
 		}
 
-        /*
-		* Get the shared index of a dual point which is uniquly identified by its
-		* cell cube index and a cube edge. The dual point is computed,
-		* if it has not been computed before.
-        */
-		uint32_t GetSharedDualPointIndex(const int3& cell, Context& ctx, DMCEdgeCode edge)
+		/// Extracts the iso surface of a procedural volume, which is sampled a
+		/// row segment at a time, into a caller-owned mesh.
+		void BuildField(
+			const RowSampler& sampler,
+			const RangeBound& bound,
+			const int3& dimension,
+			VolumeDataType iso,
+			MeshType& mesh,
+			Topology topology = Topology::Triangles,
+			Manifold manifold = Manifold::On)
 		{
-			DualPointKey key{
-				.linearizedCellID = CalculateLinearIndex(cell, ctx.extent),
-				.pointCode = GetDualPointCode(cell, ctx, edge)
-			};
+			assert(!(dimension[0] < 0 || dimension[1] < 0 || dimension[2] < 0) && "Dimension is invalid");
+            assert(sampler && "Row sampler is missing");
 
-            auto [iter, inserted] = ctx.pointToIndex.try_emplace(key, static_cast<uint32_t>(ctx.mesh.vertices.size()));
-            
-            if (inserted) 
+            mesh.vertices.clear();
+            mesh.indices.clear();
+            mesh.normals.clear();
+            const MeshSink sink = [this, &mesh](std::span<const Vertex> vertices, std::span<const IndexType> indices)
             {
-                ctx.mesh.vertices.emplace_back();
-                CalculateDualPoint(cell, ctx,key.pointCode, ctx.mesh.vertices.back());
-            }
-            
-            return iter->second;
+                const std::array<size_t, 2> capacities{mesh.vertices.capacity(), mesh.indices.capacity()};
+                mesh.vertices.insert(mesh.vertices.end(), vertices.begin(), vertices.end());
+                mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+                stats::CountReallocation(passStats, capacities[0], mesh.vertices.capacity());
+                stats::CountReallocation(passStats, capacities[1], mesh.indices.capacity());
+            };
+
+            slabs.resize(1);
+            Context& ctx = slabs.front();
+            InitializeSlab(ctx, VolumeView<VolumeDataType>(nullptr, dimension), iso, topology, manifold, nullptr, {0, 0, 0}, GetCellCount(dimension));
+            ctx.sampler = &sampler;
+            ctx.bound = bound ? &bound : nullptr;
+            ctx.sink = &sink;
+            // the row ranges of the samples are used for skipping cell rows
+            ctx.leader = &ctx;
+
+            passStats = {};
+            stats::ScopedTimer timer(passStats.fillTime);
+            DispatchSlab<Pass::Stream>(ctx);
 		}
-		
-		/// Compute a linearized cell cube index.
-		int32_t CalculateLinearIndex(const int3& cell, const int3& dims) const noexcept
+
+		/// Make a bound of a field, whose samples differ by at most lipschitz
+		/// per voxel of distance, e.g. 1 for a signed distance field in voxel
+		/// units. The field is evaluated once at the center of each box.
+		template<class F>
+		requires std::is_invocable_r_v<VolumeDataType, const F&, int32_t, int32_t, int32_t>
+		[[nodiscard]] static RangeBound LipschitzBound(F field, float lipschitz)
 		{
-			return CalculateLinearIndex(cell[0],cell[1],cell[2], dims);
+			assert(lipschitz >= 0.0f && "Lipschitz constant is negative");
+			return [field = std::move(field), lipschitz](const int3& min, const int3& max) -> Range
+			{
+				int3 center;
+				double distance = 0.0;
+				for (int32_t i = 0; i < 3; ++i)
+				{
+					center[i] = min[i] + (max[i] - min[i]) / 2;
+					double d = double(std::max(center[i] - min[i], max[i] - center[i]));
+					distance += d * d;
+				}
+				const double value = double(field(center[0], center[1], center[2]));
+				const double radius = double(lipschitz) * std::sqrt(distance);
+				return {RoundBound(value - radius, false), RoundBound(value + radius, true)};
+			};
 		}
 
-		int32_t CalculateLinearIndex(int32_t x, int32_t y, int32_t z, const int3& dims) const noexcept
+		/// Select if the extractions into a mesh compute vertex normals, which
+		/// are off by default. They are computed with the dual points, while
+		/// the voxels around them are read anyway, instead of a second pass
+		/// over the mesh. Extractions into caller-owned buffers and streamed
+		/// extractions do not compute normals.
+		void SetNormals(Normals normals) noexcept
 		{
-			return x + dims[0] * (y + dims[1] * z);
+			this->normals = normals;
 		}
 
-		inline std::pair<bool,bool> GetStatus(const Context& ctx,int32_t x, int32_t y, int32_t z, int32_t xOffset, int32_t yOffset, int32_t zOffset) const
+		[[nodiscard]] Normals GetNormals() const noexcept { return normals; }
+
+		/// Select how dual points are placed inside of their cell. The mean of
+		/// the edge intersections is used by default. QEF placement follows
+		/// "Dual Contouring of Hermite Data" from Ju et al. with the gradients at
+		/// the intersections as Hermite normals, placing dual points on the
+		/// edges and corners of sharp features. Each QEF is solved by a fixed
+		/// number of Jacobi sweeps and the result is clamped to the cell, so the
+		/// topology of the mesh is unchanged.
+		void SetPlacement(Placement placement) noexcept
 		{
-            auto vol1 = ctx.volume[CalculateLinearIndex(x, y, z,ctx.extent)];
-            auto vol2 = ctx.volume[CalculateLinearIndex(x + xOffset, y + yOffset, z + zOffset,ctx.extent)];
+			this->placement = placement;
+		}
 
-			bool entering = vol1 >= ctx.iso && vol2 < ctx.iso;
-			bool exiting = vol1 < ctx.iso && vol2 >= ctx.iso;
-			return std::pair(entering, exiting);
+		[[nodiscard]] Placement GetPlacement() const noexcept { return placement; }
+
+		/// Get the statistics of the last extraction, which are all 0 unless
+		/// DUALMC_ENABLE_STATS is defined.
+		[[nodiscard]] ExtractionStats GetStats() const noexcept
+		{
+			ExtractionStats stats = passStats;
+			for (const Context& slab : slabs)
+			{
+				stats += slab.stats;
+			}
+			return stats;
 		}
 
-		void ConstructFace(Context& ctx, bool cond,const std::array<int3, 4>& cells, const std::array<DMCEdgeCode,4>& edges)
+    private:
+        /// Marks an unused dual point slot in a slice.
+        static constexpr IndexType InvalidIndex = std::numeric_limits<IndexType>::max();
+
+        /// Marks a dual point slot of the cells before a slab, whose vertex is
+        /// created by the previous slab. Faces referencing it are patched after
+        /// all slabs are done.
+        static constexpr IndexType SharedIndex = InvalidIndex - 1;
+
+        /// Number of the largest indices reserved for InvalidIndex and SharedIndex.
+        static constexpr size_t ReservedIndexCount = 2;
+
+        /// Extraction is done in two passes. The count pass determines the exact
+        /// number of vertices and indices of each slab without computing dual
+        /// points. The fill pass writes them to the preallocated mesh.
+        /// Streamed extraction is done in a single pass, which passes the
+        /// vertices and indices of each voxel slice to a sink.
+        enum class Pass : uint8_t { Count, Fill, Stream };
+
+        /// Number of voxel slices referenced while constructing the faces of
+        /// voxel slice z, which are the slices z-1 to z+2. The central
+        /// differences of the normals of the cells in slice z-1 also read z-2.
+        static constexpr int32_t VoxelSliceCount = 5;
+
+        /// A cell has at most four dual points. The slot of a dual point is its
+        /// position in the dualPointsList entry of the cell's cube code.
+        static constexpr int32_t SlotsPerCell = 4;
+
+        /// Cube codes of a slice of cells.
+        struct CodeSlice
         {
-            uint32_t i0 = GetSharedDualPointIndex(cells[0], ctx, edges[0]);
-            uint32_t i1 = GetSharedDualPointIndex(cells[1], ctx, edges[1]);
-            uint32_t i2 = GetSharedDualPointIndex(cells[2], ctx, edges[2]);
-            uint32_t i3 = GetSharedDualPointIndex(cells[3], ctx, edges[3]);
+            std::vector<uint8_t> codes;
+            /// false if no cell of the slice holds surface, all codes are 0 then
+            bool active = true;
+        };
 
-            if (cond)
-            {
-                if(ctx.topology == Topology::Quads)
-                {
-                    ctx.mesh.indices.insert(ctx.mesh.indices.end(), {i0, i1, i2, i3});
-                }
-                else 
-                {
-                    ctx.mesh.indices.insert(ctx.mesh.indices.end(), {i0, i1, i2, i2, i3, i0});
-                }
-            }
-            else
-            {
-                if(ctx.topology == Topology::Quads)
+        /// Dual point placed by QEF and its output vertex and normal.
+        struct QefPoint
+        {
+            qef::Qef qef;
+            int3 cell;
+            size_t vertex;
+            float3* normal;
+        };
+
+        struct Context
+        {
+            VolumeView<VolumeDataType> volume;
+            int3 extent;
+            VolumeDataType iso;
+            Topology topology;
+            Manifold manifold;
+            /// optional value ranges for skipping empty bricks
+            const MinMaxPyramid<VolumeDataType>* pyramid = nullptr;
+            /// Voxel slices z-2 to z+2 of the current z step, indexed by z modulo
+            /// VoxelSliceCount. They point into volume or into sliceStorage.
+            std::array<const VolumeDataType*, VoxelSliceCount> voxelSlices{};
+            /// next voxel slice to be fetched
+            int32_t nextVoxelSlice = 0;
+            /// Distance between the voxel rows of a slice. Rows of views with
+            /// adjacent voxels are read in place, all others are gathered into
+            /// dense slices.
+            ptrdiff_t voxelRowStride = 0;
+            /// Fetches the voxel slices of a streamed volume. Without a source,
+            /// the slices are taken from volume.
+            const SliceSource* source = nullptr;
+            std::array<std::vector<VolumeDataType>, VoxelSliceCount> sliceStorage;
+            /// bricked volume, whose slices are gathered instead of volume
+            const BrickedVolume<VolumeDataType>* bricked = nullptr;
+            /// Samples a procedural volume instead of volume. The optional bound
+            /// rules out row segments, which are not sampled.
+            const RowSampler* sampler = nullptr;
+            const RangeBound* bound = nullptr;
+            /// Context of the first iso value of a lockstep extraction of several
+            /// iso values, which is set for all of its contexts. The others share
+            /// the voxel slices of the leader instead of fetching them again.
+            /// Procedural volumes are their own leader for skipping cell rows.
+            const Context* leader = nullptr;
+            /// Value ranges of the voxel rows of the slices, which are computed
+            /// by the leader of a lockstep extraction. Cell rows, whose corners
+            /// do not straddle the iso value of a context, are not classified.
+            std::array<std::vector<typename MinMaxPyramid<VolumeDataType>::Range>, VoxelSliceCount> rowRanges;
+            /// receives the vertices and indices of each voxel slice in the stream pass
+            const MeshSink* sink = nullptr;
+            std::vector<Vertex> streamVertices;
+            std::vector<IndexType> streamIndices;
+            /// Faces of voxel slice z only reference dual points of the cells in
+            /// the slices z and z-1. Shared vertex indices are therefore kept in
+            /// two dense slices of SlotsPerCell slots per cell, which are swapped
+            /// every z step.
+            std::vector<IndexType> previousSlice;
+            std::vector<IndexType> currentSlice;
+            /// Assigned slots of the two slices. Only these are reset when a
+            /// slice is reused, so sparse surfaces do not clear whole slices.
+            std::vector<size_t> previousSlots;
+            std::vector<size_t> currentSlots;
+            /// z coordinate of the cells in currentSlice
+            int32_t currentZ = 0;
+            /// Cube codes of the cell slices z-1, z and z+1. Each cell is classified
+            /// once and read for face construction and the manifold test.
+            std::array<CodeSlice, 3> cubeCodes;
+            /// Cube codes of the cell slices z-1 and z after the manifold test,
+            /// which are used for looking up dual points.
+            std::vector<uint8_t> previousDualCodes;
+            std::vector<uint8_t> currentDualCodes;
+            /// Region and row length of the cube code slices. They hold the cells
+            /// read by the manifold test of the referenced cells, which extends
+            /// the region of the face cells by two cells below and one above.
+            int3 codeBegin{0, 0, 0};
+            int3 codeEnd{0, 0, 0};
+            int32_t codeStride = 0;
+            /// inside masks of the voxel rows needed for classifying a cell row
+            std::vector<uint8_t> insideRows;
+            /// Vertex indices of the cells right before a slab, which are shared
+            /// with the previous slab. Recorded by the count pass for slabs not
+            /// starting at 0 and turned into the initial slice of the fill pass.
+            std::vector<IndexType> seamSlice;
+            /// faces of the cells in [cellBegin,cellEnd) are constructed
+            int3 cellBegin{0, 0, 0};
+            int3 cellEnd{0, 0, 0};
+            /// First cell and row length of the dual point slot slices. They hold
+            /// the cells referenced by the faces, which extends the region of the
+            /// face cells by one cell below.
+            int3 slotBegin{0, 0, 0};
+            int32_t slotStride = 0;
+            /// Number of cells along each axis, whose cube codes can be computed
+            /// from the voxels, and the offset added to the cell coordinates
+            /// of the vertices. Chunks set them for their padded voxel block.
+            int3 cellCount{0, 0, 0};
+            int3 cellOffset{0, 0, 0};
+            /// dual point placement and the dual points of the current voxel
+            /// slice, whose QEF is not solved yet
+            Placement placement = Placement::Mean;
+            std::vector<QefPoint> qefPoints;
+            /// output buffers of the fill pass. Normals are only computed if
+            /// normals is set.
+            Vertex* vertices = nullptr;
+            IndexType* indices = nullptr;
+            float3* normals = nullptr;
+            /// cells and slots of the vertices, only written if set
+            DualPointId* dualPoints = nullptr;
+            /// Next vertex index and index buffer position. They start at the
+            /// offsets of the slab in the fill pass and at 0 in the count pass.
+            size_t vertexCount = 0;
+            size_t indexCount = 0;
+            /// index buffer positions and slots of face corners referencing
+            /// shared dual points of the previous slab
+            std::vector<std::pair<size_t, size_t>> seamFixups;
+            /// counters and timings of the slab
+            ExtractionStats stats;
+        };
+
+        /// Lookup tables of (manifold) dual marching cubes, which are shared with
+        /// the compute shaders.
+        using DMCEdgeCode = tables::DMCEdgeCode;
+        using enum tables::DMCEdgeCode;
+        static constexpr const auto& dualPointsList = tables::dualPointsList;
+        static constexpr const auto& problematicConfigs = tables::problematicConfigs;
+
+		static void AssertArguments(
+			[[maybe_unused]] const std::span<const VolumeDataType>& data,
+			[[maybe_unused]] const int3& dimension) noexcept
+		{
+			assert(!(dimension[0] < 0 || dimension[1] < 0 || dimension[2] < 0) && "Dimension is invalid");
+            assert(!data.empty() && "Volume data is empty");
+            assert(data.size() >= size_t(dimension[0]) * size_t(dimension[1]) * size_t(dimension[2]) && "Volume data is smaller than extent");
+		}
+
+		static void AssertArguments(
+			[[maybe_unused]] const VolumeView<VolumeDataType>& volume,
+			[[maybe_unused]] const MinMaxPyramid<VolumeDataType>* pyramid) noexcept
+		{
+			assert(!(volume.extent[0] < 0 || volume.extent[1] < 0 || volume.extent[2] < 0) && "Dimension is invalid");
+            assert(volume.data != nullptr && "Volume data is empty");
+            assert((pyramid == nullptr || pyramid->Extent() == volume.extent) && "Pyramid does not match the volume");
+		}
+
+		static void AssertArguments(
+			[[maybe_unused]] const BrickedVolume<VolumeDataType>& volume,
+			[[maybe_unused]] const MinMaxPyramid<VolumeDataType>* pyramid) noexcept
+		{
+            assert((pyramid == nullptr || pyramid->Extent() == volume.Extent()) && "Pyramid does not match the volume");
+		}
+
+		/// Number of z-slabs for threadCount worker threads. A threadCount of 0
+		/// uses the number of hardware threads.
+		static int32_t GetSlabCount(const int3& cellCount, uint32_t threadCount) noexcept
+		{
+            if (threadCount == 0)
+            {
+                threadCount = std::max(1u, std::thread::hardware_concurrency());
+            }
+            return std::clamp<int32_t>(static_cast<int32_t>(std::min<uint32_t>(threadCount, 1u << 16)), 1, std::max(cellCount[2], 1));
+		}
+
+		/// Clamp the region [cellBegin,cellEnd) to the cells of a volume.
+		static std::pair<int3, int3> ClampRegion(const int3& dimension, const int3& cellBegin, const int3& cellEnd) noexcept
+		{
+            int3 cellCount = GetCellCount(dimension);
+            int3 begin;
+            int3 end;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                begin[i] = std::clamp(cellBegin[i], 0, cellCount[i]);
+                end[i] = std::clamp(cellEnd[i], begin[i], cellCount[i]);
+            }
+            return {begin, end};
+		}
+
+		/// Number of cells along each axis, whose faces are constructed.
+		static int3 GetCellCount(const int3& dimension) noexcept
+		{
+            return {std::max(dimension[0] - 4, 0), std::max(dimension[1] - 4, 0), std::max(dimension[2] - 4, 0)};
+		}
+
+		/// Reset a slab context for extracting the faces of the cells in
+		/// [cellBegin,cellEnd).
+		void InitializeSlab(
+			Context& slab,
+			const VolumeView<VolumeDataType>& volume,
+			VolumeDataType iso,
+			Topology topology,
+			Manifold manifold,
+			const MinMaxPyramid<VolumeDataType>* pyramid,
+			const int3& cellBegin,
+			const int3& cellEnd) noexcept
+		{
+            slab.volume = volume;
+            slab.extent = volume.extent;
+            slab.iso = iso;
+            slab.topology = topology;
+            slab.manifold = manifold;
+            slab.pyramid = pyramid;
+            slab.source = nullptr;
+            slab.bricked = nullptr;
+            slab.sampler = nullptr;
+            slab.bound = nullptr;
+            slab.leader = nullptr;
+            slab.sink = nullptr;
+            slab.normals = nullptr;
+            slab.dualPoints = nullptr;
+            slab.placement = placement;
+            slab.qefPoints.clear();
+            slab.cellBegin = cellBegin;
+            slab.cellEnd = cellEnd;
+            slab.cellCount = GetCellCount(volume.extent);
+            slab.cellOffset = {0, 0, 0};
+            slab.vertexCount = 0;
+            slab.indexCount = 0;
+            slab.seamSlice.clear();
+            slab.stats = {};
+		}
+
+		/// Split the cells in [cellBegin,cellEnd) into slabCount z-slabs and run
+		/// the count pass on them.
+		MeshSize CountSlabs(
+			const VolumeView<VolumeDataType>& volume,
+			VolumeDataType iso,
+			Topology topology,
+			Manifold manifold,
+			const MinMaxPyramid<VolumeDataType>* pyramid,
+			const int3& cellBegin,
+			const int3& cellEnd,
+			int32_t slabCount)
+		{
+            SplitSlabs(volume, iso, topology, manifold, pyramid, cellBegin, cellEnd, slabCount);
+            return CountSlabs();
+		}
+
+		/// Split the cells of a bricked volume in [cellBegin,cellEnd) into
+		/// slabCount z-slabs and run the count pass on them.
+		MeshSize CountSlabs(
+			const BrickedVolume<VolumeDataType>& volume,
+			VolumeDataType iso,
+			Topology topology,
+			Manifold manifold,
+			const MinMaxPyramid<VolumeDataType>* pyramid,
+			const int3& cellBegin,
+			const int3& cellEnd,
+			int32_t slabCount)
+		{
+            SplitSlabs(VolumeView<VolumeDataType>(nullptr, volume.Extent()), iso, topology, manifold, pyramid, cellBegin, cellEnd, slabCount);
+            for (Context& slab : slabs)
+            {
+                slab.bricked = &volume;
+            }
+            return CountSlabs();
+		}
+
+		/// Split the cells in [cellBegin,cellEnd) into slabCount z-slabs.
+		void SplitSlabs(
+			const VolumeView<VolumeDataType>& volume,
+			VolumeDataType iso,
+			Topology topology,
+			Manifold manifold,
+			const MinMaxPyramid<VolumeDataType>* pyramid,
+			const int3& cellBegin,
+			const int3& cellEnd,
+			int32_t slabCount)
+		{
+            int64_t depth = std::max(cellEnd[2] - cellBegin[2], 0);
+            // contexts are kept, so their buffers are reused by the next call
+            slabs.resize(slabCount);
+            for (int32_t i = 0; i < slabCount; ++i)
+            {
+                int3 slabBegin = cellBegin;
+                int3 slabEnd = cellEnd;
+                slabBegin[2] = cellBegin[2] + static_cast<int32_t>((depth * i) / slabCount);
+                slabEnd[2] = cellBegin[2] + static_cast<int32_t>((depth * (i + 1)) / slabCount);
+                InitializeSlab(slabs[i], volume, iso, topology, manifold, pyramid, slabBegin, slabEnd);
+            }
+		}
+
+		/// Run the count pass on the split slabs. The counts are turned into
+		/// prefix-summed write offsets of the slabs and the total size of the
+		/// mesh is returned.
+		MeshSize CountSlabs()
+		{
+            DUALMC_ZONE("dualmc::CountSlabs");
+            passStats = {};
+            {
+                stats::ScopedTimer timer(passStats.countTime);
+                RunSlabs<Pass::Count>();
+            }
+
+            const size_t slabCount = slabs.size();
+
+            // A seam dual point referenced by both neighboring slabs is created by
+            // the earlier one. Mark it as shared in the initial slice of the later one.
+            MeshSize size;
+            for (size_t i = 0; i < slabCount; ++i)
+            {
+                Context& slab = slabs[i];
+                size_t sharedCount = 0;
+                if (i == 0)
+                {
+                    // the cells before the first slab are not shared
+                    slab.seamSlice.clear();
+                }
+                else if (!slab.seamSlice.empty())
+                {
+                    const std::vector<IndexType>& previousSlice = slabs[i - 1].currentSlice;
+                    for (size_t slot = 0; slot < slab.seamSlice.size(); ++slot)
+                    {
+                        bool shared = slab.seamSlice[slot] != InvalidIndex && previousSlice[slot] != InvalidIndex;
+                        sharedCount += shared ? 1 : 0;
+                        slab.seamSlice[slot] = shared ? SharedIndex : InvalidIndex;
+                    }
+                }
+
+                size_t slabVertexCount = slab.vertexCount - sharedCount;
+                size_t slabIndexCount = slab.indexCount;
+                slab.vertexCount = size.vertexCount;
+                slab.indexCount = size.indexCount;
+                size.vertexCount += slabVertexCount;
+                size.indexCount += slabIndexCount;
+            }
+            CheckVertexCount<IndexType>(size.vertexCount, ReservedIndexCount);
+            countedSize = size;
+            return size;
+		}
+
+		/// Resize the mesh to the counted size and fill it. Normals are only
+		/// kept if they are enabled.
+		void FillSlabs(MeshType& mesh)
+		{
+			ResizeMesh(mesh, countedSize.vertexCount, countedSize.indexCount);
+			FillSlabs(mesh.vertices.data(), mesh.indices.data(), normals == Normals::On ? mesh.normals.data() : nullptr);
+		}
+
+		/// Run the fill pass of the counted slabs, writing to buffers which are
+		/// large enough for the counted size. Without a normal buffer no
+		/// normals are computed.
+		void FillSlabs(Vertex* vertices, IndexType* indices, float3* vertexNormals = nullptr)
+		{
+            DUALMC_ZONE("dualmc::FillSlabs");
+            stats::ScopedTimer timer(passStats.fillTime);
+            for (Context& slab : slabs)
+            {
+                slab.vertices = vertices;
+                slab.indices = indices;
+                slab.normals = vertexNormals;
+            }
+
+            RunSlabs<Pass::Fill>();
+
+            // patch the face corners referencing dual points of the previous slab
+            for (size_t i = 1; i < slabs.size(); ++i)
+            {
+                const std::vector<IndexType>& previousSlice = slabs[i - 1].currentSlice;
+                for (const auto& [position, slot] : slabs[i].seamFixups)
+                {
+                    indices[position] = previousSlice[slot];
+                }
+            }
+		}
+
+		/// Resize the buffers of a mesh for the given counts. Normals are only
+		/// kept if they are enabled.
+		void ResizeMesh(MeshType& mesh, size_t vertexCount, size_t indexCount)
+		{
+			const std::array<size_t, 3> capacities{mesh.vertices.capacity(), mesh.indices.capacity(), mesh.normals.capacity()};
+			mesh.vertices.resize(vertexCount);
+			mesh.indices.resize(indexCount);
+			mesh.normals.resize(normals == Normals::On ? vertexCount : 0);
+			stats::CountReallocation(passStats, capacities[0], mesh.vertices.capacity());
+			stats::CountReallocation(passStats, capacities[1], mesh.indices.capacity());
+			stats::CountReallocation(passStats, capacities[2], mesh.normals.capacity());
+		}
+
+		/// Run a pass for all slabs, on a worker thread per slab if there are several.
+		template<Pass P>
+		void RunSlabs()
+		{
+            if (slabs.size() == 1)
+            {
+                DispatchSlab<P>(slabs.front());
+                return;
+            }
+
+            std::vector<std::jthread> workers;
+            workers.reserve(slabs.size());
+            for (Context& slab : slabs)
+            {
+                workers.emplace_back([this, &slab]()
+                {
+                    DispatchSlab<P>(slab);
+                });
+            }
+		}
+
+		/// Run a pass for a slab with the face construction specialized for its
+		/// manifold mode and topology.
+		template<Pass P>
+		void DispatchSlab(Context& ctx)
+		{
+            DispatchSlab<P>(std::span<Context>(&ctx, 1));
+		}
+
+		/// Run a pass for slabs of the same region, manifold mode and topology,
+		/// which advance through the volume in lockstep.
+		template<Pass P>
+		void DispatchSlab(std::span<Context> contexts)
+		{
+            DUALMC_ZONE("dualmc::Slab");
+            const Context& ctx = contexts.front();
+            if (ctx.manifold == Manifold::On)
+            {
+                if (ctx.topology == Topology::Quads)
+                    BuildSlab<P, Manifold::On, Topology::Quads>(contexts);
+                else
+                    BuildSlab<P, Manifold::On, Topology::Triangles>(contexts);
+            }
+            else
+            {
+                if (ctx.topology == Topology::Quads)
+                    BuildSlab<P, Manifold::Off, Topology::Quads>(contexts);
+                else
+                    BuildSlab<P, Manifold::Off, Topology::Triangles>(contexts);
+            }
+		}
+
+		/// Construct the faces of the cells in [cellBegin,cellEnd) of each
+		/// context. The contexts take their z steps in turn, so the voxel slices
+		/// of a step are read by all of them while they are in the cache.
+		template<Pass P, Manifold M, Topology Topo>
+		void BuildSlab(std::span<Context> contexts)
+		{
+			for (Context& ctx : contexts)
+			{
+				if (!BeginSlab<P, M>(ctx))
+					return;
+			}
+
+			for (int32_t z = contexts.front().cellBegin[2]; z < contexts.front().cellEnd[2]; ++z)
+			{
+				for (Context& ctx : contexts)
+				{
+					StepSlab<P, M, Topo>(ctx, z);
+				}
+			}
+		}
+
+		/// Prepare the slices of a context for constructing the faces of the
+		/// cells in [cellBegin,cellEnd). Faces in the first slice reference dual
+		/// points of the cells in slice zBegin-1. Without the manifold test, dual
+		/// points are looked up with the cube codes themselves and no dual code
+		/// slices are resolved. Returns false if the region is empty.
+		template<Pass P, Manifold M>
+		bool BeginSlab(Context& ctx)
+		{
+			const int3 cellCount = ctx.cellCount;
+			const int3 cellBegin = ctx.cellBegin;
+			const int3 cellEnd = ctx.cellEnd;
+			const int32_t zBegin = cellBegin[2];
+			const int32_t zEnd = cellEnd[2];
+			if (cellBegin[0] >= cellEnd[0] || cellBegin[1] >= cellEnd[1] || zBegin >= zEnd)
+				return false;
+
+			// Faces reference the dual points of the cells at offset -1, whose
+			// manifold test reads the cube codes of their neighbors.
+			for (int32_t i = 0; i < 2; ++i)
+			{
+				ctx.slotBegin[i] = std::max(cellBegin[i] - 1, 0);
+				ctx.codeBegin[i] = std::max(cellBegin[i] - 2, 0);
+				ctx.codeEnd[i] = std::min(cellEnd[i] + 1, cellCount[i] + 1);
+			}
+			ctx.slotStride = cellEnd[0] - ctx.slotBegin[0];
+			size_t sliceSize = size_t(ctx.slotStride) * size_t(cellEnd[1] - ctx.slotBegin[1]) * SlotsPerCell;
+			ctx.previousSlots.clear();
+			ctx.currentSlots.clear();
+			if (P == Pass::Fill && !ctx.seamSlice.empty())
+			{
+				std::swap(ctx.previousSlice, ctx.seamSlice);
+				for (size_t slot = 0; slot < ctx.previousSlice.size(); ++slot)
+				{
+					if (ctx.previousSlice[slot] != InvalidIndex)
+					{
+						ctx.previousSlots.push_back(slot);
+					}
+				}
+			}
+			else
+			{
+				ctx.previousSlice.assign(sliceSize, InvalidIndex);
+			}
+			ctx.currentSlice.assign(sliceSize, InvalidIndex);
+			ctx.seamFixups.clear();
+			ctx.nextVoxelSlice = std::max(zBegin - 3, 0);
+			ctx.voxelRowStride = ctx.source == nullptr && ctx.bricked == nullptr && ctx.sampler == nullptr && ctx.volume.IsRowContiguous() ? ctx.volume.strides[1] : ptrdiff_t(ctx.extent[0]);
+
+			// The cube code slices of the whole volume also hold the cells at
+			// x = cellCount[0] and y = cellCount[1], which are neighbors in the
+			// manifold test.
+			ctx.codeStride = ctx.codeEnd[0] - ctx.codeBegin[0];
+			size_t codeSliceSize = size_t(ctx.codeStride) * size_t(ctx.codeEnd[1] - ctx.codeBegin[1]);
+			for (auto& slice : ctx.cubeCodes)
+			{
+				slice.codes.assign(codeSliceSize, 0);
+			}
+			if constexpr (M == Manifold::On)
+			{
+				ctx.previousDualCodes.assign(codeSliceSize, 0);
+				ctx.currentDualCodes.assign(codeSliceSize, 0);
+			}
+
+			// classify the cells before the slab. Only the dual codes of slice
+			// zBegin-1 are needed, which are never referenced for zBegin = 0.
+			if (zBegin > 0)
+			{
+				ClassifySlice(ctx, zBegin - 2, ctx.cubeCodes[1]);
+				ClassifySlice(ctx, zBegin - 1, ctx.cubeCodes[2]);
+			}
+			return true;
+		}
+
+		/// Construct the faces of the cells of slice z, which follows the
+		/// previous step or is the first slice of the slab.
+		template<Pass P, Manifold M, Topology Topo>
+		void StepSlab(Context& ctx, int32_t z)
+		{
+			const int3 cellBegin = ctx.cellBegin;
+			const int3 cellEnd = ctx.cellEnd;
+			const int32_t zBegin = cellBegin[2];
+
+			// advance the cube code slices such that they hold the cells z-1, z and z+1
+			std::rotate(ctx.cubeCodes.begin(), ctx.cubeCodes.begin() + 1, ctx.cubeCodes.end());
+			if (z == zBegin)
+			{
+				if (zBegin > 0)
+				{
+					ClassifySlice(ctx, z, ctx.cubeCodes[2]);
+					if constexpr (M == Manifold::On)
+					{
+						ResolveSlice<P>(ctx, z - 1, ctx.previousDualCodes);
+					}
+					std::rotate(ctx.cubeCodes.begin(), ctx.cubeCodes.begin() + 1, ctx.cubeCodes.end());
+				}
+				else
+				{
+					ClassifySlice(ctx, z, ctx.cubeCodes[1]);
+				}
+			}
+			else if constexpr (M == Manifold::On)
+			{
+				std::swap(ctx.previousDualCodes, ctx.currentDualCodes);
+			}
+			ClassifySlice(ctx, z + 1, ctx.cubeCodes[2]);
+			if constexpr (M == Manifold::On)
+			{
+				ResolveSlice<P>(ctx, z, ctx.currentDualCodes);
+			}
+
+			// advance the shared vertex slices
+			if (z > zBegin)
+			{
+				std::swap(ctx.previousSlice, ctx.currentSlice);
+				std::swap(ctx.previousSlots, ctx.currentSlots);
+				for (size_t slot : ctx.currentSlots)
+				{
+					ctx.currentSlice[slot] = InvalidIndex;
+				}
+				ctx.currentSlots.clear();
+			}
+			ctx.currentZ = z;
+
+			// cells of empty slices neither emit faces nor are referenced by faces
+			const std::vector<uint8_t>& codes = ctx.cubeCodes[1].codes;
+			for (int32_t y = cellBegin[1]; y < cellEnd[1] && ctx.cubeCodes[1].active; ++y)
+			{
+				if (!IsCellRowActive(ctx, y, z))
+					continue;
+
+				if constexpr (StatsEnabled && P != Pass::Fill)
+				{
+					ctx.stats.visitedCells += uint64_t(cellEnd[0] - cellBegin[0]);
+				}
+				const uint8_t* row = &codes[GetCodeOffset(ctx, cellBegin[0], y)];
+				for (int32_t x = cellBegin[0]; x < cellEnd[0]; ++x) 
+				{
+					// The edges starting at the voxel (x,y,z) are edges of cell
+					// (x,y,z). Corner 0 is the voxel itself, while the corners 1, 2
+					// and 4 are its neighbors in x, y and z direction. Their bits
+					// in the cube code are 2, 4 and 16.
+					int32_t cubeCode = row[x - cellBegin[0]];
+					if (cubeCode == 0 || cubeCode == 255)
+						continue;
+
+					if constexpr (StatsEnabled && P != Pass::Fill)
+					{
+						++ctx.stats.activeCells;
+					}
+
+					// construct quads for x edge
+					if (z > 0 && y > 0) 
+					{
+						auto [entering, exiting] = GetStatus(cubeCode, 2);
+						if (entering || exiting) 
+						{
+							if constexpr (StatsEnabled && P != Pass::Fill)
+							{
+								++ctx.stats.faces[0];
+							}
+							ConstructFace<P, M, Topo>(
+								ctx,
+                                entering,
+                                {
+                                    int3{x, y, z}, 
+                                    int3{x, y, z - 1}, 
+                                    int3{x, y - 1, z - 1}, 
+                                    int3{x, y - 1, z}
+                                },
+                                {EDGE0,EDGE2,EDGE6,EDGE4}
+                            );
+						}
+					}
+
+					// construct quads for y edge
+					if (z > 0 && x > 0) 
+					{
+						auto [entering, exiting] = GetStatus(cubeCode, 4);
+						if (entering || exiting) 
+						{
+							if constexpr (StatsEnabled && P != Pass::Fill)
+							{
+								++ctx.stats.faces[1];
+							}
+							ConstructFace<P, M, Topo>(
+                                ctx,
+                                exiting,
+                                {
+                                    int3{x, y, z}, 
+                                    int3{x, y, z - 1}, 
+                                    int3{x - 1, y, z - 1}, 
+                                    int3{x - 1, y, z}
+                                },
+                                {EDGE8,EDGE11,EDGE10,EDGE9}
+                            );
+						}
+					}
+
+					// construct quads for z edge
+					if (x > 0 && y > 0) 
+					{
+						auto [entering, exiting] = GetStatus(cubeCode, 16);
+						if (entering || exiting) 
+						{
+							if constexpr (StatsEnabled && P != Pass::Fill)
+							{
+								++ctx.stats.faces[2];
+							}
+							ConstructFace<P, M, Topo>(
+                                ctx,
+                                exiting,
+                                {
+                                    int3{x, y, z}, 
+                                    {x - 1, y, z}, 
+                                    {x - 1, y - 1, z}, 
+                                    int3{x, y - 1, z}
+                                },
+                                {EDGE3,EDGE1,EDGE5,EDGE7}
+                            );
+						}
+					}
+				}
+			}
+
+			// the cells before the slab are shared with the previous slab
+			if (P == Pass::Count && z == zBegin && zBegin > 0)
+			{
+				ctx.seamSlice = ctx.previousSlice;
+			}
+
+			if constexpr (P != Pass::Count)
+			{
+				if (!ctx.qefPoints.empty())
+				{
+					PlaceQefPoints<P>(ctx);
+				}
+			}
+
+			if constexpr (P == Pass::Stream)
+			{
+				FlushStream(ctx);
+			}
+		}
+
+		/// Pass the vertices and indices of the last voxel slice to the sink.
+		void FlushStream(Context& ctx) const
+		{
+			if (ctx.streamVertices.empty() && ctx.streamIndices.empty())
+				return;
+
+			DUALMC_ZONE("dualmc::FlushStream");
+
+			(*ctx.sink)(ctx.streamVertices, ctx.streamIndices);
+			ctx.streamVertices.clear();
+			ctx.streamIndices.clear();
+		}
+
+		/// Make the voxel slices up to z available in ctx.voxelSlices. Slices are
+		/// fetched in ascending order, replacing the slice VoxelSliceCount below.
+		void RequireVoxelSlices(Context& ctx, int32_t z) const
+		{
+			z = std::min(z, ctx.extent[2] - 1);
+			const size_t sliceSize = size_t(ctx.extent[0]) * size_t(ctx.extent[1]);
+			for (; ctx.nextVoxelSlice <= z; ++ctx.nextVoxelSlice)
+			{
+				const int32_t slice = ctx.nextVoxelSlice;
+				const VolumeDataType*& voxels = ctx.voxelSlices[slice % VoxelSliceCount];
+				if (ctx.leader != nullptr && ctx.leader != &ctx)
+				{
+					// the leader takes its z step first, so it holds the slice already
+					voxels = ctx.leader->voxelSlices[slice % VoxelSliceCount];
+					continue;
+				}
+
+				if (ctx.source == nullptr && ctx.bricked == nullptr && ctx.sampler == nullptr && ctx.volume.IsRowContiguous())
+				{
+					voxels = ctx.volume.Row(0, slice);
+				}
+				else
+				{
+					std::vector<VolumeDataType>& storage = ctx.sliceStorage[slice % VoxelSliceCount];
+					storage.resize(sliceSize);
+					if (ctx.source != nullptr)
+					{
+						(*ctx.source)(slice, std::span<VolumeDataType>(storage));
+					}
+					else if (ctx.sampler != nullptr)
+					{
+						// the row ranges are taken while sampling
+						voxels = storage.data();
+						SampleSlice(ctx, slice, storage);
+						continue;
+					}
+					else
+					{
+						GatherSlice(ctx, slice, storage);
+					}
+					voxels = storage.data();
+				}
+
+				if (ctx.leader == &ctx)
+				{
+					ComputeRowRanges(ctx, slice);
+				}
+			}
+		}
+
+		/// Compute the value ranges of the voxel rows of slice z, which are read
+		/// for the cube code region.
+		static void ComputeRowRanges(Context& ctx, int32_t z) noexcept
+		{
+			const int32_t xEnd = std::min(ctx.codeEnd[0] + 1, ctx.extent[0]);
+			const int32_t yEnd = std::min(ctx.codeEnd[1] + 1, ctx.extent[1]);
+			const VolumeDataType* voxels = ctx.voxelSlices[z % VoxelSliceCount];
+			auto& ranges = ctx.rowRanges[z % VoxelSliceCount];
+			ranges.resize(size_t(ctx.extent[1]));
+			for (int32_t y = ctx.codeBegin[1]; y < yEnd; ++y)
+			{
+				const VolumeDataType* row = voxels + ptrdiff_t(y) * ctx.voxelRowStride;
+				VolumeDataType minimum = row[ctx.codeBegin[0]];
+				VolumeDataType maximum = minimum;
+				for (int32_t x = ctx.codeBegin[0] + 1; x < xEnd; ++x)
+				{
+					minimum = std::min(minimum, row[x]);
+					maximum = std::max(maximum, row[x]);
+				}
+				ranges[y] = {minimum, maximum};
+			}
+		}
+
+		/// Row segments of a procedural volume, whose bound straddles the iso
+		/// value, are halved down to MinSegmentSize voxels.
+		static constexpr int32_t MaxSegmentSize = 64;
+		static constexpr int32_t MinSegmentSize = 8;
+
+		/// Sample slice z of a procedural volume in the cube code region and
+		/// compute the value ranges of its rows. A voxel is read by a cell
+		/// holding surface only if all corners of the cell are within two
+		/// voxels of it, as the normals and QEFs read the central differences
+		/// at the corners. Voxels of the slice, row or row segment, whose
+		/// surrounding box of two voxels does not straddle the iso value, are
+		/// therefore set to the bound on their side of the iso value instead,
+		/// which keeps the cube codes of the cells reading them.
+		static void SampleSlice(Context& ctx, int32_t z, std::vector<VolumeDataType>& slice)
+		{
+			const int32_t xBegin = ctx.codeBegin[0];
+			const int32_t xEnd = std::min(ctx.codeEnd[0] + 1, ctx.extent[0]);
+			const int32_t yEnd = std::min(ctx.codeEnd[1] + 1, ctx.extent[1]);
+			auto& ranges = ctx.rowRanges[z % VoxelSliceCount];
+			ranges.resize(size_t(ctx.extent[1]));
+
+			VolumeDataType value;
+			if (!IsBoundActive(ctx, {xBegin, ctx.codeBegin[1], z}, {xEnd - 1, yEnd - 1, z}, value))
+			{
+				for (int32_t y = ctx.codeBegin[1]; y < yEnd; ++y)
+				{
+					std::fill(slice.begin() + ptrdiff_t(y) * ctx.extent[0] + xBegin, slice.begin() + ptrdiff_t(y) * ctx.extent[0] + xEnd, value);
+					ranges[y] = {value, value};
+				}
+				return;
+			}
+
+			for (int32_t y = ctx.codeBegin[1]; y < yEnd; ++y)
+			{
+				VolumeDataType* row = slice.data() + ptrdiff_t(y) * ctx.extent[0];
+				if (!IsBoundActive(ctx, {xBegin, y, z}, {xEnd - 1, y, z}, value))
+				{
+					std::fill(row + xBegin, row + xEnd, value);
+					ranges[y] = {value, value};
+					continue;
+				}
+
+				for (int32_t x = xBegin; x < xEnd; x += MaxSegmentSize)
+				{
+					SampleSegment(ctx, x, std::min(x + MaxSegmentSize, xEnd), y, z, row);
+				}
+				const auto [minimum, maximum] = std::minmax_element(row + xBegin, row + xEnd);
+				ranges[y] = {*minimum, *maximum};
+			}
+		}
+
+		/// Sample the voxels [xBegin,xEnd) of row (y,z), which are not ruled out
+		/// by the bound of the segment or of its halves.
+		static void SampleSegment(const Context& ctx, int32_t xBegin, int32_t xEnd, int32_t y, int32_t z, VolumeDataType* row)
+		{
+			VolumeDataType value;
+			if (!IsBoundActive(ctx, {xBegin, y, z}, {xEnd - 1, y, z}, value))
+			{
+				std::fill(row + xBegin, row + xEnd, value);
+			}
+			else if (xEnd - xBegin <= MinSegmentSize || ctx.bound == nullptr)
+			{
+				(*ctx.sampler)(xBegin, y, z, std::span<VolumeDataType>(row + xBegin, size_t(xEnd - xBegin)));
+			}
+			else
+			{
+				const int32_t xMiddle = xBegin + (xEnd - xBegin) / 2;
+				SampleSegment(ctx, xBegin, xMiddle, y, z, row);
+				SampleSegment(ctx, xMiddle, xEnd, y, z, row);
+			}
+		}
+
+		/// Check if the bound of the voxels within two voxels of the inclusive
+		/// box [min,max] straddles the iso value. Otherwise the bound on the side
+		/// of the iso value is returned in value.
+		static bool IsBoundActive(const Context& ctx, const int3& min, const int3& max, VolumeDataType& value)
+		{
+			if (ctx.bound == nullptr)
+				return true;
+
+			int3 lower;
+			int3 upper;
+			for (int32_t i = 0; i < 3; ++i)
+			{
+				lower[i] = std::max(min[i] - 2, 0);
+				upper[i] = std::min(max[i] + 2, ctx.extent[i] - 1);
+			}
+			const Range range = (*ctx.bound)(lower, upper);
+			if (MinMaxPyramid<VolumeDataType>::IsActive(range, ctx.iso))
+				return true;
+
+			value = range.min >= ctx.iso ? range.min : range.max;
+			return false;
+		}
+
+		/// Convert a bound to the voxel type, rounding it away from the values
+		/// it bounds.
+		static VolumeDataType RoundBound(double value, bool upper) noexcept
+		{
+			constexpr double lowest = double(VoxelLimits<VolumeDataType>::lowest());
+			constexpr double highest = double(VoxelLimits<VolumeDataType>::max());
+			if constexpr (std::is_integral_v<VolumeDataType>)
+			{
+				value = upper ? std::ceil(value) : std::floor(value);
+				if (value <= lowest)
+					return VoxelLimits<VolumeDataType>::lowest();
+				if (value >= highest)
+					return VoxelLimits<VolumeDataType>::max();
+				return static_cast<VolumeDataType>(value);
+			}
+			else
+			{
+				VolumeDataType result = static_cast<VolumeDataType>(std::clamp(value, lowest, highest));
+				if (upper ? double(result) < value : double(result) > value)
+				{
+					if constexpr (IsHalf<VolumeDataType>)
+					{
+						// step to the neighboring half of the sign-magnitude encoding
+						const uint16_t bits = std::bit_cast<uint16_t>(result);
+						if ((bits & 0x7fff) == 0)
+							result = std::bit_cast<VolumeDataType>(uint16_t(upper ? 0x0001 : 0x8001));
+						else
+							result = std::bit_cast<VolumeDataType>(uint16_t(upper == ((bits & 0x8000) == 0) ? bits + 1 : bits - 1));
+					}
+					else
+					{
+						result = std::nextafter(result, upper ? std::numeric_limits<VolumeDataType>::max() : std::numeric_limits<VolumeDataType>::lowest());
+					}
+				}
+				return result;
+			}
+		}
+
+		/// Copy the voxels of slice z of a view with strided rows or of a bricked
+		/// volume, which are read for the cube code region, into a dense slice.
+		static void GatherSlice(const Context& ctx, int32_t z, std::vector<VolumeDataType>& slice) noexcept
+		{
+			const int32_t xEnd = std::min(ctx.codeEnd[0] + 1, ctx.extent[0]);
+			const int32_t yEnd = std::min(ctx.codeEnd[1] + 1, ctx.extent[1]);
+			if (ctx.bricked != nullptr)
+			{
+				for (int32_t y = ctx.codeBegin[1]; y < yEnd; ++y)
+				{
+					ctx.bricked->CopyRow(y, z, ctx.codeBegin[0], xEnd, slice.data() + size_t(y) * size_t(ctx.extent[0]) + size_t(ctx.codeBegin[0]));
+				}
+				return;
+			}
+
+			const ptrdiff_t stride = ctx.volume.strides[0];
+			for (int32_t y = ctx.codeBegin[1]; y < yEnd; ++y)
+			{
+				const VolumeDataType* row = ctx.volume.Row(y, z);
+				VolumeDataType* dense = slice.data() + size_t(y) * size_t(ctx.extent[0]);
+				for (int32_t x = ctx.codeBegin[0]; x < xEnd; ++x)
+				{
+					dense[x] = row[ptrdiff_t(x) * stride];
+				}
+			}
+		}
+
+		/// Get the voxel row (y,z), which must be one of the available slices.
+		const VolumeDataType* GetVoxelRow(const Context& ctx, int32_t y, int32_t z) const noexcept
+		{
+			assert(z < ctx.nextVoxelSlice && z >= ctx.nextVoxelSlice - VoxelSliceCount && "Voxel slice is not available");
+			return ctx.voxelSlices[z % VoxelSliceCount] + ptrdiff_t(y) * ctx.voxelRowStride;
+		}
+
+		/// Compute the cube codes of the cells of slice z in the region of the
+		/// cube code slices. The codes of slices outside of the volume are left
+		/// untouched, as they are never read.
+		/// With a min/max pyramid only the cells of active bricks are classified
+		/// and all other codes are set to 0.
+		void ClassifySlice(Context& ctx, int32_t z, CodeSlice& slice) const
+		{
+			if (z < 0 || z > ctx.cellCount[2])
+				return;
+
+			DUALMC_ZONE("dualmc::ClassifySlice");
+			stats::ScopedTimer timer(ctx.stats.classifyTime);
+
+			RequireVoxelSlices(ctx, z + 1);
+
+			const int3& begin = ctx.codeBegin;
+			const int3& end = ctx.codeEnd;
+			const MinMaxPyramid<VolumeDataType>* pyramid = ctx.pyramid;
+
+			if (pyramid == nullptr)
+			{
+				slice.active = ClassifyCells(ctx, z, begin[0], end[0], begin[1], end[1], slice.codes);
+				return;
+			}
+
+			slice.active = pyramid->IsCellBoxActive({begin[0], begin[1], z}, {end[0] - 1, end[1] - 1, z}, ctx.iso);
+
+			std::fill(slice.codes.begin(), slice.codes.end(), 0);
+			if (!slice.active)
+				return;
+
+			// classify runs of active bricks
+			const int32_t brickSize = pyramid->BrickSize();
+			const int32_t brickZ = z / brickSize;
+			for (int32_t yBegin = begin[1]; yBegin < end[1];)
+			{
+				int32_t brickY = yBegin / brickSize;
+				int32_t yEnd = std::min((brickY + 1) * brickSize, end[1]);
+				int32_t xBegin = begin[0];
+				while (xBegin < end[0])
+				{
+					int32_t brickX = xBegin / brickSize;
+					if (!pyramid->IsBrickActive({brickX, brickY, brickZ}, ctx.iso))
+					{
+						xBegin = (brickX + 1) * brickSize;
+						continue;
+					}
+					int32_t xEnd = (brickX + 1) * brickSize;
+					while (xEnd < end[0] && pyramid->IsBrickActive({xEnd / brickSize, brickY, brickZ}, ctx.iso))
+					{
+						xEnd += brickSize;
+					}
+					xEnd = std::min(xEnd, end[0]);
+					ClassifyCells(ctx, z, xBegin, xEnd, yBegin, yEnd, slice.codes);
+					xBegin = xEnd;
+				}
+				yBegin = yEnd;
+			}
+		}
+
+		/// Compute the cube codes of the cells in [xBegin,xEnd) x [yBegin,yEnd)
+		/// of slice z. Every voxel row is classified once and the codes of a cell
+		/// row are assembled from the four voxel rows holding its corners.
+		/// Cell rows outside of the row ranges of a lockstep extraction are set
+		/// to 0. Returns false if all cell rows were set to 0 this way.
+		bool ClassifyCells(Context& ctx, int32_t z, int32_t xBegin, int32_t xEnd, int32_t yBegin, int32_t yEnd, std::vector<uint8_t>& codes) const noexcept
+		{
+			size_t count = size_t(xEnd - xBegin);
+			size_t width = count + 1;
+			ctx.insideRows.resize(4 * (size_t(ctx.codeStride) + 1));
+			const kernels::InstructionSet instructionSet = kernels::ActiveInstructionSet();
+
+			// inside masks of the voxel rows (y,z), (y,z+1), (y+1,z) and (y+1,z+1)
+			uint8_t* lower0 = ctx.insideRows.data();
+			uint8_t* lower1 = lower0 + width;
+			uint8_t* upper0 = lower1 + width;
+			uint8_t* upper1 = upper0 + width;
+
+			// voxel row y of the masks in lower0 and lower1
+			int32_t lowerY = -1;
+			bool active = ctx.leader == nullptr;
+			for (int32_t y = yBegin; y < yEnd; ++y)
+			{
+				if (!IsCellRowActive(ctx, y, z))
+				{
+					std::fill_n(&codes[GetCodeOffset(ctx, xBegin, y)], count, uint8_t(0));
+					continue;
+				}
+				active = true;
+
+				if (lowerY != y)
+				{
+					ClassifyRow(ctx, instructionSet, xBegin, y, z, lower0, width);
+					ClassifyRow(ctx, instructionSet, xBegin, y, z + 1, lower1, width);
+				}
+				ClassifyRow(ctx, instructionSet, xBegin, y + 1, z, upper0, width);
+				ClassifyRow(ctx, instructionSet, xBegin, y + 1, z + 1, upper1, width);
+
+				kernels::AssembleCubeCodes(instructionSet, lower0, upper0, lower1, upper1,
+					count, &codes[GetCodeOffset(ctx, xBegin, y)]);
+
+				std::swap(lower0, upper0);
+				std::swap(lower1, upper1);
+				lowerY = y + 1;
+			}
+			return active;
+		}
+
+		/// Check if the voxel rows holding the corners of the cell row (y,z)
+		/// straddle the iso value. Always true outside of lockstep extractions.
+		bool IsCellRowActive(const Context& ctx, int32_t y, int32_t z) const noexcept
+		{
+			if (ctx.leader == nullptr)
+				return true;
+
+			const auto& lower = ctx.leader->rowRanges[z % VoxelSliceCount];
+			const auto& upper = ctx.leader->rowRanges[(z + 1) % VoxelSliceCount];
+			typename MinMaxPyramid<VolumeDataType>::Range range{
+				std::min({lower[y].min, lower[y + 1].min, upper[y].min, upper[y + 1].min}),
+				std::max({lower[y].max, lower[y + 1].max, upper[y].max, upper[y + 1].max})
+			};
+			return MinMaxPyramid<VolumeDataType>::IsActive(range, ctx.iso);
+		}
+
+		/// Set the mask of the width voxels of the voxel row (y,z) starting at x
+		/// to 1 for voxels inside the surface and to 0 otherwise.
+		void ClassifyRow(const Context& ctx, kernels::InstructionSet instructionSet, int32_t x, int32_t y, int32_t z, uint8_t* inside, size_t width) const noexcept
+		{
+			const VolumeDataType* row = GetVoxelRow(ctx, y, z) + x;
+			kernels::ClassifyRow(instructionSet, row, width, ctx.iso, inside);
+		}
+
+		/// Get the position of a cell in the cube code slices.
+		static size_t GetCodeOffset(const Context& ctx, int32_t x, int32_t y) noexcept
+		{
+			return size_t(y - ctx.codeBegin[1]) * size_t(ctx.codeStride) + size_t(x - ctx.codeBegin[0]);
+		}
+
+		/// Get the cube code which is used for looking up the dual points of a cell
+		/// of slice z or z-1. Without the manifold test it is the cube code, which
+		/// is held by the cube code slices 1 and 0 during face construction.
+		template<Manifold M>
+		int32_t GetDualCellCode(const int3& cell, const Context& ctx) const noexcept
+		{
+			size_t offset = GetCodeOffset(ctx, cell[0], cell[1]);
+			if constexpr (M == Manifold::On)
+			{
+				const std::vector<uint8_t>& dualCodes = cell[2] == ctx.currentZ ? ctx.currentDualCodes : ctx.previousDualCodes;
+				return dualCodes[offset];
+			}
+			else
+			{
+				return ctx.cubeCodes[cell[2] == ctx.currentZ ? 1 : 0].codes[offset];
+			}
+		}
+
+		/// Compute the dual cube codes of the cells of slice z, which are referenced
+		/// by faces, from the cube code slices z-1, z and z+1 in ctx.cubeCodes.
+		/// The inversions are counted by the first pass.
+		template<Pass P>
+		void ResolveSlice(Context& ctx, int32_t z, std::vector<uint8_t>& dualCodes) const noexcept
+		{
+			if (!ctx.cubeCodes[1].active)
+				return;
+
+			DUALMC_ZONE("dualmc::ResolveSlice");
+			stats::ScopedTimer timer(ctx.stats.resolveTime);
+
+			for (int32_t y = ctx.slotBegin[1]; y < ctx.cellEnd[1]; ++y)
+			{
+				// cells of rows without surface are never referenced
+				if (!IsCellRowActive(ctx, y, z))
+					continue;
+
+				const size_t offset = GetCodeOffset(ctx, ctx.slotBegin[0], y);
+				const uint8_t* codes = &ctx.cubeCodes[1].codes[offset];
+				uint8_t* dual = &dualCodes[offset];
+				for (int32_t x = ctx.slotBegin[0]; x < ctx.cellEnd[0]; ++x, ++codes, ++dual)
+				{
+					// the manifold test only changes C16 and C19 configurations
+					*dual = problematicConfigs[*codes] == 255 ? *codes : static_cast<uint8_t>(ResolveCellCode({x, y, z}, ctx));
+					if constexpr (StatsEnabled && P != Pass::Fill)
+					{
+						ctx.stats.manifoldInversions += *dual != *codes ? 1 : 0;
+					}
+				}
+			}
+		}
+
+		/// Apply the manifold test to the cube code of a cell of the center cube
+		/// code slice.
+		int32_t ResolveCellCode(const int3& cell, const Context& ctx) const noexcept
+		{
+			auto code = [&](const int3& c, int32_t slice)
+			{
+				return int32_t(ctx.cubeCodes[slice].codes[GetCodeOffset(ctx, c[0], c[1])]);
+			};
+
+			return cells::ResolveCellCode(cell, code(cell, 1), ctx.extent,
+				[&](const int3& neighbor) { return code(neighbor, 1 + neighbor[2] - cell[2]); });
+		}
+
+		/// Given a dual point code and iso value, compute the dual point of the
+		/// output vertex with the given index, and its normal if normals are
+		/// computed. With QEF placement the mean of the edge intersections is
+		/// only the mass point of the QEF, which is solved by PlaceQefPoints.
+		template<Pass P>
+		void CalculateDualPoint(const int3& cell, Context& ctx, int32_t pointCode, size_t vertex) const
+		{
+			Vertex& v = P == Pass::Fill ? ctx.vertices[vertex] : ctx.streamVertices[vertex];
+			float3* normal = P == Pass::Fill && ctx.normals != nullptr ? &ctx.normals[vertex] : nullptr;
+			const bool hermite = ctx.placement == Placement::Qef;
+			qef::Qef qef;
+
+            // convert the corner values of the cell once, instead of two voxels
+            // per intersected edge, corner c lies at (c & 1, (c >> 1) & 1, c >> 2).
+            using Real = cells::IntersectionType<VolumeDataType>;
+            std::array<Real, 8> corners;
+            for (int32_t dz = 0; dz < 2; ++dz)
+            {
+                for (int32_t dy = 0; dy < 2; ++dy)
                 {
-                    ctx.mesh.indices.insert(ctx.mesh.indices.end(), {i0, i3, i2, i1});
+                    const VolumeDataType* row = GetVoxelRow(ctx, cell[1] + dy, cell[2] + dz) + cell[0];
+                    corners[size_t(2 * dy + 4 * dz)] = static_cast<Real>(row[0]);
+                    corners[size_t(2 * dy + 4 * dz + 1)] = static_cast<Real>(row[1]);
+                }
+            }
+
+			// compute the dual point as the mean of the face vertices belonging to the
+			// original marching cubes face
+			const float3 p = cells::CalculateDualPoint(pointCode, corners, static_cast<Real>(ctx.iso),
+				[&](const cells::EdgeDef& edge, const float3& pos, float t)
+				{
+					// the plane of the intersection is given by the gradient there
+					if (hermite)
+					{
+						int3 originVoxel{cell[0] + edge.oX, cell[1] + edge.oY, cell[2] + edge.oZ};
+						int3 endVoxel = originVoxel;
+						endVoxel[edge.axis] += 1;
+						float3 gradient = GetVoxelGradient(ctx, originVoxel) * (1.0f - t) + GetVoxelGradient(ctx, endVoxel) * t;
+						qef.Add(pos, Normalize(gradient));
+					}
+				});
+
+			v.position = GetVertexPosition(cell, ctx, p);
+
+			if (hermite)
+			{
+				ctx.qefPoints.push_back({qef, cell, vertex, normal});
+			}
+			else if (normal != nullptr)
+			{
+				*normal = CalculateNormal(cell, ctx, p);
+			}
+		}
+
+		/// Move the dual points of the last voxel slice to the minimum of their
+		/// QEF, clamped to their cell. The points of a slice are solved as one
+		/// batch after its faces, while the voxels around them are still
+		/// available for their normals.
+		template<Pass P>
+		void PlaceQefPoints(Context& ctx) const noexcept
+		{
+			DUALMC_ZONE("dualmc::PlaceQefPoints");
+			Vertex* vertices = P == Pass::Fill ? ctx.vertices : ctx.streamVertices.data();
+			for (const QefPoint& point : ctx.qefPoints)
+			{
+				float3 p = qef::Solve(point.qef);
+				for (int32_t i = 0; i < 3; ++i)
+				{
+					p[i] = std::clamp(p[i], 0.0f, 1.0f);
+				}
+				vertices[point.vertex].position = GetVertexPosition(point.cell, ctx, p);
+				if (point.normal != nullptr)
+				{
+					*point.normal = CalculateNormal(point.cell, ctx, p);
+				}
+			}
+			ctx.qefPoints.clear();
+		}
+
+		/// Get the position of the offset p inside of a cell in volume coordinates.
+		static float3 GetVertexPosition(const int3& cell, const Context& ctx, const float3& p) noexcept
+		{
+			return {
+				static_cast<float>(cell[0] + ctx.cellOffset[0]) + p[0], 
+				static_cast<float>(cell[1] + ctx.cellOffset[1]) + p[1], 
+				static_cast<float>(cell[2] + ctx.cellOffset[2]) + p[2]
+			};
+		}
+
+		static float3 Normalize(const float3& v) noexcept
+		{
+			float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+			return length > 0.0f ? v * (1.0f / length) : float3{0, 0, 0};
+		}
+
+		/// Get the central difference gradient at a voxel. Differences on the
+		/// border of the volume are one-sided.
+		float3 GetVoxelGradient(const Context& ctx, const int3& voxel) const noexcept
+		{
+			return cells::GetVoxelGradient(voxel, ctx.extent,
+				[&](const int3& v) { return GetVoxelRow(ctx, v[1], v[2])[v[0]]; });
+		}
+
+		/// Compute the normal at the offset p inside of a cell. The central
+		/// difference gradients at the eight corners are interpolated trilinearly
+		/// and normalized. They point to increasing values, which is the front
+		/// side of the faces.
+		float3 CalculateNormal(const int3& cell, const Context& ctx, const float3& p) const noexcept
+		{
+			float3 gradient{0, 0, 0};
+			for (int32_t corner = 0; corner < 8; ++corner)
+			{
+				// corner bits are the x, y and z offsets, as in the cell corner numbering
+				int3 voxel{cell[0] + (corner & 1), cell[1] + ((corner >> 1) & 1), cell[2] + ((corner >> 2) & 1)};
+				float weight = 1.0f;
+				for (int32_t i = 0; i < 3; ++i)
+				{
+					weight *= (corner >> i) & 1 ? p[i] : 1.0f - p[i];
+				}
+
+				gradient += GetVoxelGradient(ctx, voxel) * weight;
+			}
+			return Normalize(gradient);
+		}
+
+        /*
+		* Get the shared index of a dual point which is uniquly identified by its
+		* cell and a cube edge. The dual point is computed in the fill pass,
+		* if it has not been computed before. The position of the dual point in
+		* its slice is returned in slotIndex.
+        */
+		template<Pass P, Manifold M>
+		IndexType GetSharedDualPointIndex(const int3& cell, Context& ctx, DMCEdgeCode edge, size_t& slotIndex)
+		{
+			int32_t cubeCode = GetDualCellCode<M>(cell, ctx);
+			int32_t slot = cells::GetDualPointSlot(cubeCode, edge);
+
+			const bool current = cell[2] == ctx.currentZ;
+			std::vector<IndexType>& slice = current ? ctx.currentSlice : ctx.previousSlice;
+			slotIndex = (size_t(cell[1] - ctx.slotBegin[1]) * size_t(ctx.slotStride) + size_t(cell[0] - ctx.slotBegin[0])) * SlotsPerCell + slot;
+			IndexType& index = slice[slotIndex];
+
+            if constexpr (StatsEnabled && P != Pass::Fill)
+            {
+                (index == InvalidIndex ? ctx.stats.dualPointMisses : ctx.stats.dualPointHits) += 1;
+            }
+            if (index == InvalidIndex) 
+            {
+                index = static_cast<IndexType>(ctx.vertexCount++);
+                (current ? ctx.currentSlots : ctx.previousSlots).push_back(slotIndex);
+                if constexpr (P == Pass::Fill)
+                {
+                    CalculateDualPoint<P>(cell, ctx, dualPointsList[cubeCode][slot], index);
+                    if (ctx.dualPoints != nullptr)
+                    {
+                        const int3 volumeCell{cell[0] + ctx.cellOffset[0], cell[1] + ctx.cellOffset[1], cell[2] + ctx.cellOffset[2]};
+                        ctx.dualPoints[index] = {volumeCell, slot};
+                    }
+                }
+                else if constexpr (P == Pass::Stream)
+                {
+                    ctx.streamVertices.emplace_back();
+                    CalculateDualPoint<P>(cell, ctx, dualPointsList[cubeCode][slot], ctx.streamVertices.size() - 1);
+                }
+            }
+            
+            return index;
+		}
+		
+		/// Check if the surface enters or exits along the cell edge from corner 0
+		/// to the corner with the given bit of the cube code.
+		inline std::pair<bool,bool> GetStatus(int32_t cubeCode, int32_t cornerBit) const noexcept
+		{
+            bool inside1 = (cubeCode & 1) != 0;
+            bool inside2 = (cubeCode & cornerBit) != 0;
+
+			bool entering = inside1 && !inside2;
+			bool exiting = !inside1 && inside2;
+			return std::pair(entering, exiting);
+		}
+
+		/// Emit the face connecting the dual points of four cells around an edge.
+		/// cond selects the orientation. In the count pass only the number of
+		/// indices is accumulated.
+		template<Pass P, Manifold M, Topology Topo>
+		void ConstructFace(Context& ctx, bool cond,const std::array<int3, 4>& cells, const std::array<DMCEdgeCode,4>& edges)
+        {
+            std::array<IndexType, 4> corners;
+            std::array<size_t, 4> slots;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                corners[i] = GetSharedDualPointIndex<P, M>(cells[i], ctx, edges[i], slots[i]);
+            }
+
+            // corner order of quads and triangle pairs for both orientations
+            static constexpr std::array<uint8_t, 4> quad{0, 1, 2, 3};
+            static constexpr std::array<uint8_t, 4> flippedQuad{0, 3, 2, 1};
+            static constexpr std::array<uint8_t, 6> triangles{0, 1, 2, 2, 3, 0};
+            static constexpr std::array<uint8_t, 6> flippedTriangles{2, 1, 0, 0, 3, 2};
+
+            auto emit = [&](const auto& order)
+            {
+                if constexpr (P == Pass::Fill)
+                {
+                    IndexType* indices = &ctx.indices[ctx.indexCount];
+                    for (size_t i = 0; i < order.size(); ++i)
+                    {
+                        indices[i] = corners[order[i]];
+                        if (indices[i] == SharedIndex)
+                        {
+                            ctx.seamFixups.emplace_back(ctx.indexCount + i, slots[order[i]]);
+                        }
+                    }
+                }
+                else if constexpr (P == Pass::Stream)
+                {
+                    for (size_t i = 0; i < order.size(); ++i)
+                    {
+                        ctx.streamIndices.push_back(corners[order[i]]);
+                    }
+                }
+                ctx.indexCount += order.size();
+            };
+
+            if (cond)
+            {
+                if constexpr (Topo == Topology::Quads)
+                {
+                    emit(quad);
                 }
                 else 
                 {
-                    ctx.mesh.indices.insert(ctx.mesh.indices.end(), {i2, i1, i0, i0, i3, i2});
+                    emit(triangles);
                 }
             }
-        };
+            else
+            {
+                if constexpr (Topo == Topology::Quads)
+                {
+                    emit(flippedQuad);
+                }
+                else 
+                {
+                    emit(flippedTriangles);
+                }
+            }
+        }
+
+        /// Contexts of the slabs of the last extraction. They are kept for reusing
+        /// their scratch buffers, so a mesher must not be used by several threads
+        /// at once.
+        std::vector<Context> slabs;
+        /// size of the mesh counted by the last count pass
+        MeshSize countedSize;
+        /// padded voxel block of the last chunk extraction
+        std::vector<VolumeDataType> chunkBlock;
+        /// vertex normals are computed by the extractions into a mesh
+        Normals normals = Normals::Off;
+        Placement placement = Placement::Mean;
+        /// pass timings and reallocations of the last extraction
+        ExtractionStats passStats;
     };
 
 } // END: namespace dualmc
@@ -0,0 +1,234 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_GPU_H_INCLUDED
+#define DUALMC_GPU_H_INCLUDED
+
+/// \file   gpu.hpp
+/// Host side declarations of the Vulkan compute shaders in `shaders/`, which
+/// extract the same surface as dualmc::Mesher into device buffers. The
+/// application owns the device, the pipelines and the buffers, this header
+/// only defines their layout, contents, sizes and the dispatch order.
+///
+/// All shaders use descriptor set 0 with the bindings of Binding. The
+/// pipeline is recorded into one command buffer, with a compute to compute
+/// memory barrier between consecutive dispatches:
+///
+///  1. dualmc_classify over Parameters::codeCellCount cells
+///  2. dualmc_scan and dualmc_scan_add with DUALMC_SCAN_ACTIVE, see below,
+///     with the group counts of GetScanGroupCounts(codeCellCount)
+///  3. dualmc_arguments with stage 0
+///  4. dualmc_compact over Parameters::codeCellCount cells
+///  5. dualmc_count indirect with Counters::activeDispatch
+///  6. dualmc_scan and dualmc_scan_add with DUALMC_SCAN_POINTS, indirect
+///     with Counters::scanDispatch
+///  7. the same with DUALMC_SCAN_INDICES
+///  8. dualmc_arguments with stage 1
+///  9. dualmc_points and dualmc_faces indirect with Counters::activeDispatch
+///
+/// A scan dispatches dualmc_scan with the levels 0, 1 and 2 followed by
+/// dualmc_scan_add with the levels 1 and 0, each with the group count of its
+/// level. The level is a push constant. Afterwards Counters holds the numbers
+/// of vertices and indices, and Counters::draw the arguments of
+/// vkCmdDrawIndexedIndirect rendering the faces without a readback.
+///
+/// Faces are emitted in the order of the CPU mesher with the same topology,
+/// only the numbering of the vertices differs: the dual points of each cell
+/// are stored in the order of their cells. Dual points are placed at the
+/// mean of the edge intersections, QEF placement and normals are CPU only.
+
+// c includes
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+// stl includes
+#include <array>
+#include <type_traits>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    namespace gpu
+    {
+        /// Threads of the workgroups over cells.
+        constexpr uint32_t WorkgroupSize = 64;
+        /// Elements of a workgroup of the prefix sum, which has half as many
+        /// threads.
+        constexpr uint32_t ScanBlockSize = 512;
+        constexpr uint32_t ScanLevels = 3;
+        /// Offset of the level 2 block sums in the scan sum buffer.
+        constexpr uint32_t ScanLevel2Offset = 262144;
+        /// Largest number of elements of a scan, 2^27.
+        constexpr uint64_t MaxScanCount = uint64_t(ScanBlockSize) * ScanBlockSize * ScanBlockSize;
+
+        /// Storage buffer bindings of descriptor set 0.
+        enum Binding : uint32_t
+        {
+            ParametersBinding = 0,
+            TablesBinding = 1,
+            VolumeBinding = 2,
+            CubeCodesBinding = 3,
+            ActiveFlagsBinding = 4,
+            ActiveOffsetsBinding = 5,
+            ActiveCellsBinding = 6,
+            PointMasksBinding = 7,
+            PointOffsetsBinding = 8,
+            IndexCountsBinding = 9,
+            IndexOffsetsBinding = 10,
+            CountersBinding = 11,
+            VerticesBinding = 12,
+            IndicesBinding = 13,
+            ScanSumsBinding = 14,
+            BindingCount = 15
+        };
+
+        /// \class  Parameters
+        /// Uniform buffer of the extraction in std140 layout.
+        struct Parameters
+        {
+            /// voxels along each axis, the fourth component is unused
+            std::array<int32_t, 4> extent;
+            /// cells whose faces are constructed
+            std::array<int32_t, 4> cellCount;
+            /// classified cells including the neighbors of the manifold test
+            std::array<int32_t, 4> codeCount;
+            float iso;
+            uint32_t manifold;
+            uint32_t quads;
+            uint32_t codeCellCount;
+        };
+        static_assert(sizeof(Parameters) == 64 && std::is_standard_layout_v<Parameters>, "Parameters do not match std140");
+
+        /// Set up the parameters of a volume with the given number of voxels.
+        /// As for the mesher the volume holds at least 5 voxels along each
+        /// axis. The classified cells must not exceed MaxScanCount.
+        [[nodiscard]] inline Parameters MakeParameters(const int3& extent, float iso, Topology topology, Manifold manifold) noexcept
+        {
+            assert(extent[0] >= 5 && extent[1] >= 5 && extent[2] >= 5 && "Volume is too small");
+            Parameters params{};
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                params.extent[i] = extent[i];
+                params.cellCount[i] = extent[i] - 4;
+                params.codeCount[i] = extent[i] - 3;
+            }
+            params.iso = iso;
+            params.manifold = manifold == Manifold::On ? 1 : 0;
+            params.quads = topology == Topology::Quads ? 1 : 0;
+            const uint64_t codeCells = uint64_t(params.codeCount[0]) * uint64_t(params.codeCount[1]) * uint64_t(params.codeCount[2]);
+            assert(codeCells <= MaxScanCount && "Volume is too large for the prefix sum");
+            params.codeCellCount = static_cast<uint32_t>(codeCells);
+            return params;
+        }
+
+        /// \class  Tables
+        /// Storage buffer holding the lookup tables of the mesher as 32-bit
+        /// words, the four dual point codes of each cube code followed by the
+        /// manifold directions.
+        struct Tables
+        {
+            std::array<uint32_t, 1024> dualPointsList;
+            std::array<uint32_t, 256> problematicConfigs;
+        };
+
+        [[nodiscard]] constexpr Tables MakeTables() noexcept
+        {
+            Tables result{};
+            for (size_t code = 0; code < 256; ++code)
+            {
+                for (size_t slot = 0; slot < 4; ++slot)
+                {
+                    result.dualPointsList[4 * code + slot] = static_cast<uint32_t>(tables::dualPointsList[code][slot]);
+                }
+                result.problematicConfigs[code] = tables::problematicConfigs[code];
+            }
+            return result;
+        }
+
+        /// \class  Counters
+        /// Storage buffer of the shaders' counts and indirect arguments,
+        /// which is zeroed before the dispatches. The arguments match
+        /// VkDispatchIndirectCommand and VkDrawIndexedIndirectCommand.
+        struct Counters
+        {
+            uint32_t activeCells;
+            uint32_t vertices;
+            uint32_t indices;
+            /// groups over the active cells
+            std::array<uint32_t, 3> activeDispatch;
+            /// groups of the scan levels over the active cells
+            std::array<std::array<uint32_t, 3>, ScanLevels> scanDispatch;
+            /// index count, instance count, first index, vertex offset and
+            /// first instance
+            std::array<uint32_t, 5> draw;
+        };
+        static_assert(sizeof(Counters) == 20 * sizeof(uint32_t), "Counters do not match the shaders");
+        static_assert(offsetof(Counters, activeDispatch) == 3 * sizeof(uint32_t), "Counters do not match the shaders");
+        static_assert(offsetof(Counters, scanDispatch) == 6 * sizeof(uint32_t), "Counters do not match the shaders");
+        static_assert(offsetof(Counters, draw) == 15 * sizeof(uint32_t), "Counters do not match the shaders");
+
+        [[nodiscard]] constexpr uint32_t GetGroupCount(uint64_t count, uint32_t groupSize) noexcept
+        {
+            return static_cast<uint32_t>((count + groupSize - 1) / groupSize);
+        }
+
+        /// Groups of the three scan levels over count elements. Every level
+        /// dispatches at least one group, so the total is written for empty
+        /// inputs as well.
+        [[nodiscard]] constexpr std::array<uint32_t, ScanLevels> GetScanGroupCounts(uint64_t count) noexcept
+        {
+            std::array<uint32_t, ScanLevels> groups{};
+            for (uint32_t level = 0; level < ScanLevels; ++level)
+            {
+                count = GetGroupCount(count, ScanBlockSize);
+                groups[level] = count > 0 ? static_cast<uint32_t>(count) : 1;
+            }
+            return groups;
+        }
+
+        /// \class  BufferSizes
+        /// Sizes in bytes of the storage buffers for the worst case of a
+        /// volume, where every cell is active with four dual points and three
+        /// faces. Applications knowing a smaller bound of the active cells,
+        /// e.g. from a previous frame, can shrink the buffers of active cells.
+        struct BufferSizes
+        {
+            std::array<size_t, BindingCount> bytes;
+        };
+
+        /// Get the buffer sizes of the parameters of a volume of voxels
+        /// taking voxelSize bytes, which are packed into 32-bit words.
+        [[nodiscard]] inline BufferSizes GetBufferSizes(const Parameters& params, size_t voxelSize) noexcept
+        {
+            const size_t voxels = size_t(params.extent[0]) * size_t(params.extent[1]) * size_t(params.extent[2]);
+            const size_t codeCells = params.codeCellCount;
+            const size_t cells = size_t(params.cellCount[0]) * size_t(params.cellCount[1]) * size_t(params.cellCount[2]);
+            const size_t word = sizeof(uint32_t);
+
+            BufferSizes sizes{};
+            sizes.bytes[ParametersBinding] = sizeof(Parameters);
+            sizes.bytes[TablesBinding] = sizeof(Tables);
+            sizes.bytes[VolumeBinding] = (voxels * voxelSize + word - 1) / word * word;
+            sizes.bytes[CubeCodesBinding] = codeCells * word;
+            sizes.bytes[ActiveFlagsBinding] = codeCells * word;
+            sizes.bytes[ActiveOffsetsBinding] = codeCells * word;
+            sizes.bytes[ActiveCellsBinding] = cells * word;
+            sizes.bytes[PointMasksBinding] = cells * word;
+            sizes.bytes[PointOffsetsBinding] = cells * word;
+            sizes.bytes[IndexCountsBinding] = cells * word;
+            sizes.bytes[IndexOffsetsBinding] = cells * word;
+            sizes.bytes[CountersBinding] = sizeof(Counters);
+            sizes.bytes[VerticesBinding] = cells * 4 * 3 * sizeof(float);
+            sizes.bytes[IndicesBinding] = cells * 3 * (params.quads != 0 ? 4 : 6) * word;
+            sizes.bytes[ScanSumsBinding] = (ScanLevel2Offset + ScanBlockSize) * word;
+            return sizes;
+        }
+    } // END: namespace gpu
+
+} // END: namespace dualmc
+#endif // DUALMC_GPU_H_INCLUDED
@@ -0,0 +1,203 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_INCREMENTAL_MESHER_H_INCLUDED
+#define DUALMC_INCREMENTAL_MESHER_H_INCLUDED
+
+/// \file   incremental_mesher.hpp
+/// Brick-wise mesh cache for re-meshing edited regions of a volume.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+
+// stl includes
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <utility>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    /// \class  IncrementalMesher
+    /// Keeps the iso surface of a volume as separate meshes of cubic bricks of
+    /// cells. After voxels have been edited, only the bricks whose faces can
+    /// depend on the edited voxels are extracted again, so the cost of an
+    /// update is proportional to the size of the edit.
+    /// A brick holds the faces of its cells. Dual points on brick boundaries
+    /// are duplicated in the meshes of the bricks referencing them, and are
+    /// welded by Assemble.
+    template<class T, MeshIndex I = uint32_t>
+    requires VoxelType<T>
+    class IncrementalMesher
+    {
+    public:
+        using VolumeDataType = T;
+        using IndexType = I;
+        using MeshType = BasicMesh<IndexType>;
+
+        explicit IncrementalMesher(int32_t brickSize = 32) : brickSize(brickSize)
+        {
+            assert(brickSize > 0 && "Brick size is invalid");
+        }
+
+        /// Extract the meshes of all bricks of a volume. The volume parameters
+        /// are kept for later updates.
+        void Build(
+            const std::span<const VolumeDataType>& data,
+            const int3& dimension,
+            VolumeDataType iso,
+            Topology topology = Topology::Triangles,
+            Manifold manifold = Manifold::On)
+        {
+            extent = dimension;
+            this->iso = iso;
+            this->topology = topology;
+            this->manifold = manifold;
+
+            // faces are constructed for the cells in [0,dimension-4)
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                cellCount[i] = std::max(dimension[i] - 4, 0);
+                grid[i] = (cellCount[i] + brickSize - 1) / brickSize;
+            }
+            bricks.resize(size_t(grid[0]) * size_t(grid[1]) * size_t(grid[2]));
+            dualPoints.resize(bricks.size());
+
+            updated.clear();
+            for (size_t brick = 0; brick < bricks.size(); ++brick)
+            {
+                BuildBrick(data, brick);
+                updated.push_back(brick);
+            }
+        }
+
+        /// Extract the bricks again, which depend on the voxels in the inclusive
+        /// box [voxelMin,voxelMax]. data holds the edited volume, which must have
+        /// the extent given to Build. The indices of the updated bricks are
+        /// returned and stay valid until the next call.
+        std::span<const size_t> Update(const std::span<const VolumeDataType>& data, const int3& voxelMin, const int3& voxelMax)
+        {
+            updated.clear();
+
+            // A voxel is a corner of the cells at offsets -1 and 0, whose dual
+            // points are referenced by the faces of the cells at offsets 0 and +1.
+            // The manifold test of a cell also reads the cube codes of its
+            // neighbors, which adds another cell on both sides.
+            int3 brickMin;
+            int3 brickMax;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                int32_t cellMin = std::max(voxelMin[i] - 2, 0);
+                int32_t cellMax = std::min(voxelMax[i] + 2, cellCount[i] - 1);
+                if (cellMin > cellMax)
+                    return {};
+                brickMin[i] = cellMin / brickSize;
+                brickMax[i] = cellMax / brickSize;
+            }
+
+            for (int32_t z = brickMin[2]; z <= brickMax[2]; ++z)
+            {
+                for (int32_t y = brickMin[1]; y <= brickMax[1]; ++y)
+                {
+                    for (int32_t x = brickMin[0]; x <= brickMax[0]; ++x)
+                    {
+                        size_t brick = GetBrickIndex({x, y, z});
+                        BuildBrick(data, brick);
+                        updated.push_back(brick);
+                    }
+                }
+            }
+            return updated;
+        }
+
+        /// Number of bricks along each axis.
+        [[nodiscard]] const int3& BrickGrid() const noexcept { return grid; }
+
+        /// Number of cells per brick along each axis.
+        [[nodiscard]] int32_t BrickSize() const noexcept { return brickSize; }
+
+        /// Total number of bricks.
+        [[nodiscard]] size_t BrickCount() const noexcept { return bricks.size(); }
+
+        /// Get the linear index of a brick given by its grid coordinates.
+        [[nodiscard]] size_t GetBrickIndex(const int3& brick) const noexcept
+        {
+            return size_t(brick[0]) + size_t(grid[0]) * (size_t(brick[1]) + size_t(grid[1]) * size_t(brick[2]));
+        }
+
+        /// Get the mesh of a brick. Its vertices are given in volume coordinates.
+        [[nodiscard]] const MeshType& GetBrickMesh(size_t brick) const noexcept
+        {
+            return bricks[brick];
+        }
+
+        /// Join the meshes of all bricks into a single mesh, in which the dual
+        /// points on brick boundaries are welded. It has the faces and vertices
+        /// of Mesher::Build. Throws std::length_error if the vertices do not
+        /// fit into the index type.
+        void Assemble(MeshType& mesh) const
+        {
+            std::vector<MeshRegion<IndexType>> regions(bricks.size());
+            for (size_t brick = 0; brick < bricks.size(); ++brick)
+            {
+                auto [cellBegin, cellEnd] = GetBrickCells(brick);
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    cellEnd[i] = std::min(cellEnd[i], cellCount[i]);
+                }
+                regions[brick] = {&bricks[brick], &dualPoints[brick], cellBegin, cellEnd};
+            }
+            WeldMeshes<IndexType>(regions, cellCount, mesh);
+        }
+
+    private:
+        /// Get the cells [begin,end) of a brick, which may extend beyond the
+        /// cells of the volume.
+        std::pair<int3, int3> GetBrickCells(size_t brick) const noexcept
+        {
+            int3 coordinates{
+                int32_t(brick % size_t(grid[0])),
+                int32_t((brick / size_t(grid[0])) % size_t(grid[1])),
+                int32_t(brick / (size_t(grid[0]) * size_t(grid[1])))
+            };
+            int3 cellBegin;
+            int3 cellEnd;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                cellBegin[i] = coordinates[i] * brickSize;
+                cellEnd[i] = cellBegin[i] + brickSize;
+            }
+            return {cellBegin, cellEnd};
+        }
+
+        /// Extract the faces of the cells of a brick into its mesh.
+        void BuildBrick(const std::span<const VolumeDataType>& data, size_t brick)
+        {
+            auto [cellBegin, cellEnd] = GetBrickCells(brick);
+            mesher.BuildRegion(data, extent, iso, cellBegin, cellEnd, bricks[brick], topology, manifold, nullptr, &dualPoints[brick]);
+        }
+
+        int32_t brickSize;
+        int3 extent{0, 0, 0};
+        int3 cellCount{0, 0, 0};
+        int3 grid{0, 0, 0};
+        VolumeDataType iso{};
+        Topology topology = Topology::Triangles;
+        Manifold manifold = Manifold::On;
+
+        Mesher<VolumeDataType, IndexType> mesher;
+        std::vector<MeshType> bricks;
+        /// dual points of the vertices of each brick, which identify the
+        /// vertices on brick boundaries for Assemble
+        std::vector<std::vector<DualPointId>> dualPoints;
+        std::vector<size_t> updated;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_INCREMENTAL_MESHER_H_INCLUDED
@@ -0,0 +1,513 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_LOD_MESHER_H_INCLUDED
+#define DUALMC_LOD_MESHER_H_INCLUDED
+
+/// \file   lod_mesher.hpp
+/// Chunk-wise mesh cache with a level of detail per chunk, e.g. for streaming
+/// terrain.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+
+// stl includes
+#include <vector>
+#include <span>
+#include <array>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    /// \class  LodMesher
+    /// Keeps the iso surface of a volume as separate meshes of cubic chunks of
+    /// cells, each extracted at its own level of detail. Level 0 is the volume,
+    /// the voxels of level l+1 are the voxels at even coordinates of level l
+    /// smoothed with a [1/4,1/2,1/4] filter, so voxel v of level l lies at
+    /// voxel v*2^l of the volume. The levels are built once, and a chunk is
+    /// only extracted again if its level or the voxels below it change.
+    /// Vertices of all levels are given in volume coordinates. Chunks of
+    /// different levels do not share their dual points, so each chunk hangs a
+    /// skirt from its open edges on the sides facing other chunks into the
+    /// inside of the surface, which covers the cracks towards neighbors of any
+    /// level. Skirts do not depend on the neighbors, so changing the level of a
+    /// chunk does not touch the meshes of its neighbors.
+    template<class T, MeshIndex I = uint32_t>
+    requires VoxelType<T>
+    class LodMesher
+    {
+    public:
+        using VolumeDataType = T;
+        using IndexType = I;
+        using MeshType = BasicMesh<IndexType>;
+
+        /// Returns the level of the chunk of the cells in [cellBegin,cellEnd)
+        /// of the volume, which is clamped to the available levels.
+        using LevelSelector = std::function<int32_t(const int3& cellBegin, const int3& cellEnd)>;
+
+        /// The chunk size in cells must be a multiple of 2^(levelCount-1), so
+        /// chunks cover whole cells of every level. Skirts reach skirtDepth
+        /// cells of the level of their chunk into the surface, 0 disables them.
+        explicit LodMesher(int32_t chunkSize = 32, int32_t levelCount = 4, float skirtDepth = 1.0f)
+            : chunkSize(chunkSize), levelCount(levelCount), skirtDepth(skirtDepth)
+        {
+            assert(levelCount > 0 && levelCount < 31 && "Level count is invalid");
+            assert(chunkSize > 0 && chunkSize % (1 << (levelCount - 1)) == 0 && "Chunk size does not cover whole cells of all levels");
+        }
+
+        /// Build the levels of a volume and extract every chunk at the level
+        /// of selector. The volume is referenced, not copied, and must stay
+        /// valid until the next call of Build or Update.
+        void Build(
+            const std::span<const VolumeDataType>& data,
+            const int3& dimension,
+            VolumeDataType iso,
+            const LevelSelector& selector,
+            Topology topology = Topology::Triangles,
+            Manifold manifold = Manifold::On)
+        {
+            assert(data.size() >= size_t(dimension[0]) * size_t(dimension[1]) * size_t(dimension[2]) && "Volume data is smaller than extent");
+            volume = data;
+            this->iso = iso;
+            this->topology = topology;
+            this->manifold = manifold;
+
+            // Every level covers the cells of the volume, voxels beyond the
+            // border of the finer level are clamped to it.
+            extents.resize(size_t(levelCount));
+            levels.resize(size_t(levelCount));
+            extents[0] = dimension;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                cellCount[i] = std::max(dimension[i] - 4, 0);
+                grid[i] = (cellCount[i] + chunkSize - 1) / chunkSize;
+            }
+            for (int32_t level = 1; level < levelCount; ++level)
+            {
+                int32_t scale = 1 << level;
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    extents[size_t(level)][i] = (cellCount[i] + scale - 1) / scale + 4;
+                }
+                const int3& extent = extents[size_t(level)];
+                levels[size_t(level)].resize(size_t(extent[0]) * size_t(extent[1]) * size_t(extent[2]));
+                DownsampleLevel(level, {0, 0, 0}, {extent[0] - 1, extent[1] - 1, extent[2] - 1});
+            }
+
+            chunks.assign(size_t(grid[0]) * size_t(grid[1]) * size_t(grid[2]), MeshType{});
+            chunkLevels.assign(chunks.size(), -1);
+            SelectLevels(selector);
+        }
+
+        /// Extract the chunks again, whose level given by selector differs
+        /// from their current level, e.g. after a camera move. The indices of
+        /// the updated chunks are returned and stay valid until the next call.
+        std::span<const size_t> SelectLevels(const LevelSelector& selector)
+        {
+            assert(selector && "Level selector is missing");
+            updated.clear();
+            for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+            {
+                auto [cellBegin, cellEnd] = GetChunkCells(chunk);
+                int32_t level = std::clamp(selector(cellBegin, cellEnd), 0, levelCount - 1);
+                if (level != chunkLevels[chunk])
+                {
+                    chunkLevels[chunk] = level;
+                    BuildChunk(chunk);
+                    updated.push_back(chunk);
+                }
+            }
+            return updated;
+        }
+
+        /// Update the levels below the edited voxels in the inclusive box
+        /// [voxelMin,voxelMax] and extract the chunks again, whose faces at
+        /// their current level depend on them. data holds the edited volume,
+        /// which must have the extent given to Build. The indices of the
+        /// updated chunks are returned and stay valid until the next call.
+        std::span<const size_t> Update(const std::span<const VolumeDataType>& data, const int3& voxelMin, const int3& voxelMax)
+        {
+            assert(data.size() >= volume.size() && "Volume data is smaller than extent");
+            volume = data;
+            updated.clear();
+
+            int3 levelMin;
+            int3 levelMax;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                levelMin[i] = std::clamp(voxelMin[i], 0, extents[0][i] - 1);
+                levelMax[i] = std::clamp(voxelMax[i], 0, extents[0][i] - 1);
+                if (levelMin[i] > levelMax[i])
+                    return {};
+            }
+
+            std::vector<uint8_t> dirty(chunks.size(), 0);
+            for (int32_t level = 0; level < levelCount; ++level)
+            {
+                // The filter of voxel v reads the voxels 2v-1 to 2v+1 of the
+                // finer level, the voxels beyond its border read the last one.
+                if (level > 0)
+                {
+                    const int3& finerExtent = extents[size_t(level - 1)];
+                    const int3& extent = extents[size_t(level)];
+                    for (int32_t i = 0; i < 3; ++i)
+                    {
+                        bool border = levelMax[i] == finerExtent[i] - 1;
+                        levelMin[i] = std::min(levelMin[i] / 2, extent[i] - 1);
+                        levelMax[i] = border ? extent[i] - 1 : std::min((levelMax[i] + 1) / 2, extent[i] - 1);
+                    }
+                    DownsampleLevel(level, levelMin, levelMax);
+                }
+
+                // As for IncrementalMesher a voxel is referenced by the faces
+                // of the cells up to two cells below and above it.
+                int32_t scale = 1 << level;
+                int3 chunkMin;
+                int3 chunkMax;
+                bool empty = false;
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    int32_t cellMin = std::max((levelMin[i] - 2) * scale, 0);
+                    int32_t cellMax = std::min((levelMax[i] + 2) * scale + scale - 1, cellCount[i] - 1);
+                    empty = empty || cellMin > cellMax;
+                    chunkMin[i] = cellMin / chunkSize;
+                    chunkMax[i] = cellMax / chunkSize;
+                }
+                if (empty)
+                    continue;
+
+                for (int32_t z = chunkMin[2]; z <= chunkMax[2]; ++z)
+                {
+                    for (int32_t y = chunkMin[1]; y <= chunkMax[1]; ++y)
+                    {
+                        for (int32_t x = chunkMin[0]; x <= chunkMax[0]; ++x)
+                        {
+                            size_t chunk = GetChunkIndex({x, y, z});
+                            dirty[chunk] = dirty[chunk] || chunkLevels[chunk] == level;
+                        }
+                    }
+                }
+            }
+
+            for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+            {
+                if (dirty[chunk] != 0)
+                {
+                    BuildChunk(chunk);
+                    updated.push_back(chunk);
+                }
+            }
+            return updated;
+        }
+
+        /// Select the level of a chunk by its distance to a viewer, level 0
+        /// within distance voxels and one level more each time the distance
+        /// doubles.
+        [[nodiscard]] static LevelSelector DistanceSelector(const float3& viewer, float distance)
+        {
+            assert(distance > 0.0f && "Distance is invalid");
+            return [viewer, distance](const int3& cellBegin, const int3& cellEnd)
+            {
+                float squaredDistance = 0.0f;
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    float center = 0.5f * float(cellBegin[i] + cellEnd[i]);
+                    squaredDistance += (center - viewer[i]) * (center - viewer[i]);
+                }
+                float ratio = std::sqrt(squaredDistance) / distance;
+                return ratio < 1.0f ? 0 : int32_t(std::floor(std::log2(ratio))) + 1;
+            };
+        }
+
+        /// Number of chunks along each axis.
+        [[nodiscard]] const int3& ChunkGrid() const noexcept { return grid; }
+
+        /// Number of cells of the volume per chunk along each axis.
+        [[nodiscard]] int32_t ChunkSize() const noexcept { return chunkSize; }
+
+        /// Total number of chunks.
+        [[nodiscard]] size_t ChunkCount() const noexcept { return chunks.size(); }
+
+        [[nodiscard]] int32_t LevelCount() const noexcept { return levelCount; }
+
+        /// Get the linear index of a chunk given by its grid coordinates.
+        [[nodiscard]] size_t GetChunkIndex(const int3& chunk) const noexcept
+        {
+            return size_t(chunk[0]) + size_t(grid[0]) * (size_t(chunk[1]) + size_t(grid[1]) * size_t(chunk[2]));
+        }
+
+        /// Get the current level of a chunk.
+        [[nodiscard]] int32_t GetChunkLevel(size_t chunk) const noexcept
+        {
+            return chunkLevels[chunk];
+        }
+
+        /// Get the mesh of a chunk including its skirts. Its vertices are
+        /// given in volume coordinates.
+        [[nodiscard]] const MeshType& GetChunkMesh(size_t chunk) const noexcept
+        {
+            return chunks[chunk];
+        }
+
+        /// Get a view of the voxels of a level.
+        [[nodiscard]] VolumeView<VolumeDataType> GetLevelVolume(int32_t level) const noexcept
+        {
+            assert(level >= 0 && level < levelCount && "Level is invalid");
+            const std::span<const VolumeDataType> data = level == 0 ? volume : std::span<const VolumeDataType>(levels[size_t(level)]);
+            return VolumeView<VolumeDataType>(data.data(), extents[size_t(level)]);
+        }
+
+        /// Concatenate the meshes of all chunks into a single mesh. Throws
+        /// std::length_error if the vertices do not fit into the index type.
+        void Assemble(MeshType& mesh) const
+        {
+            ConcatenateMeshes<IndexType>(chunks, mesh);
+        }
+
+    private:
+        /// Get the cells of the volume in a chunk as [cellBegin,cellEnd).
+        [[nodiscard]] std::pair<int3, int3> GetChunkCells(size_t chunk) const noexcept
+        {
+            int3 coordinates{
+                int32_t(chunk % size_t(grid[0])),
+                int32_t((chunk / size_t(grid[0])) % size_t(grid[1])),
+                int32_t(chunk / (size_t(grid[0]) * size_t(grid[1])))
+            };
+            int3 cellBegin;
+            int3 cellEnd;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                cellBegin[i] = coordinates[i] * chunkSize;
+                cellEnd[i] = std::min(cellBegin[i] + chunkSize, cellCount[i]);
+            }
+            return {cellBegin, cellEnd};
+        }
+
+        /// Compute the voxels of a level in the inclusive box [min,max] from
+        /// the next finer level.
+        void DownsampleLevel(int32_t level, const int3& min, const int3& max)
+        {
+            constexpr std::array<float, 3> weights{0.25f, 0.5f, 0.25f};
+            const VolumeView<VolumeDataType> source = GetLevelVolume(level - 1);
+            const int3& extent = extents[size_t(level)];
+            std::vector<VolumeDataType>& target = levels[size_t(level)];
+
+            for (int32_t z = min[2]; z <= max[2]; ++z)
+            {
+                for (int32_t y = min[1]; y <= max[1]; ++y)
+                {
+                    for (int32_t x = min[0]; x <= max[0]; ++x)
+                    {
+                        float sum = 0.0f;
+                        for (int32_t dz = 0; dz < 3; ++dz)
+                        {
+                            int32_t sz = std::clamp(2 * z + dz - 1, 0, source.extent[2] - 1);
+                            for (int32_t dy = 0; dy < 3; ++dy)
+                            {
+                                int32_t sy = std::clamp(2 * y + dy - 1, 0, source.extent[1] - 1);
+                                const VolumeDataType* row = source.Row(sy, sz);
+                                float rowSum = 0.0f;
+                                for (int32_t dx = 0; dx < 3; ++dx)
+                                {
+                                    int32_t sx = std::clamp(2 * x + dx - 1, 0, source.extent[0] - 1);
+                                    rowSum += weights[size_t(dx)] * float(row[sx]);
+                                }
+                                sum += weights[size_t(dz)] * weights[size_t(dy)] * rowSum;
+                            }
+                        }
+
+                        size_t index = size_t(x) + size_t(extent[0]) * (size_t(y) + size_t(extent[1]) * size_t(z));
+                        if constexpr (std::is_integral_v<VolumeDataType>)
+                        {
+                            target[index] = static_cast<VolumeDataType>(std::lround(sum));
+                        }
+                        else
+                        {
+                            target[index] = static_cast<VolumeDataType>(sum);
+                        }
+                    }
+                }
+            }
+        }
+
+        /// Extract the faces of the cells of a chunk at its level and add its
+        /// skirts.
+        void BuildChunk(size_t chunk)
+        {
+            int32_t level = chunkLevels[chunk];
+            int32_t scale = 1 << level;
+            auto [cellBegin, cellEnd] = GetChunkCells(chunk);
+            int3 levelBegin;
+            int3 levelEnd;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                levelBegin[i] = cellBegin[i] / scale;
+                levelEnd[i] = (cellEnd[i] + scale - 1) / scale;
+            }
+
+            MeshType& mesh = chunks[chunk];
+            mesher.BuildRegion(GetLevelVolume(level), iso, levelBegin, levelEnd, mesh, topology, manifold);
+            for (Vertex& vertex : mesh.vertices)
+            {
+                vertex.position = vertex.position * float(scale);
+            }
+            if (skirtDepth > 0.0f)
+            {
+                AddSkirts(mesh, chunk, float(scale));
+            }
+        }
+
+        /// Hang a skirt from the open edges of a chunk mesh on its sides facing
+        /// other chunks. The open edges lie in the outermost cells of the
+        /// chunk, whose faces reference the dual points of the cells one level
+        /// cell below and inside of the chunk. The skirts are moved along the
+        /// face normals, which point towards the inside of the surface.
+        void AddSkirts(MeshType& mesh, size_t chunk, float scale)
+        {
+            const size_t faceSize = topology == Topology::Quads ? 4 : 3;
+            const size_t faceIndexCount = mesh.indices.size();
+            const size_t vertexCount = mesh.vertices.size();
+
+            // open edges are the edges of one face, directed as in that face
+            edges.clear();
+            for (size_t face = 0; face < faceIndexCount; face += faceSize)
+            {
+                for (size_t corner = 0; corner < faceSize; ++corner)
+                {
+                    IndexType a = mesh.indices[face + corner];
+                    IndexType b = mesh.indices[face + (corner + 1) % faceSize];
+                    edges.push_back({std::min(a, b), std::max(a, b), a});
+                }
+            }
+            std::sort(edges.begin(), edges.end(), [](const Edge& u, const Edge& v)
+            {
+                return u.lower != v.lower ? u.lower < v.lower : u.upper < v.upper;
+            });
+
+            normals.assign(vertexCount, float3{0.0f, 0.0f, 0.0f});
+            for (size_t face = 0; face < faceIndexCount; face += faceSize)
+            {
+                const float3& p0 = mesh.vertices[mesh.indices[face]].position;
+                const float3& p1 = mesh.vertices[mesh.indices[face + 1]].position;
+                const float3& p2 = mesh.vertices[mesh.indices[face + 2]].position;
+                const float3& p3 = mesh.vertices[mesh.indices[face + faceSize - 1]].position;
+                // the diagonals of a quad, two edges of a triangle
+                float3 u = faceSize == 4 ? p2 - p0 : p1 - p0;
+                float3 v = faceSize == 4 ? p3 - p1 : p2 - p0;
+                float3 normal{u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+                for (size_t corner = 0; corner < faceSize; ++corner)
+                {
+                    normals[mesh.indices[face + corner]] += normal;
+                }
+            }
+
+            auto [cellBegin, cellEnd] = GetChunkCells(chunk);
+            const int3 coordinates{
+                int32_t(chunk % size_t(grid[0])),
+                int32_t((chunk / size_t(grid[0])) % size_t(grid[1])),
+                int32_t(chunk / (size_t(grid[0]) * size_t(grid[1])))
+            };
+            const float epsilon = 1e-3f * scale;
+            auto isOnInnerSide = [&](const float3& p, const float3& q)
+            {
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    int32_t levelEnd = (cellEnd[i] + int32_t(scale) - 1) / int32_t(scale) * int32_t(scale);
+                    if (coordinates[i] > 0 && p[i] <= float(cellBegin[i]) + epsilon && q[i] <= float(cellBegin[i]) + epsilon)
+                        return true;
+                    if (coordinates[i] + 1 < grid[i] && p[i] >= float(levelEnd) - scale - epsilon && q[i] >= float(levelEnd) - scale - epsilon)
+                        return true;
+                }
+                return false;
+            };
+
+            const IndexType invalid = std::numeric_limits<IndexType>::max();
+            skirtVertices.assign(vertexCount, invalid);
+            auto getSkirtVertex = [&](IndexType index)
+            {
+                if (skirtVertices[index] == invalid)
+                {
+                    const float3& normal = normals[index];
+                    float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                    Vertex vertex = mesh.vertices[index];
+                    if (length > 0.0f)
+                    {
+                        vertex.position += normal * (skirtDepth * scale / length);
+                    }
+                    CheckVertexCount<IndexType>(mesh.vertices.size() + 1, 1);
+                    skirtVertices[index] = static_cast<IndexType>(mesh.vertices.size());
+                    mesh.vertices.push_back(vertex);
+                }
+                return skirtVertices[index];
+            };
+
+            for (size_t i = 0; i < edges.size(); ++i)
+            {
+                bool shared = (i > 0 && edges[i - 1].lower == edges[i].lower && edges[i - 1].upper == edges[i].upper)
+                    || (i + 1 < edges.size() && edges[i + 1].lower == edges[i].lower && edges[i + 1].upper == edges[i].upper);
+                if (shared)
+                    continue;
+
+                // the skirt runs along the open edge opposite to its face
+                IndexType a = edges[i].first;
+                IndexType b = a == edges[i].lower ? edges[i].upper : edges[i].lower;
+                if (!isOnInnerSide(mesh.vertices[a].position, mesh.vertices[b].position))
+                    continue;
+                IndexType skirtA = getSkirtVertex(a);
+                IndexType skirtB = getSkirtVertex(b);
+                if (topology == Topology::Quads)
+                {
+                    mesh.indices.insert(mesh.indices.end(), {b, a, skirtA, skirtB});
+                }
+                else
+                {
+                    mesh.indices.insert(mesh.indices.end(), {b, a, skirtA, b, skirtA, skirtB});
+                }
+            }
+        }
+
+        /// Edge of a face between the vertices lower and upper, which starts
+        /// at first in the face.
+        struct Edge
+        {
+            IndexType lower;
+            IndexType upper;
+            IndexType first;
+        };
+
+        int32_t chunkSize;
+        int32_t levelCount;
+        float skirtDepth;
+        std::span<const VolumeDataType> volume;
+        int3 cellCount{0, 0, 0};
+        int3 grid{0, 0, 0};
+        VolumeDataType iso{};
+        Topology topology = Topology::Triangles;
+        Manifold manifold = Manifold::On;
+
+        /// voxels and extents of the levels, level 0 is the volume itself
+        std::vector<std::vector<VolumeDataType>> levels;
+        std::vector<int3> extents;
+
+        Mesher<VolumeDataType, IndexType> mesher;
+        std::vector<MeshType> chunks;
+        std::vector<int32_t> chunkLevels;
+        std::vector<size_t> updated;
+
+        // scratch buffers of the skirts
+        std::vector<Edge> edges;
+        std::vector<float3> normals;
+        std::vector<IndexType> skirtVertices;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_LOD_MESHER_H_INCLUDED
@@ -0,0 +1,219 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_MAPPED_FILE_H_INCLUDED
+#define DUALMC_MAPPED_FILE_H_INCLUDED
+
+/// \file   mapped_file.hpp
+/// Read-only memory mapping of RAW volume files.
+
+// c includes
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+// stl includes
+#include <span>
+#include <string>
+#include <utility>
+
+// platform includes
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// dual mc includes
+#include "types.hpp"
+#include "volume_view.hpp"
+
+namespace dualmc
+{
+    /// \class  MappedFile
+    /// Maps a file read-only into memory, so a RAW volume can be passed to the
+    /// mesher as a view of the mapping without reading it into a buffer first.
+    /// Pages are read by the operating system when the mesher first touches
+    /// them, so extraction starts before the file is paged in completely.
+    class MappedFile
+    {
+    public:
+        /// Expected access pattern, which is passed to the operating system as
+        /// a paging hint. The mesher reads volumes in ascending z-slices.
+        enum class Access : uint8_t { Normal, Sequential, Random };
+
+        MappedFile() = default;
+
+        explicit MappedFile(const std::string& path, Access access = Access::Sequential)
+        {
+            Open(path, access);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept
+        {
+            *this = std::move(other);
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Close();
+                data = std::exchange(other.data, nullptr);
+                size = std::exchange(other.size, 0);
+                opened = std::exchange(other.opened, false);
+#if defined(_WIN32)
+                file = std::exchange(other.file, INVALID_HANDLE_VALUE);
+                mapping = std::exchange(other.mapping, nullptr);
+#endif
+            }
+            return *this;
+        }
+
+        ~MappedFile()
+        {
+            Close();
+        }
+
+        /// Map a file, replacing a previous mapping. Returns false if the file
+        /// cannot be opened or mapped. Empty files are opened with an empty mapping.
+        bool Open(const std::string& path, Access access = Access::Sequential)
+        {
+            Close();
+#if defined(_WIN32)
+            DWORD flags = FILE_ATTRIBUTE_NORMAL;
+            if (access == Access::Sequential)
+                flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+            else if (access == Access::Random)
+                flags |= FILE_FLAG_RANDOM_ACCESS;
+
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize))
+            {
+                Close();
+                return false;
+            }
+            size = size_t(fileSize.QuadPart);
+            opened = true;
+            if (size == 0)
+                return true;
+
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr)
+            {
+                data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            }
+            if (data == nullptr)
+            {
+                Close();
+                return false;
+            }
+#else
+            int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0)
+                return false;
+
+            struct stat status;
+            if (::fstat(descriptor, &status) != 0)
+            {
+                ::close(descriptor);
+                return false;
+            }
+            size = size_t(status.st_size);
+            opened = true;
+            if (size == 0)
+            {
+                ::close(descriptor);
+                return true;
+            }
+
+            void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            // the mapping keeps the file referenced
+            ::close(descriptor);
+            if (address == MAP_FAILED)
+            {
+                Close();
+                return false;
+            }
+            data = static_cast<const std::byte*>(address);
+
+            // the hints are best effort, failures are ignored
+            if (access == Access::Sequential)
+                ::madvise(address, size, MADV_SEQUENTIAL);
+            else if (access == Access::Random)
+                ::madvise(address, size, MADV_RANDOM);
+#if defined(MADV_HUGEPAGE)
+            ::madvise(address, size, MADV_HUGEPAGE);
+#endif
+#endif
+            return true;
+        }
+
+        /// Unmap the file.
+        void Close() noexcept
+        {
+#if defined(_WIN32)
+            if (data != nullptr)
+                UnmapViewOfFile(data);
+            if (mapping != nullptr)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (data != nullptr)
+                ::munmap(const_cast<std::byte*>(data), size);
+#endif
+            data = nullptr;
+            size = 0;
+            opened = false;
+        }
+
+        [[nodiscard]] bool IsOpen() const noexcept { return opened; }
+
+        /// Size of the file in bytes.
+        [[nodiscard]] size_t Size() const noexcept { return size; }
+
+        [[nodiscard]] std::span<const std::byte> Bytes() const noexcept { return {data, size}; }
+
+        /// Get a dense view of a volume of type T, which starts offset bytes into
+        /// the file, e.g. after a header.
+        template<class T>
+        [[nodiscard]] VolumeView<T> View(const int3& dimension, size_t offset = 0) const noexcept
+        {
+            assert(offset % alignof(T) == 0 && "Volume offset is misaligned");
+            assert(offset + size_t(dimension[0]) * size_t(dimension[1]) * size_t(dimension[2]) * sizeof(T) <= size && "File is smaller than the volume");
+            return VolumeView<T>(reinterpret_cast<const T*>(data + offset), dimension);
+        }
+
+    private:
+        const std::byte* data = nullptr;
+        size_t size = 0;
+        bool opened = false;
+#if defined(_WIN32)
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_MAPPED_FILE_H_INCLUDED
@@ -0,0 +1,184 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_MESH_ENCODING_H_INCLUDED
+#define DUALMC_MESH_ENCODING_H_INCLUDED
+
+/// \file   mesh_encoding.hpp
+/// Compact encodings of extracted vertices and indices.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+
+// stl includes
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+#include <limits>
+#include <type_traits>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    /// Vertex coordinates are quantized to 16 or 32-bit unsigned integers.
+    template<class C>
+    concept QuantizedCoordinate = std::is_same_v<C, uint16_t> || std::is_same_v<C, uint32_t>;
+
+    /// \class  QuantizedVertex
+    /// Fixed point vertex, whose coordinates relative to an origin hold the
+    /// cell coordinate in the high bits and the quantized offset of the dual
+    /// point inside of the cell in the low fractionBits bits. A dual point lies
+    /// inside of its cell, so e.g. 8 fractional bits of a 16-bit coordinate
+    /// cover chunks of 255 cells with a resolution of 1/256 cell.
+    template<QuantizedCoordinate C>
+    struct QuantizedVertex
+    {
+        using CoordinateType = C;
+
+        std::array<CoordinateType, 3> position;
+    };
+
+    /// Origin and fixed point format of quantized vertices.
+    struct VertexQuantization
+    {
+        /// position of the coordinate 0, e.g. the origin of a chunk
+        float3 origin{0, 0, 0};
+        /// bits of the quantized in-cell offset, usually 8 or 16
+        int32_t fractionBits = 8;
+    };
+
+    /// Quantize vertices into out, which must hold as many vertices. Returns
+    /// false if a vertex lies below the origin or beyond the largest cell
+    /// coordinate, whose vertices are clamped then.
+    template<QuantizedCoordinate C>
+    bool QuantizeVertices(std::span<const Vertex> vertices, const VertexQuantization& quantization, std::span<QuantizedVertex<C>> out) noexcept
+    {
+        assert(out.size() >= vertices.size() && "Output is smaller than the vertices");
+        assert(quantization.fractionBits >= 0 && quantization.fractionBits < int32_t(8 * sizeof(C)) && "Fraction bits are invalid");
+
+        // vertex positions are exact in double precision
+        const double scale = std::ldexp(1.0, quantization.fractionBits);
+        const double maximum = double(std::numeric_limits<C>::max());
+        bool inside = true;
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            for (int32_t axis = 0; axis < 3; ++axis)
+            {
+                double value = std::round((double(vertices[i].position[axis]) - double(quantization.origin[axis])) * scale);
+                inside = inside && value >= 0.0 && value <= maximum;
+                out[i].position[axis] = static_cast<C>(std::clamp(value, 0.0, maximum));
+            }
+        }
+        return inside;
+    }
+
+    /// Get the position of a quantized vertex.
+    template<QuantizedCoordinate C>
+    [[nodiscard]] float3 DequantizeVertex(const QuantizedVertex<C>& vertex, const VertexQuantization& quantization) noexcept
+    {
+        const float scale = std::ldexp(1.0f, -quantization.fractionBits);
+        return {
+            quantization.origin[0] + float(vertex.position[0]) * scale,
+            quantization.origin[1] + float(vertex.position[1]) * scale,
+            quantization.origin[2] + float(vertex.position[2]) * scale
+        };
+    }
+
+    namespace detail
+    {
+        inline void AppendVarint(std::vector<uint8_t>& out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        /// Map signed deltas to unsigned values with small magnitudes first.
+        inline uint64_t ZigZag(int64_t value) noexcept
+        {
+            return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+        }
+
+        inline int64_t UnZigZag(uint64_t value) noexcept
+        {
+            return int64_t(value >> 1) ^ -int64_t(value & 1);
+        }
+    } // END: namespace detail
+
+    /// Encode the indices of faces of faceSize corners into a byte stream.
+    /// The first corner of a face is stored as delta to the first corner of
+    /// the previous face, the other corners as delta to the first corner. The
+    /// faces of a slice reference nearby dual points, so most deltas are small
+    /// and fit into one or two bytes of a zigzag varint.
+    template<MeshIndex I>
+    std::vector<uint8_t> EncodeIndices(std::span<const I> indices, size_t faceSize)
+    {
+        assert(faceSize > 0 && indices.size() % faceSize == 0 && "Indices do not form whole faces");
+        std::vector<uint8_t> out;
+        out.reserve(indices.size() + indices.size() / 2);
+
+        int64_t previous = 0;
+        for (size_t i = 0; i < indices.size(); i += faceSize)
+        {
+            const int64_t first = int64_t(indices[i]);
+            detail::AppendVarint(out, detail::ZigZag(first - previous));
+            for (size_t corner = 1; corner < faceSize; ++corner)
+            {
+                detail::AppendVarint(out, detail::ZigZag(int64_t(indices[i + corner]) - first));
+            }
+            previous = first;
+        }
+        return out;
+    }
+
+    /// Decode a byte stream of EncodeIndices into indices, which must hold
+    /// the encoded number of indices. Returns false if the stream is truncated.
+    template<MeshIndex I>
+    bool DecodeIndices(std::span<const uint8_t> encoded, size_t faceSize, std::span<I> indices) noexcept
+    {
+        assert(faceSize > 0 && indices.size() % faceSize == 0 && "Indices do not form whole faces");
+        size_t position = 0;
+        auto readVarint = [&](uint64_t& value)
+        {
+            value = 0;
+            for (int32_t shift = 0; position < encoded.size() && shift < 64; shift += 7)
+            {
+                uint8_t byte = encoded[position++];
+                value |= uint64_t(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                    return true;
+            }
+            return false;
+        };
+
+        int64_t previous = 0;
+        for (size_t i = 0; i < indices.size(); i += faceSize)
+        {
+            uint64_t value;
+            if (!readVarint(value))
+                return false;
+            const int64_t first = previous + detail::UnZigZag(value);
+            indices[i] = static_cast<I>(first);
+            for (size_t corner = 1; corner < faceSize; ++corner)
+            {
+                if (!readVarint(value))
+                    return false;
+                indices[i + corner] = static_cast<I>(first + detail::UnZigZag(value));
+            }
+            previous = first;
+        }
+        return true;
+    }
+
+} // END: namespace dualmc
+#endif // DUALMC_MESH_ENCODING_H_INCLUDED
@@ -0,0 +1,422 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_MESH_WRITER_H_INCLUDED
+#define DUALMC_MESH_WRITER_H_INCLUDED
+
+/// \file   mesh_writer.hpp
+/// Buffered writers for binary PLY, binary STL and Wavefront OBJ meshes.
+
+// c includes
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+// stl includes
+#include <array>
+#include <bit>
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    /// Number of indices of a face of the given topology.
+    constexpr size_t GetFaceSize(Topology topology) noexcept
+    {
+        return topology == Topology::Quads ? 4 : 3;
+    }
+
+    namespace detail
+    {
+        /// \class  OutputFile
+        /// Binary output file, which collects small writes in a large buffer.
+        /// Text is formatted directly into the buffer.
+        class OutputFile
+        {
+        public:
+            static constexpr size_t Capacity = size_t(1) << 22;
+
+            explicit OutputFile(const std::string& path)
+                : file(std::fopen(path.c_str(), "wb")), buffer(new char[Capacity])
+            {
+                ok = file != nullptr;
+            }
+
+            OutputFile(const OutputFile&) = delete;
+            OutputFile& operator=(const OutputFile&) = delete;
+
+            ~OutputFile()
+            {
+                Close();
+            }
+
+            [[nodiscard]] bool IsOpen() const noexcept { return file != nullptr; }
+
+            /// Get room for at least size bytes, which are added by Commit.
+            char* Reserve(size_t size) noexcept
+            {
+                if (position + size > Capacity)
+                    Flush();
+                return buffer.get() + position;
+            }
+
+            void Commit(const char* end) noexcept
+            {
+                position = size_t(end - buffer.get());
+            }
+
+            void Append(const void* data, size_t size) noexcept
+            {
+                if (size > Capacity)
+                {
+                    Flush();
+                    ok = ok && file != nullptr && std::fwrite(data, 1, size, file) == size;
+                    return;
+                }
+                std::memcpy(Reserve(size), data, size);
+                position += size;
+            }
+
+            void Append(std::string_view text) noexcept
+            {
+                Append(text.data(), text.size());
+            }
+
+            /// Append a value in little endian byte order.
+            template<class T>
+            void AppendLittle(T value) noexcept
+            {
+                char* out = Reserve(sizeof(T));
+                std::memcpy(out, &value, sizeof(T));
+                if constexpr (std::endian::native == std::endian::big)
+                {
+                    for (size_t i = 0; i < sizeof(T) / 2; ++i)
+                        std::swap(out[i], out[sizeof(T) - 1 - i]);
+                }
+                position += sizeof(T);
+            }
+
+            /// Write the buffer to the file.
+            void Flush() noexcept
+            {
+                if (position > 0 && file != nullptr)
+                {
+                    ok = ok && std::fwrite(buffer.get(), 1, position, file) == position;
+                }
+                position = 0;
+            }
+
+            /// Flush and close the file. Returns false if any write failed.
+            bool Close() noexcept
+            {
+                if (file == nullptr)
+                    return false;
+                Flush();
+                ok = std::fclose(file) == 0 && ok;
+                file = nullptr;
+                return ok;
+            }
+
+        private:
+            std::FILE* file = nullptr;
+            std::unique_ptr<char[]> buffer;
+            size_t position = 0;
+            bool ok = false;
+        };
+
+        /// Append the shortest round-trip representation of a value and a
+        /// separator.
+        template<class T>
+        void AppendNumber(OutputFile& out, T value, char separator) noexcept
+        {
+            // enough for the longest float and 64-bit integer
+            constexpr size_t MaxLength = 32;
+            char* first = out.Reserve(MaxLength);
+            char* last = std::to_chars(first, first + MaxLength - 1, value).ptr;
+            *last++ = separator;
+            out.Commit(last);
+        }
+
+        /// Append the vertex lines of an OBJ file.
+        inline void AppendObjVertices(OutputFile& out, std::span<const Vertex> vertices) noexcept
+        {
+            for (const Vertex& vertex : vertices)
+            {
+                out.Append("v ");
+                AppendNumber(out, vertex.position[0], ' ');
+                AppendNumber(out, vertex.position[1], ' ');
+                AppendNumber(out, vertex.position[2], '\n');
+            }
+        }
+
+        /// Append the vertex normal lines of an OBJ file.
+        inline void AppendObjNormals(OutputFile& out, std::span<const float3> normals) noexcept
+        {
+            for (const float3& normal : normals)
+            {
+                out.Append("vn ");
+                AppendNumber(out, normal[0], ' ');
+                AppendNumber(out, normal[1], ' ');
+                AppendNumber(out, normal[2], '\n');
+            }
+        }
+
+        /// Append the face lines of an OBJ file. OBJ indices start at 1. With
+        /// normals, each corner references the normal of its vertex.
+        template<MeshIndex I>
+        void AppendObjFaces(OutputFile& out, std::span<const I> indices, size_t faceSize, bool normals = false) noexcept
+        {
+            for (size_t i = 0; i + faceSize <= indices.size(); i += faceSize)
+            {
+                out.Append("f ");
+                for (size_t corner = 0; corner < faceSize; ++corner)
+                {
+                    const char separator = corner + 1 == faceSize ? '\n' : ' ';
+                    if (normals)
+                    {
+                        AppendNumber(out, uint64_t(indices[i + corner]) + 1, '/');
+                        out.Append("/");
+                        AppendNumber(out, uint64_t(indices[i + corner]) + 1, separator);
+                    }
+                    else
+                    {
+                        AppendNumber(out, uint64_t(indices[i + corner]) + 1, separator);
+                    }
+                }
+            }
+        }
+    } // END: namespace detail
+
+    /// Write a mesh as Wavefront OBJ file. Numbers are formatted with
+    /// std::to_chars into a large buffer, which is written in blocks. Vertex
+    /// normals are written if the mesh has them.
+    /// Returns false if the file could not be written.
+    template<MeshIndex I>
+    bool WriteOBJ(const std::string& path, const BasicMesh<I>& mesh, Topology topology)
+    {
+        detail::OutputFile out(path);
+        if (!out.IsOpen())
+            return false;
+
+        const bool normals = !mesh.normals.empty();
+        detail::AppendObjVertices(out, mesh.vertices);
+        detail::AppendObjNormals(out, mesh.normals);
+        detail::AppendObjFaces<I>(out, mesh.indices, GetFaceSize(topology), normals);
+        return out.Close();
+    }
+
+    /// Write a mesh as binary PLY file in the byte order of the machine.
+    /// Vertex normals are written if the mesh has them.
+    /// PLY has no 64-bit integers, so meshes with more than 2^32 vertices
+    /// cannot be written and false is returned.
+    template<MeshIndex I>
+    bool WritePLY(const std::string& path, const BasicMesh<I>& mesh, Topology topology)
+    {
+        if (mesh.vertices.size() > std::numeric_limits<uint32_t>::max())
+            return false;
+
+        detail::OutputFile out(path);
+        if (!out.IsOpen())
+            return false;
+
+        const size_t faceSize = GetFaceSize(topology);
+        const size_t faceCount = mesh.indices.size() / faceSize;
+        std::string header = "ply\nformat ";
+        header += std::endian::native == std::endian::little ? "binary_little_endian" : "binary_big_endian";
+        header += " 1.0\nelement vertex " + std::to_string(mesh.vertices.size());
+        const bool normals = !mesh.normals.empty();
+        header += "\nproperty float x\nproperty float y\nproperty float z";
+        if (normals)
+            header += "\nproperty float nx\nproperty float ny\nproperty float nz";
+        header += "\nelement face " + std::to_string(faceCount);
+        header += "\nproperty list uchar uint vertex_indices\nend_header\n";
+        out.Append(header);
+
+        for (size_t i = 0; i < mesh.vertices.size(); ++i)
+        {
+            out.Append(mesh.vertices[i].position.data(), sizeof(float3));
+            if (normals)
+                out.Append(mesh.normals[i].data(), sizeof(float3));
+        }
+
+        // a face is its corner count followed by the corner indices
+        std::array<char, 1 + 4 * sizeof(uint32_t)> face;
+        face[0] = static_cast<char>(faceSize);
+        for (size_t i = 0; i < faceCount * faceSize; i += faceSize)
+        {
+            for (size_t corner = 0; corner < faceSize; ++corner)
+            {
+                uint32_t index = static_cast<uint32_t>(mesh.indices[i + corner]);
+                std::memcpy(&face[1 + corner * sizeof(uint32_t)], &index, sizeof(uint32_t));
+            }
+            out.Append(face.data(), 1 + faceSize * sizeof(uint32_t));
+        }
+        return out.Close();
+    }
+
+    /// Write a mesh as binary STL file. Quads are split into two triangles
+    /// and facet normals are computed from the corners.
+    template<MeshIndex I>
+    bool WriteSTL(const std::string& path, const BasicMesh<I>& mesh, Topology topology)
+    {
+        const size_t faceSize = GetFaceSize(topology);
+        const size_t faceCount = mesh.indices.size() / faceSize;
+        const size_t triangleCount = faceCount * (faceSize - 2);
+        if (triangleCount > std::numeric_limits<uint32_t>::max())
+            return false;
+
+        detail::OutputFile out(path);
+        if (!out.IsOpen())
+            return false;
+
+        std::array<char, 80> header{};
+        std::memcpy(header.data(), "dualmc", 6);
+        out.Append(header.data(), header.size());
+        out.AppendLittle(static_cast<uint32_t>(triangleCount));
+
+        auto appendTriangle = [&](const float3& a, const float3& b, const float3& c)
+        {
+            float3 u = b - a;
+            float3 v = c - a;
+            float3 normal{u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            normal = length > 0.0f ? normal * (1.0f / length) : float3{0, 0, 0};
+            for (const float3& p : {normal, a, b, c})
+            {
+                out.AppendLittle(p[0]);
+                out.AppendLittle(p[1]);
+                out.AppendLittle(p[2]);
+            }
+            out.AppendLittle(uint16_t(0));
+        };
+
+        for (size_t i = 0; i < faceCount * faceSize; i += faceSize)
+        {
+            const float3& p0 = mesh.vertices[mesh.indices[i]].position;
+            for (size_t corner = 1; corner + 1 < faceSize; ++corner)
+            {
+                appendTriangle(p0, mesh.vertices[mesh.indices[i + corner]].position, mesh.vertices[mesh.indices[i + corner + 1]].position);
+            }
+        }
+        return out.Close();
+    }
+
+    /// \class  ObjStreamWriter
+    /// Writes the batches of a streamed extraction as OBJ file on a writer
+    /// thread, so formatting overlaps with extraction. Write matches the
+    /// MeshSink of Mesher::BuildStreamed. At most MaxQueuedBatches batches
+    /// are queued, after which Write waits for the writer thread.
+    template<MeshIndex I = uint32_t>
+    class ObjStreamWriter
+    {
+    public:
+        using IndexType = I;
+
+        static constexpr size_t MaxQueuedBatches = 8;
+
+        ObjStreamWriter(const std::string& path, Topology topology)
+            : out(path), faceSize(GetFaceSize(topology))
+        {
+            if (out.IsOpen())
+            {
+                writer = std::jthread([this]() { Run(); });
+            }
+        }
+
+        ObjStreamWriter(const ObjStreamWriter&) = delete;
+        ObjStreamWriter& operator=(const ObjStreamWriter&) = delete;
+
+        ~ObjStreamWriter()
+        {
+            Close();
+        }
+
+        [[nodiscard]] bool IsOpen() const noexcept { return writer.joinable(); }
+
+        /// Queue a batch of vertices and indices for writing.
+        void Write(std::span<const Vertex> vertices, std::span<const IndexType> indices)
+        {
+            if (!IsOpen())
+                return;
+
+            Batch batch{{vertices.begin(), vertices.end()}, {indices.begin(), indices.end()}};
+            std::unique_lock lock(mutex);
+            queueChanged.wait(lock, [this]() { return queue.size() < MaxQueuedBatches; });
+            queue.push_back(std::move(batch));
+            queueChanged.notify_all();
+        }
+
+        /// Write the remaining batches and close the file. Returns false if
+        /// the file could not be written.
+        bool Close()
+        {
+            if (writer.joinable())
+            {
+                {
+                    std::lock_guard lock(mutex);
+                    closing = true;
+                }
+                queueChanged.notify_all();
+                writer.join();
+                result = out.Close();
+            }
+            return result;
+        }
+
+    private:
+        struct Batch
+        {
+            std::vector<Vertex> vertices;
+            std::vector<IndexType> indices;
+        };
+
+        void Run()
+        {
+            for (;;)
+            {
+                Batch batch;
+                {
+                    std::unique_lock lock(mutex);
+                    queueChanged.wait(lock, [this]() { return closing || !queue.empty(); });
+                    if (queue.empty())
+                        return;
+                    batch = std::move(queue.front());
+                    queue.pop_front();
+                }
+                queueChanged.notify_all();
+
+                // faces only reference vertices of the same or of earlier batches
+                detail::AppendObjVertices(out, batch.vertices);
+                detail::AppendObjFaces<IndexType>(out, batch.indices, faceSize);
+            }
+        }
+
+        detail::OutputFile out;
+        size_t faceSize;
+        bool result = false;
+
+        std::mutex mutex;
+        std::condition_variable queueChanged;
+        std::deque<Batch> queue;
+        bool closing = false;
+        std::jthread writer;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_MESH_WRITER_H_INCLUDED
@@ -0,0 +1,261 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_MESHLETS_H_INCLUDED
+#define DUALMC_MESHLETS_H_INCLUDED
+
+/// \file   meshlets.hpp
+/// Extraction of triangle meshes ordered by bricks of cells along a Morton
+/// curve and partitioned into meshlets for mesh shaders, with vertices in the
+/// order of their first use.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+
+// stl includes
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <limits>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    /// Cluster of at most MeshletMesher::GetMaxVertices vertices and
+    /// GetMaxTriangles triangles. Its vertices are
+    /// meshletVertices[vertexOffset,vertexOffset+vertexCount) and its
+    /// triangles are triples of local vertex indices in
+    /// meshletTriangles[3*triangleOffset,3*(triangleOffset+triangleCount)).
+    struct Meshlet
+    {
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+        uint32_t triangleOffset = 0;
+        uint32_t triangleCount = 0;
+        /// bounding box of the vertices
+        float3 boundsMin{0.f, 0.f, 0.f};
+        float3 boundsMax{0.f, 0.f, 0.f};
+    };
+
+    /// Triangle mesh with its meshlets. The triangles of mesh are the ones of
+    /// the meshlets in their order, so it can be drawn or put into a BVH
+    /// directly.
+    template<MeshIndex I = uint32_t>
+    struct MeshletMesh
+    {
+        BasicMesh<I> mesh;
+        std::vector<Meshlet> meshlets;
+        std::vector<I> meshletVertices;
+        std::vector<uint8_t> meshletTriangles;
+    };
+
+    /// \class  MeshletMesher
+    /// Extracts the triangles of Mesher and orders them for the vertex cache
+    /// and spatial locality. Triangles are grouped by bricks of cells, whose
+    /// lower corners follow a Morton curve, and keep the order of extraction
+    /// inside of a brick. Consecutive triangles are packed into meshlets
+    /// until a limit is reached, and vertices are renumbered in the order
+    /// the meshlets first use them, so the vertices of a meshlet are close
+    /// in memory. The ordering uses the cells of the dual points reported by
+    /// the extraction, so no spatial sort of the vertices is needed.
+    template<class T, MeshIndex I = uint32_t>
+    requires VoxelType<T>
+    class MeshletMesher
+    {
+    public:
+        using VolumeDataType = T;
+        using IndexType = I;
+        using MeshType = BasicMesh<IndexType>;
+        using MeshletMeshType = MeshletMesh<IndexType>;
+
+        /// Order by bricks of brickSize^3 cells and pack meshlets with at most
+        /// maxVertices vertices and maxTriangles triangles, by default the
+        /// limits suggested for mesh shaders.
+        explicit MeshletMesher(int32_t brickSize = 4, uint32_t maxVertices = 64, uint32_t maxTriangles = 124)
+            : brickSize(brickSize), maxVertices(maxVertices), maxTriangles(maxTriangles)
+        {
+            assert(brickSize > 0 && "Brick size has to be positive");
+            assert(maxVertices >= 3 && maxVertices <= 256 && "Local vertex indices have to fit into 8 bits");
+            assert(maxTriangles > 0 && "Meshlets need at least one triangle");
+        }
+
+        void SetNormals(Normals value) noexcept { mesher.SetNormals(value); }
+        void SetPlacement(Placement value) noexcept { mesher.SetPlacement(value); }
+
+        [[nodiscard]] uint32_t GetMaxVertices() const noexcept { return maxVertices; }
+        [[nodiscard]] uint32_t GetMaxTriangles() const noexcept { return maxTriangles; }
+
+        [[nodiscard]] MeshletMeshType Build(
+            const std::span<const VolumeDataType>& data,
+            const int3& dimension,
+            VolumeDataType iso,
+            Manifold manifold = Manifold::On)
+        {
+            assert(data.size() >= size_t(dimension[0]) * size_t(dimension[1]) * size_t(dimension[2]) && "Volume data is smaller than extent");
+            MeshletMeshType result;
+            Build(VolumeView<VolumeDataType>(data.data(), dimension), iso, result, manifold);
+            return result;
+        }
+
+        /// Extracts the iso surface of a volume view into a caller-owned
+        /// meshlet mesh, whose previous content is replaced. The triangles
+        /// and vertices are the ones of Mesher::Build in another order.
+        void Build(
+            const VolumeView<VolumeDataType>& volume,
+            VolumeDataType iso,
+            MeshletMeshType& result,
+            Manifold manifold = Manifold::On)
+        {
+            assert(!(volume.extent[0] < 0 || volume.extent[1] < 0 || volume.extent[2] < 0) && "Dimension is invalid");
+            mesher.BuildSubdomain(volume, {0, 0, 0}, volume.extent, iso, {0, 0, 0}, volume.extent, mesh, &dualPoints, Topology::Triangles, manifold);
+            SortTriangles();
+            PackMeshlets(result);
+        }
+
+    private:
+        /// Interleave the lower 21 bits of x, y and z.
+        static uint64_t GetMortonCode(const int3& brick) noexcept
+        {
+            auto spread = [](uint64_t x)
+            {
+                x &= 0x1fffff;
+                x = (x | x << 32) & 0x1f00000000ffffull;
+                x = (x | x << 16) & 0x1f0000ff0000ffull;
+                x = (x | x << 8) & 0x100f00f00f00f00full;
+                x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+                x = (x | x << 2) & 0x1249249249249249ull;
+                return x;
+            };
+            return spread(uint64_t(brick[0])) | spread(uint64_t(brick[1])) << 1 | spread(uint64_t(brick[2])) << 2;
+        }
+
+        /// Sort the triangles by the Morton code of the brick of their cell,
+        /// which is the maximum of the cells of their dual points.
+        void SortTriangles()
+        {
+            const size_t triangleCount = mesh.indices.size() / 3;
+            triangles.resize(triangleCount);
+            for (size_t t = 0; t < triangleCount; ++t)
+            {
+                int3 brick = dualPoints[mesh.indices[3 * t]].cell;
+                for (size_t corner = 1; corner < 3; ++corner)
+                {
+                    const int3& cell = dualPoints[mesh.indices[3 * t + corner]].cell;
+                    for (int32_t i = 0; i < 3; ++i)
+                    {
+                        brick[i] = std::max(brick[i], cell[i]);
+                    }
+                }
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    brick[i] /= brickSize;
+                }
+                triangles[t] = {GetMortonCode(brick), uint32_t(t)};
+            }
+            // faces are extracted in z,y,x order of their cells, so the triangle
+            // index keeps this order inside of a brick
+            std::sort(triangles.begin(), triangles.end());
+        }
+
+        /// Pack the sorted triangles into meshlets and renumber the vertices.
+        void PackMeshlets(MeshletMeshType& result)
+        {
+            const size_t vertexCount = mesh.vertices.size();
+            constexpr IndexType unused = std::numeric_limits<IndexType>::max();
+            remap.assign(vertexCount, unused);
+            localIndex.assign(vertexCount, 0);
+            meshletOfVertex.assign(vertexCount, std::numeric_limits<uint32_t>::max());
+
+            MeshType& out = result.mesh;
+            out.vertices.resize(vertexCount);
+            out.normals.resize(mesh.normals.empty() ? 0 : vertexCount);
+            out.indices.resize(mesh.indices.size());
+            result.meshlets.clear();
+            result.meshletVertices.clear();
+            result.meshletTriangles.clear();
+            result.meshletTriangles.reserve(mesh.indices.size());
+
+            size_t nextVertex = 0;
+            size_t nextIndex = 0;
+            Meshlet meshlet;
+            for (const auto& [code, t] : triangles)
+            {
+                const IndexType* corners = &mesh.indices[3 * size_t(t)];
+                const uint32_t meshletId = uint32_t(result.meshlets.size());
+                uint32_t newVertices = 0;
+                for (size_t corner = 0; corner < 3; ++corner)
+                {
+                    newVertices += meshletOfVertex[corners[corner]] != meshletId ? 1 : 0;
+                }
+                if (meshlet.triangleCount == maxTriangles || meshlet.vertexCount + newVertices > maxVertices)
+                {
+                    FinishMeshlet(result, meshlet);
+                }
+
+                for (size_t corner = 0; corner < 3; ++corner)
+                {
+                    const IndexType v = corners[corner];
+                    if (remap[v] == unused)
+                    {
+                        remap[v] = static_cast<IndexType>(nextVertex);
+                        out.vertices[nextVertex] = mesh.vertices[v];
+                        if (!out.normals.empty())
+                            out.normals[nextVertex] = mesh.normals[v];
+                        ++nextVertex;
+                    }
+                    if (meshletOfVertex[v] != uint32_t(result.meshlets.size()))
+                    {
+                        meshletOfVertex[v] = uint32_t(result.meshlets.size());
+                        localIndex[v] = uint8_t(meshlet.vertexCount++);
+                        result.meshletVertices.push_back(remap[v]);
+                        Extend(meshlet, out.vertices[remap[v]].position);
+                    }
+                    result.meshletTriangles.push_back(localIndex[v]);
+                    out.indices[nextIndex++] = remap[v];
+                }
+                ++meshlet.triangleCount;
+            }
+            if (meshlet.triangleCount > 0)
+            {
+                FinishMeshlet(result, meshlet);
+            }
+            assert(nextVertex == vertexCount && "Unreferenced vertices");
+        }
+
+        static void Extend(Meshlet& meshlet, const float3& position) noexcept
+        {
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                meshlet.boundsMin[i] = meshlet.vertexCount == 1 ? position[i] : std::min(meshlet.boundsMin[i], position[i]);
+                meshlet.boundsMax[i] = meshlet.vertexCount == 1 ? position[i] : std::max(meshlet.boundsMax[i], position[i]);
+            }
+        }
+
+        static void FinishMeshlet(MeshletMeshType& result, Meshlet& meshlet)
+        {
+            result.meshlets.push_back(meshlet);
+            meshlet = Meshlet{};
+            meshlet.vertexOffset = uint32_t(result.meshletVertices.size());
+            meshlet.triangleOffset = uint32_t(result.meshletTriangles.size() / 3);
+        }
+
+        int32_t brickSize;
+        uint32_t maxVertices;
+        uint32_t maxTriangles;
+        Mesher<VolumeDataType, IndexType> mesher;
+        /// scratch buffers of Build
+        MeshType mesh;
+        std::vector<DualPointId> dualPoints;
+        std::vector<std::pair<uint64_t, uint32_t>> triangles;
+        std::vector<IndexType> remap;
+        std::vector<uint8_t> localIndex;
+        std::vector<uint32_t> meshletOfVertex;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_MESHLETS_H_INCLUDED
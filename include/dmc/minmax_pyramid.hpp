@@ -0,0 +1,328 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_MINMAX_PYRAMID_H_INCLUDED
+#define DUALMC_MINMAX_PYRAMID_H_INCLUDED
+
+/// \file   minmax_pyramid.hpp
+/// Min/max acceleration structure for skipping empty regions of a volume.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+
+// stl includes
+#include <vector>
+#include <span>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+
+// dual mc includes
+#include "types.hpp"
+#include "volume_view.hpp"
+#include "bricked_volume.hpp"
+
+namespace dualmc
+{
+    /// \class  MinMaxPyramid
+    /// Stores the value range of cubic bricks of cells of a volume. A brick of
+    /// brickSize^3 cells covers (brickSize+1)^3 voxels, as the cells of a brick
+    /// also reference the first voxels of the neighboring bricks. Bricks are
+    /// merged 2x2x2 into coarser levels until a single node remains.
+    /// A region holds surface for an iso value only if some of its voxels are
+    /// inside (>= iso) and some are outside (< iso). The pyramid does not
+    /// depend on the iso value, so it can be reused for many extractions of
+    /// the same volume.
+    template<class T>
+    requires VoxelType<T>
+    class MinMaxPyramid
+    {
+    public:
+        using VolumeDataType = T;
+
+        /// Value range of a brick or pyramid node.
+        struct Range
+        {
+            VolumeDataType min;
+            VolumeDataType max;
+        };
+
+        MinMaxPyramid() = default;
+
+        MinMaxPyramid(std::span<const VolumeDataType> data, const int3& dimension, int32_t brickSize = 8)
+        {
+            Build(data, dimension, brickSize);
+        }
+
+        explicit MinMaxPyramid(const VolumeView<VolumeDataType>& volume, int32_t brickSize = 8)
+        {
+            Build(volume, brickSize);
+        }
+
+        explicit MinMaxPyramid(const BrickedVolume<VolumeDataType>& volume, int32_t brickSize = 8)
+        {
+            Build(volume, brickSize);
+        }
+
+        /// Compute the value ranges of all bricks and pyramid levels.
+        void Build(std::span<const VolumeDataType> data, const int3& dimension, int32_t brickSize = 8)
+        {
+            assert(data.size() >= size_t(dimension[0]) * size_t(dimension[1]) * size_t(dimension[2]) && "Volume data is smaller than extent");
+            Build(VolumeView<VolumeDataType>(data, dimension), brickSize);
+        }
+
+        /// Compute the value ranges of all bricks and pyramid levels of a
+        /// volume view with arbitrary strides.
+        void Build(const VolumeView<VolumeDataType>& volume, int32_t brickSize = 8)
+        {
+            BuildLevels(volume.extent, brickSize, [&](const int3& begin, const int3& end)
+            {
+                return volume.IsRowContiguous()
+                    ? ComputeBoxRange<true>(volume, begin, end)
+                    : ComputeBoxRange<false>(volume, begin, end);
+            });
+        }
+
+        /// Compute the value ranges of all bricks and pyramid levels of a
+        /// bricked volume. Its rows are copied brick by brick.
+        void Build(const BrickedVolume<VolumeDataType>& volume, int32_t brickSize = 8)
+        {
+            std::vector<VolumeDataType> row;
+            BuildLevels(volume.Extent(), brickSize, [&](const int3& begin, const int3& end)
+            {
+                row.resize(size_t(end[0] - begin[0]));
+                Range range = EmptyRange();
+                for (int32_t z = begin[2]; z < end[2]; ++z)
+                {
+                    for (int32_t y = begin[1]; y < end[1]; ++y)
+                    {
+                        volume.CopyRow(y, z, begin[0], end[0], row.data());
+                        for (VolumeDataType value : row)
+                        {
+                            Accumulate(range, value);
+                        }
+                    }
+                }
+                return range;
+            });
+        }
+
+        /// Check if the pyramid has not been built yet.
+        [[nodiscard]] bool Empty() const noexcept { return levels.empty(); }
+
+        /// Volume extent the pyramid was built for.
+        [[nodiscard]] const int3& Extent() const noexcept { return extent; }
+
+        /// Number of cells per brick along each axis.
+        [[nodiscard]] int32_t BrickSize() const noexcept { return brickSize; }
+
+        /// Number of pyramid levels, level 0 holds the bricks.
+        [[nodiscard]] size_t LevelCount() const noexcept { return levels.size(); }
+
+        /// Number of nodes of a level along each axis.
+        [[nodiscard]] const int3& LevelSize(size_t level) const noexcept { return levels[level].size; }
+
+        /// Value range of a node of a level.
+        [[nodiscard]] const Range& GetRange(size_t level, const int3& node) const noexcept
+        {
+            return levels[level].ranges[levels[level].Index(node[0], node[1], node[2])];
+        }
+
+        /// Check if the value range straddles the iso value.
+        [[nodiscard]] static bool IsActive(const Range& range, VolumeDataType iso) noexcept
+        {
+            return range.max >= iso && range.min < iso;
+        }
+
+        /// Check if the brick holding the cell might hold surface.
+        [[nodiscard]] bool IsBrickActive(const int3& brick, VolumeDataType iso) const noexcept
+        {
+            return IsActive(GetRange(0, brick), iso);
+        }
+
+        /// Check if any brick overlapping the cells in [cellMin,cellMax] might
+        /// hold surface. The pyramid is descended from the top, so large empty
+        /// regions are rejected early.
+        [[nodiscard]] bool IsCellBoxActive(const int3& cellMin, const int3& cellMax, VolumeDataType iso) const noexcept
+        {
+            int3 brickMin;
+            int3 brickMax;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                brickMin[i] = std::max(cellMin[i], 0) / brickSize;
+                brickMax[i] = std::min(cellMax[i] / brickSize, levels[0].size[i] - 1);
+                if (brickMin[i] > brickMax[i])
+                    return false;
+            }
+            return IsNodeActive(levels.size() - 1, {0, 0, 0}, brickMin, brickMax, iso);
+        }
+
+    private:
+        struct Level
+        {
+            int3 size{0, 0, 0};
+            std::vector<Range> ranges;
+
+            size_t Index(int32_t x, int32_t y, int32_t z) const noexcept
+            {
+                return size_t(x) + size_t(size[0]) * (size_t(y) + size_t(size[1]) * size_t(z));
+            }
+        };
+
+        static void Merge(Range& range, const Range& other) noexcept
+        {
+            range.min = std::min(range.min, other.min);
+            range.max = std::max(range.max, other.max);
+        }
+
+        static constexpr Range EmptyRange() noexcept
+        {
+            return {VoxelLimits<VolumeDataType>::max(), VoxelLimits<VolumeDataType>::lowest()};
+        }
+
+        static void Accumulate(Range& range, VolumeDataType value) noexcept
+        {
+            if constexpr (IsFloatingVoxel<VolumeDataType>)
+            {
+                // NaN voxels are always outside
+                if (value != value)
+                    value = -VoxelLimits<VolumeDataType>::infinity();
+            }
+            range.min = std::min(range.min, value);
+            range.max = std::max(range.max, value);
+        }
+
+        /// Compute the value ranges of the bricks of level 0 with computeRange,
+        /// which is given the voxel box [begin,end) of a brick, and merge them
+        /// into the coarser levels.
+        template<class BoxRange>
+        void BuildLevels(const int3& dimension, int32_t brickSize, const BoxRange& computeRange)
+        {
+            assert(!(dimension[0] < 1 || dimension[1] < 1 || dimension[2] < 1) && "Dimension is invalid");
+            assert(brickSize > 0 && "Brick size is invalid");
+
+            extent = dimension;
+            this->brickSize = brickSize;
+            levels.clear();
+
+            // bricks of level 0
+            Level level;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                int32_t cells = std::max(extent[i] - 1, 1);
+                level.size[i] = (cells + brickSize - 1) / brickSize;
+            }
+            level.ranges.assign(size_t(level.size[0]) * size_t(level.size[1]) * size_t(level.size[2]), Range{});
+
+            for (int32_t bz = 0; bz < level.size[2]; ++bz)
+            {
+                for (int32_t by = 0; by < level.size[1]; ++by)
+                {
+                    for (int32_t bx = 0; bx < level.size[0]; ++bx)
+                    {
+                        // the cells of a brick also reference the first voxels of the next bricks
+                        int3 brick{bx, by, bz};
+                        int3 begin;
+                        int3 end;
+                        for (int32_t i = 0; i < 3; ++i)
+                        {
+                            begin[i] = brick[i] * brickSize;
+                            end[i] = std::min(begin[i] + brickSize + 1, extent[i]);
+                        }
+                        level.ranges[level.Index(bx, by, bz)] = computeRange(begin, end);
+                    }
+                }
+            }
+            levels.push_back(std::move(level));
+
+            // merge 2x2x2 nodes until a single node is left
+            while (levels.back().size[0] > 1 || levels.back().size[1] > 1 || levels.back().size[2] > 1)
+            {
+                const Level& fine = levels.back();
+                Level coarse;
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    coarse.size[i] = (fine.size[i] + 1) / 2;
+                }
+                coarse.ranges.assign(size_t(coarse.size[0]) * size_t(coarse.size[1]) * size_t(coarse.size[2]), Range{});
+
+                for (int32_t z = 0; z < coarse.size[2]; ++z)
+                {
+                    for (int32_t y = 0; y < coarse.size[1]; ++y)
+                    {
+                        for (int32_t x = 0; x < coarse.size[0]; ++x)
+                        {
+                            Range range = fine.ranges[fine.Index(2 * x, 2 * y, 2 * z)];
+                            for (int32_t c = 1; c < 8; ++c)
+                            {
+                                int3 child{2 * x + (c & 1), 2 * y + ((c >> 1) & 1), 2 * z + (c >> 2)};
+                                if (child[0] < fine.size[0] && child[1] < fine.size[1] && child[2] < fine.size[2])
+                                {
+                                    Merge(range, fine.ranges[fine.Index(child[0], child[1], child[2])]);
+                                }
+                            }
+                            coarse.ranges[coarse.Index(x, y, z)] = range;
+                        }
+                    }
+                }
+                levels.push_back(std::move(coarse));
+            }
+        }
+
+        /// Compute the value range of the voxels in [begin,end) of a view.
+        /// Rows with adjacent voxels are read with unit stride.
+        template<bool ContiguousRows>
+        static Range ComputeBoxRange(const VolumeView<VolumeDataType>& volume, const int3& begin, const int3& end) noexcept
+        {
+            Range range = EmptyRange();
+            for (int32_t z = begin[2]; z < end[2]; ++z)
+            {
+                for (int32_t y = begin[1]; y < end[1]; ++y)
+                {
+                    const VolumeDataType* row = volume.Row(y, z);
+                    const ptrdiff_t stride = ContiguousRows ? 1 : volume.strides[0];
+                    for (int32_t x = begin[0]; x < end[0]; ++x)
+                    {
+                        Accumulate(range, row[ptrdiff_t(x) * stride]);
+                    }
+                }
+            }
+            return range;
+        }
+
+        /// Check if a node overlaps any active brick of [brickMin,brickMax].
+        bool IsNodeActive(size_t level, const int3& node, const int3& brickMin, const int3& brickMax, VolumeDataType iso) const noexcept
+        {
+            if (!IsActive(GetRange(level, node), iso))
+                return false;
+            if (level == 0)
+                return true;
+
+            const Level& fine = levels[level - 1];
+            for (int32_t c = 0; c < 8; ++c)
+            {
+                int3 child{2 * node[0] + (c & 1), 2 * node[1] + ((c >> 1) & 1), 2 * node[2] + (c >> 2)};
+                bool inside = true;
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    // the child covers bricks [child << (level-1), (child+1) << (level-1))
+                    int32_t first = child[i] << int32_t(level - 1);
+                    int32_t last = ((child[i] + 1) << int32_t(level - 1)) - 1;
+                    inside = inside && child[i] < fine.size[i] && first <= brickMax[i] && last >= brickMin[i];
+                }
+                if (inside && IsNodeActive(level - 1, child, brickMin, brickMax, iso))
+                    return true;
+            }
+            return false;
+        }
+
+        int3 extent{0, 0, 0};
+        int32_t brickSize = 8;
+        std::vector<Level> levels;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_MINMAX_PYRAMID_H_INCLUDED
@@ -0,0 +1,729 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_OCTREE_MESHER_H_INCLUDED
+#define DUALMC_OCTREE_MESHER_H_INCLUDED
+
+/// \file   octree_mesher.hpp
+/// Adaptive dual marching cubes on an octree, whose leaves are merged where
+/// the surface is flat enough.
+
+// c includes
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+
+// stl includes
+#include <vector>
+#include <span>
+#include <array>
+#include <algorithm>
+#include <limits>
+
+// dual mc includes
+#include "dualmc.hpp"
+
+namespace dualmc
+{
+    /// \class  OctreeMesher
+    /// Extracts the iso surface of a volume with a number of faces following
+    /// the geometric complexity of the surface instead of the resolution of
+    /// the volume. An octree is built over the cells of Mesher. Subtrees
+    /// without surface are dropped, and the leaves of a node are merged into
+    /// a single leaf if the minimum of their combined QEF has an error of at
+    /// most errorTolerance and the node passes the topology test of "Dual
+    /// Contouring of Hermite Data" from Ju et al. Faces are constructed for
+    /// the minimal edges of the octree with a sign change, which connect the
+    /// dual points of the four leaves around them.
+    /// Cells, which are not merged, get the (manifold) dual marching cubes
+    /// points of Mesher with mean placement, merged leaves a single dual
+    /// point at the minimum of their QEF. With a negative errorTolerance no
+    /// leaves are merged and the faces are those of Mesher.
+    /// Normals are not computed.
+    template<class T, MeshIndex I = uint32_t>
+    requires VoxelType<T>
+    class OctreeMesher
+    {
+    public:
+        using VolumeDataType = T;
+        using IndexType = I;
+        using MeshType = BasicMesh<IndexType>;
+
+        /// Leaves are merged up to maxLeafSize cells along each axis, which
+        /// must be a power of two. The error is the sum of the squared
+        /// distances in cells of the merged dual point to the planes of the
+        /// edge intersections.
+        explicit OctreeMesher(float errorTolerance = 0.01f, int32_t maxLeafSize = 16)
+            : errorTolerance(errorTolerance), maxLeafSize(maxLeafSize)
+        {
+            assert(maxLeafSize > 0 && (maxLeafSize & (maxLeafSize - 1)) == 0 && "Maximum leaf size is not a power of two");
+        }
+
+        [[nodiscard]] MeshType Build(
+            const std::span<const VolumeDataType>& data,
+            const int3& dimension,
+            VolumeDataType iso,
+            Topology topology = Topology::Triangles,
+            Manifold manifold = Manifold::On,
+            const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+        {
+            assert(data.size() >= size_t(dimension[0]) * size_t(dimension[1]) * size_t(dimension[2]) && "Volume data is smaller than extent");
+            MeshType mesh;
+            Build(VolumeView<VolumeDataType>(data.data(), dimension), iso, mesh, topology, manifold, pyramid);
+            return mesh;
+        }
+
+        [[nodiscard]] MeshType Build(
+            const VolumeView<VolumeDataType>& volume,
+            VolumeDataType iso,
+            Topology topology = Topology::Triangles,
+            Manifold manifold = Manifold::On,
+            const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+        {
+            MeshType mesh;
+            Build(volume, iso, mesh, topology, manifold, pyramid);
+            return mesh;
+        }
+
+        /// Extracts the iso surface of a volume view into a caller-owned mesh,
+        /// whose previous content is replaced. An optional min/max pyramid of
+        /// the volume skips the subtrees of empty bricks.
+        void Build(
+            const VolumeView<VolumeDataType>& volume,
+            VolumeDataType iso,
+            MeshType& mesh,
+            Topology topology = Topology::Triangles,
+            Manifold manifold = Manifold::On,
+            const MinMaxPyramid<VolumeDataType>* pyramid = nullptr)
+        {
+            assert(!(volume.extent[0] < 0 || volume.extent[1] < 0 || volume.extent[2] < 0) && "Dimension is invalid");
+            assert((pyramid == nullptr || pyramid->Extent() == volume.extent) && "Pyramid does not match the volume");
+
+            this->volume = volume;
+            this->iso = iso;
+            this->topology = topology;
+            this->manifold = manifold;
+            this->pyramid = pyramid;
+            this->mesh = &mesh;
+            instructionSet = kernels::ActiveInstructionSet();
+            mesh.vertices.clear();
+            mesh.indices.clear();
+            mesh.normals.clear();
+            nodes.clear();
+            leafCount = 0;
+
+            // the faces of the cells in [0,dimension-4) are constructed as by Mesher
+            int32_t rootSize = maxLeafSize;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                cellCount[i] = std::max(volume.extent[i] - 4, 0);
+                while (rootSize < cellCount[i])
+                {
+                    rootSize *= 2;
+                }
+            }
+            if (cellCount[0] == 0 || cellCount[1] == 0 || cellCount[2] == 0)
+                return;
+
+            ProcessCell(BuildNode({0, 0, 0}, rootSize));
+        }
+
+        /// Number of leaves holding surface of the last extraction.
+        [[nodiscard]] size_t LeafCount() const noexcept { return leafCount; }
+
+        [[nodiscard]] float ErrorTolerance() const noexcept { return errorTolerance; }
+        [[nodiscard]] int32_t MaxLeafSize() const noexcept { return maxLeafSize; }
+
+    private:
+        /// Marks a missing child, which holds no surface or is outside of the cells.
+        static constexpr int32_t Empty = -1;
+        /// Marks a dual point without a vertex.
+        static constexpr IndexType InvalidIndex = std::numeric_limits<IndexType>::max();
+
+        using DMCEdgeCode = tables::DMCEdgeCode;
+        using enum tables::DMCEdgeCode;
+        static constexpr const auto& dualPointsList = tables::dualPointsList;
+        static constexpr const auto& problematicConfigs = tables::problematicConfigs;
+
+        /// \class  Node
+        /// Node of the size^3 cells starting at origin. Children are numbered
+        /// like the cell corners, with the x, y and z offsets in bits 0, 1 and 2.
+        struct Node
+        {
+            int3 origin;
+            int32_t size;
+            std::array<int32_t, 8> children;
+            /// Cube code of the corners of a leaf after the manifold test.
+            /// Interior nodes have no dual points.
+            uint8_t code = 0;
+            uint8_t pointCount = 0;
+            /// a leaf with a single merged or unambiguous dual point and its QEF
+            bool mergeable = false;
+            /// QEF relative to origin
+            qef::Qef qef;
+            /// dual point of a merged leaf
+            float3 point{0, 0, 0};
+            /// vertices of the dual points, created when a face references them
+            std::array<IndexType, 4> vertices;
+        };
+
+        /// Edge codes of the cell edges along each axis, by the offsets of the
+        /// edge along the other two axes in ascending order.
+        static constexpr std::array<std::array<DMCEdgeCode, 4>, 3> axisEdges{{
+            {EDGE0, EDGE4, EDGE2, EDGE6},
+            {EDGE8, EDGE9, EDGE11, EDGE10},
+            {EDGE3, EDGE1, EDGE7, EDGE5}
+        }};
+
+        /// Build the subtree of the size^3 cells at origin and return its node.
+        int32_t BuildNode(const int3& origin, int32_t size)
+        {
+            int3 last;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                if (origin[i] >= cellCount[i])
+                    return Empty;
+                last[i] = std::min(origin[i] + size, cellCount[i]) - 1;
+            }
+            if (pyramid != nullptr && !pyramid->IsCellBoxActive(origin, last, iso))
+                return Empty;
+
+            // the cells of the largest leaves are classified at once
+            if (size == maxLeafSize && !ClassifyBrick(origin))
+                return Empty;
+
+            if (size == 1)
+                return BuildCell(origin);
+
+            const size_t firstChild = nodes.size();
+            const int32_t half = size / 2;
+            std::array<int32_t, 8> children;
+            bool active = false;
+            for (int32_t c = 0; c < 8; ++c)
+            {
+                children[c] = BuildNode({origin[0] + (c & 1) * half, origin[1] + ((c >> 1) & 1) * half, origin[2] + (c >> 2) * half}, half);
+                active |= children[c] != Empty;
+            }
+            if (!active)
+                return Empty;
+
+            if (size <= maxLeafSize && MergeChildren(origin, size, children, firstChild))
+                return static_cast<int32_t>(nodes.size() - 1);
+
+            Node& node = nodes.emplace_back();
+            node.origin = origin;
+            node.size = size;
+            node.children = children;
+            return static_cast<int32_t>(nodes.size() - 1);
+        }
+
+        /// Compute the cube codes of the cells of the largest leaf at origin
+        /// with the classification kernels of Mesher. Returns false if no cell
+        /// holds surface.
+        bool ClassifyBrick(const int3& origin)
+        {
+            brickOrigin = origin;
+            int3 count;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                count[i] = std::min(maxLeafSize, cellCount[i] - origin[i]);
+            }
+
+            // inside masks of the voxel rows of the cells
+            const size_t width = size_t(count[0]) + 1;
+            insideMasks.resize(width * size_t(count[1] + 1) * size_t(count[2] + 1));
+            rowBuffer.resize(width);
+            for (int32_t z = 0; z <= count[2]; ++z)
+            {
+                for (int32_t y = 0; y <= count[1]; ++y)
+                {
+                    const VolumeDataType* row = &volume(origin[0], origin[1] + y, origin[2] + z);
+                    if (!volume.IsRowContiguous())
+                    {
+                        for (size_t x = 0; x < width; ++x)
+                        {
+                            rowBuffer[x] = row[ptrdiff_t(x) * volume.strides[0]];
+                        }
+                        row = rowBuffer.data();
+                    }
+                    kernels::ClassifyRow(instructionSet, row, width, iso, &insideMasks[(size_t(z) * size_t(count[1] + 1) + size_t(y)) * width]);
+                }
+            }
+
+            const size_t brickSize = size_t(maxLeafSize);
+            brickCodes.assign(brickSize * brickSize * brickSize, 0);
+            bool active = false;
+            for (int32_t z = 0; z < count[2]; ++z)
+            {
+                for (int32_t y = 0; y < count[1]; ++y)
+                {
+                    auto mask = [&](int32_t dy, int32_t dz)
+                    {
+                        return &insideMasks[(size_t(z + dz) * size_t(count[1] + 1) + size_t(y + dy)) * width];
+                    };
+                    uint8_t* codes = &brickCodes[(size_t(z) * brickSize + size_t(y)) * brickSize];
+                    kernels::AssembleCubeCodes(instructionSet, mask(0, 0), mask(1, 0), mask(0, 1), mask(1, 1), size_t(count[0]), codes);
+                    for (int32_t x = 0; x < count[0] && !active; ++x)
+                    {
+                        active = codes[x] != 0 && codes[x] != 255;
+                    }
+                }
+            }
+            return active;
+        }
+
+        /// Create the leaf of a cell holding surface.
+        int32_t BuildCell(const int3& cell)
+        {
+            const size_t brickSize = size_t(maxLeafSize);
+            int32_t cubeCode = brickCodes[(size_t(cell[2] - brickOrigin[2]) * brickSize + size_t(cell[1] - brickOrigin[1])) * brickSize + size_t(cell[0] - brickOrigin[0])];
+            if (cubeCode == 0 || cubeCode == 255)
+                return Empty;
+
+            const bool problematic = manifold == Manifold::On && problematicConfigs[cubeCode] != 255;
+            Node& node = nodes.emplace_back();
+            node.origin = cell;
+            node.size = 1;
+            node.children.fill(Empty);
+            node.vertices.fill(InvalidIndex);
+            node.code = static_cast<uint8_t>(problematic ? ResolveCellCode(cell, cubeCode) : cubeCode);
+            node.pointCount = GetPointCount(node.code);
+            ++leafCount;
+
+            // C16 and C19 cells are not merged, as the manifold test of their
+            // neighbors reads their cube code
+            node.mergeable = errorTolerance >= 0.0f && node.pointCount == 1 && !problematic;
+            if (node.mergeable)
+            {
+                AddCellPlanes(cell, dualPointsList[node.code][0], node.qef);
+            }
+            return static_cast<int32_t>(nodes.size() - 1);
+        }
+
+        /// Replace the children of a node by a single leaf, if they are mergeable
+        /// leaves, the surface of the node is a single unambiguous patch, which
+        /// passes the topology test, and the error of the merged dual point is
+        /// small enough. The children are the nodes from firstChild on.
+        bool MergeChildren(const int3& origin, int32_t size, const std::array<int32_t, 8>& children, size_t firstChild)
+        {
+            if (errorTolerance < 0.0f)
+                return false;
+
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                if (origin[i] + size > cellCount[i])
+                    return false;
+            }
+            for (int32_t child : children)
+            {
+                if (child != Empty && !nodes[child].mergeable)
+                    return false;
+            }
+
+            const int32_t cubeCode = ComputeCubeCode(origin, size);
+            if (GetPointCount(cubeCode) != 1 || (manifold == Manifold::On && problematicConfigs[cubeCode] != 255))
+                return false;
+            if (!IsTopologySafe(origin, size))
+                return false;
+
+            qef::Qef qef;
+            for (int32_t child : children)
+            {
+                if (child == Empty)
+                    continue;
+                const Node& node = nodes[child];
+                qef.Add(node.qef, float3{float(node.origin[0] - origin[0]), float(node.origin[1] - origin[1]), float(node.origin[2] - origin[2])});
+            }
+            float3 p = qef::Solve(qef);
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                p[i] = std::clamp(p[i], 0.0f, float(size));
+            }
+            if (qef::Error(qef, p) > errorTolerance)
+                return false;
+
+            // the merged children are the last nodes
+            leafCount -= nodes.size() - firstChild - 1;
+            nodes.resize(firstChild);
+
+            Node& node = nodes.emplace_back();
+            node.origin = origin;
+            node.size = size;
+            node.children.fill(Empty);
+            node.vertices.fill(InvalidIndex);
+            node.code = static_cast<uint8_t>(cubeCode);
+            node.pointCount = 1;
+            node.mergeable = true;
+            node.qef = qef;
+            node.point = {float(origin[0]) + p[0], float(origin[1]) + p[1], float(origin[2]) + p[2]};
+            return true;
+        }
+
+        /// Check the signs of the 27 voxels at the corners, edge midpoints, face
+        /// centers and center of a node. The sign at each midpoint must match the
+        /// sign of one of the corners of its edge, face or cube, so merging does
+        /// not change the topology of the surface.
+        bool IsTopologySafe(const int3& origin, int32_t size) const noexcept
+        {
+            const int32_t half = size / 2;
+            auto inside = [&](int32_t i, int32_t j, int32_t k)
+            {
+                return volume(origin[0] + i * half, origin[1] + j * half, origin[2] + k * half) >= iso;
+            };
+
+            for (int32_t point = 0; point < 27; ++point)
+            {
+                const int3 p{point % 3, (point / 3) % 3, point / 9};
+                int32_t midpoints = 0;
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    midpoints |= (p[i] == 1 ? 1 : 0) << i;
+                }
+                if (midpoints == 0)
+                    continue;
+
+                // corners of the edge, face or cube, whose midpoint is p
+                const bool sign = inside(p[0], p[1], p[2]);
+                bool matched = false;
+                for (int32_t corner = 0; corner < 8 && !matched; ++corner)
+                {
+                    if ((corner & ~midpoints) != 0)
+                        continue;
+                    int3 q = p;
+                    for (int32_t i = 0; i < 3; ++i)
+                    {
+                        if (midpoints & (1 << i))
+                            q[i] = (corner >> i) & 1 ? 2 : 0;
+                    }
+                    matched = inside(q[0], q[1], q[2]) == sign;
+                }
+                if (!matched)
+                    return false;
+            }
+            return true;
+        }
+
+        /// Cube code of the corners of the size^3 cells at origin.
+        int32_t ComputeCubeCode(const int3& origin, int32_t size = 1) const noexcept
+        {
+            int32_t cubeCode = 0;
+            for (int32_t corner = 0; corner < 8; ++corner)
+            {
+                if (volume(origin[0] + (corner & 1) * size, origin[1] + ((corner >> 1) & 1) * size, origin[2] + (corner >> 2) * size) >= iso)
+                    cubeCode |= 1 << corner;
+            }
+            return cubeCode;
+        }
+
+        /// Apply the manifold test of Mesher to the C16 or C19 cube code of a
+        /// cell, whose neighbor is classified from the voxels.
+        int32_t ResolveCellCode(const int3& cell, int32_t cubeCode) const noexcept
+        {
+            return cells::ResolveCellCode(cell, cubeCode, volume.extent,
+                [this](const int3& neighbor) { return ComputeCubeCode(neighbor); });
+        }
+
+        static uint8_t GetPointCount(int32_t cubeCode) noexcept
+        {
+            uint8_t count = 0;
+            for (int32_t slot = 0; slot < 4; ++slot)
+            {
+                count += dualPointsList[cubeCode][slot] != 0 ? 1 : 0;
+            }
+            return count;
+        }
+
+        /// Get the corner values of a cell as Mesher converts them.
+        std::array<cells::IntersectionType<VolumeDataType>, 8> GetCorners(const int3& cell) const noexcept
+        {
+            std::array<cells::IntersectionType<VolumeDataType>, 8> corners;
+            for (int32_t corner = 0; corner < 8; ++corner)
+            {
+                corners[size_t(corner)] = static_cast<cells::IntersectionType<VolumeDataType>>(
+                    volume(cell[0] + (corner & 1), cell[1] + ((corner >> 1) & 1), cell[2] + (corner >> 2)));
+            }
+            return corners;
+        }
+
+        /// Compute the dual point of a cell with the given point code as the
+        /// mean of its edge intersections, as Mesher does.
+        float3 CalculateDualPoint(const int3& cell, int32_t pointCode) const noexcept
+        {
+            const float3 p = cells::CalculateDualPoint(pointCode, GetCorners(cell), static_cast<cells::IntersectionType<VolumeDataType>>(iso),
+                [](const cells::EdgeDef&, const float3&, float) {});
+            return {static_cast<float>(cell[0]) + p[0], static_cast<float>(cell[1]) + p[1], static_cast<float>(cell[2]) + p[2]};
+        }
+
+        /// Add the planes of the edge intersections of a dual point, relative to
+        /// its cell, with the central difference gradients as normals.
+        void AddCellPlanes(const int3& cell, int32_t pointCode, qef::Qef& qef) const noexcept
+        {
+            cells::CalculateDualPoint(pointCode, GetCorners(cell), static_cast<cells::IntersectionType<VolumeDataType>>(iso),
+                [&](const cells::EdgeDef& edge, const float3& pos, float t)
+                {
+                    int3 origin{cell[0] + edge.oX, cell[1] + edge.oY, cell[2] + edge.oZ};
+                    int3 end = origin;
+                    end[edge.axis] += 1;
+                    float3 gradient = GetVoxelGradient(origin) * (1.0f - t) + GetVoxelGradient(end) * t;
+                    float length = std::sqrt(gradient[0] * gradient[0] + gradient[1] * gradient[1] + gradient[2] * gradient[2]);
+                    qef.Add(pos, length > 0.0f ? gradient * (1.0f / length) : float3{0, 0, 0});
+                });
+        }
+
+        /// Get the central difference gradient at a voxel, as Mesher does.
+        float3 GetVoxelGradient(const int3& voxel) const noexcept
+        {
+            return cells::GetVoxelGradient(voxel, volume.extent,
+                [this](const int3& v) { return volume(v[0], v[1], v[2]); });
+        }
+
+        [[nodiscard]] bool IsLeaf(int32_t node) const noexcept
+        {
+            return nodes[node].pointCount > 0;
+        }
+
+        /// Get the child of a node, or the node itself if it is a leaf.
+        [[nodiscard]] int32_t GetChild(int32_t node, int32_t child) const noexcept
+        {
+            return IsLeaf(node) ? node : nodes[node].children[child];
+        }
+
+        /// Construct the faces of the edges inside of a node.
+        void ProcessCell(int32_t node)
+        {
+            if (node == Empty || IsLeaf(node))
+                return;
+
+            for (int32_t c = 0; c < 8; ++c)
+            {
+                ProcessCell(nodes[node].children[c]);
+            }
+
+            for (int32_t axis = 0; axis < 3; ++axis)
+            {
+                // faces between the children along axis
+                for (int32_t c = 0; c < 8; ++c)
+                {
+                    if ((c >> axis) & 1)
+                        continue;
+                    ProcessFace(nodes[node].children[c], nodes[node].children[c | (1 << axis)], axis);
+                }
+
+                // edges along axis through the center, surrounded by four children
+                const int32_t f = axis == 0 ? 1 : 0;
+                const int32_t g = axis == 2 ? 1 : 2;
+                for (int32_t h = 0; h < 2; ++h)
+                {
+                    std::array<int32_t, 4> around;
+                    for (int32_t j = 0; j < 4; ++j)
+                    {
+                        around[j] = nodes[node].children[(h << axis) | ((j & 1) << f) | ((j >> 1) << g)];
+                    }
+                    ProcessEdge(around, axis);
+                }
+            }
+        }
+
+        /// Construct the faces of the edges on the face between two nodes,
+        /// which are neighbors along axis.
+        void ProcessFace(int32_t lower, int32_t upper, int32_t axis)
+        {
+            if (lower == Empty || upper == Empty || (IsLeaf(lower) && IsLeaf(upper)))
+                return;
+
+            const int32_t a = 1 << axis;
+            for (int32_t c = 0; c < 8; ++c)
+            {
+                if (c & a)
+                    continue;
+                ProcessFace(GetChild(lower, c | a), GetChild(upper, c), axis);
+            }
+
+            // edges on the face along the other two axes
+            for (int32_t edgeAxis = 0; edgeAxis < 3; ++edgeAxis)
+            {
+                if (edgeAxis == axis)
+                    continue;
+                const int32_t other = 3 - axis - edgeAxis;
+                const int32_t f = std::min(axis, other);
+                const int32_t g = std::max(axis, other);
+                for (int32_t h = 0; h < 2; ++h)
+                {
+                    std::array<int32_t, 4> around;
+                    for (int32_t j = 0; j < 4; ++j)
+                    {
+                        // the side along axis selects the node, whose children
+                        // next to the face are taken
+                        int32_t bits[3];
+                        bits[f] = j & 1;
+                        bits[g] = j >> 1;
+                        const int32_t node = bits[axis] ? upper : lower;
+                        bits[axis] = 1 - bits[axis];
+                        bits[edgeAxis] = h;
+                        around[j] = GetChild(node, bits[0] | (bits[1] << 1) | (bits[2] << 2));
+                    }
+                    ProcessEdge(around, edgeAxis);
+                }
+            }
+        }
+
+        /// Construct the faces of an edge along axis surrounded by four nodes.
+        /// Node j is on the upper side of the edge along the first and second
+        /// of the other axes if bit 0 and bit 1 of j are set.
+        void ProcessEdge(const std::array<int32_t, 4>& around, int32_t axis)
+        {
+            bool leaves = true;
+            for (int32_t node : around)
+            {
+                if (node == Empty)
+                    return;
+                leaves &= IsLeaf(node);
+            }
+            if (leaves)
+            {
+                ConstructFace(around, axis);
+                return;
+            }
+
+            const int32_t f = axis == 0 ? 1 : 0;
+            const int32_t g = axis == 2 ? 1 : 2;
+            for (int32_t h = 0; h < 2; ++h)
+            {
+                std::array<int32_t, 4> children;
+                for (int32_t j = 0; j < 4; ++j)
+                {
+                    children[j] = GetChild(around[j], (h << axis) | ((1 - (j & 1)) << f) | ((1 - (j >> 1)) << g));
+                }
+                ProcessEdge(children, axis);
+            }
+        }
+
+        /// Emit the face of a minimal edge between four leaves, if the surface
+        /// crosses it. The edge belongs to the smallest leaf. Corners and
+        /// orientation follow the faces of Mesher.
+        void ConstructFace(const std::array<int32_t, 4>& around, int32_t axis)
+        {
+            int32_t smallest = 0;
+            for (int32_t j = 1; j < 4; ++j)
+            {
+                if (nodes[around[j]].size < nodes[around[smallest]].size)
+                    smallest = j;
+            }
+
+            const int32_t f = axis == 0 ? 1 : 0;
+            const int32_t g = axis == 2 ? 1 : 2;
+            const Node& node = nodes[around[smallest]];
+            int3 begin = node.origin;
+            begin[f] += smallest & 1 ? 0 : node.size;
+            begin[g] += smallest >> 1 ? 0 : node.size;
+            int3 end = begin;
+            end[axis] += node.size;
+
+            const bool inside = volume(begin[0], begin[1], begin[2]) >= iso;
+            if (inside == (volume(end[0], end[1], end[2]) >= iso))
+                return;
+
+            // node order of the cells (x,y,z), (x,y,z-1), (x,y-1,z-1), (x,y-1,z) of Mesher
+            static constexpr std::array<std::array<uint8_t, 4>, 3> order{{{3, 1, 0, 2}, {3, 1, 0, 2}, {3, 2, 0, 1}}};
+            std::array<IndexType, 4> corners;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                const int32_t j = order[axis][i];
+                corners[i] = GetVertex(around[j], axisEdges[axis][(1 - (j & 1)) + 2 * (1 - (j >> 1))]);
+            }
+
+            static constexpr std::array<uint8_t, 4> quad{0, 1, 2, 3};
+            static constexpr std::array<uint8_t, 4> flippedQuad{0, 3, 2, 1};
+            static constexpr std::array<uint8_t, 6> triangles{0, 1, 2, 2, 3, 0};
+            static constexpr std::array<uint8_t, 6> flippedTriangles{2, 1, 0, 0, 3, 2};
+            // Two corners are the same leaf, if it is larger than the leaves on
+            // the other side of its face. The quad degenerates to a triangle
+            // then, and the degenerate triangle of a pair is dropped.
+            auto emit = [&](const auto& order)
+            {
+                if constexpr (std::tuple_size_v<std::remove_cvref_t<decltype(order)>> == 6)
+                {
+                    for (size_t i = 0; i < order.size(); i += 3)
+                    {
+                        IndexType a = corners[order[i]];
+                        IndexType b = corners[order[i + 1]];
+                        IndexType c = corners[order[i + 2]];
+                        if (a == b || b == c || c == a)
+                            continue;
+                        mesh->indices.insert(mesh->indices.end(), {a, b, c});
+                    }
+                }
+                else
+                {
+                    for (uint8_t i : order)
+                    {
+                        mesh->indices.push_back(corners[i]);
+                    }
+                }
+            };
+
+            // the face along x keeps its order if the edge starts inside, the
+            // faces along y and z if it starts outside
+            if (axis == 0 ? inside : !inside)
+            {
+                if (topology == Topology::Quads)
+                    emit(quad);
+                else
+                    emit(triangles);
+            }
+            else
+            {
+                if (topology == Topology::Quads)
+                    emit(flippedQuad);
+                else
+                    emit(flippedTriangles);
+            }
+        }
+
+        /// Get the vertex of the dual point of a leaf belonging to the given
+        /// cell edge, which is created on first use.
+        IndexType GetVertex(int32_t leaf, DMCEdgeCode edge)
+        {
+            Node& node = nodes[leaf];
+            const int32_t slot = node.size == 1 ? cells::GetDualPointSlot(node.code, edge) : 0;
+            IndexType& index = node.vertices[slot];
+            if (index == InvalidIndex)
+            {
+                // the largest index marks dual points without a vertex
+                CheckVertexCount<IndexType>(mesh->vertices.size() + 1, 1);
+                index = static_cast<IndexType>(mesh->vertices.size());
+                Vertex& vertex = mesh->vertices.emplace_back();
+                vertex.position = node.size == 1 ? CalculateDualPoint(node.origin, dualPointsList[node.code][slot]) : node.point;
+            }
+            return index;
+        }
+
+        float errorTolerance;
+        int32_t maxLeafSize;
+
+        /// parameters of the current extraction
+        VolumeView<VolumeDataType> volume;
+        VolumeDataType iso{};
+        Topology topology = Topology::Triangles;
+        Manifold manifold = Manifold::On;
+        const MinMaxPyramid<VolumeDataType>* pyramid = nullptr;
+        kernels::InstructionSet instructionSet = kernels::InstructionSet::Scalar;
+        MeshType* mesh = nullptr;
+        int3 cellCount{0, 0, 0};
+
+        /// Nodes holding surface. Children are stored before their parent, so
+        /// merged children are removed from the end.
+        std::vector<Node> nodes;
+        size_t leafCount = 0;
+
+        /// cube codes of the cells of the last classified largest leaf
+        int3 brickOrigin{0, 0, 0};
+        std::vector<uint8_t> brickCodes;
+        std::vector<uint8_t> insideMasks;
+        std::vector<VolumeDataType> rowBuffer;
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_OCTREE_MESHER_H_INCLUDED
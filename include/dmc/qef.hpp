@@ -0,0 +1,205 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_QEF_H_INCLUDED
+#define DUALMC_QEF_H_INCLUDED
+
+/// \file   qef.hpp
+/// Quadric error functions for placing dual points on sharp features as in
+/// "Dual Contouring of Hermite Data" from Ju et al. The 3x3 least squares
+/// problem is solved with a fixed number of Jacobi sweeps, so the cost of a
+/// dual point is bounded and independent of the data.
+
+// c includes
+#include <cstdint>
+#include <cmath>
+
+// stl includes
+#include <array>
+#include <algorithm>
+
+// dual mc includes
+#include "types.hpp"
+
+namespace dualmc
+{
+    namespace qef
+    {
+        /// Maximum number of sweeps over the three off-diagonal elements.
+        /// Symmetric 3x3 matrices converge to float precision in three to four
+        /// sweeps.
+        constexpr int32_t JacobiSweeps = 4;
+
+        /// Eigenvalues below this fraction of the largest eigenvalue are
+        /// dropped, which keeps the solution at the mass point along directions
+        /// without features, e.g. along an edge or on a plane.
+        constexpr float Truncation = 0.1f;
+
+        /// \class  Qef
+        /// Sum of the squared distances to the planes through the edge
+        /// intersections of a dual point, which are given by the normals there.
+        struct Qef
+        {
+            /// upper triangle of A^T A in the order xx, xy, xz, yy, yz, zz
+            std::array<float, 6> ata{};
+            /// A^T b
+            float3 atb{0, 0, 0};
+            /// b^T b, which completes the error at a point
+            float btb = 0.0f;
+            /// sum of the intersections, whose mean is the mass point
+            float3 pointSum{0, 0, 0};
+            int32_t pointCount = 0;
+
+            /// Add the plane through point with the given unit normal.
+            void Add(const float3& point, const float3& normal) noexcept
+            {
+                float d = normal[0] * point[0] + normal[1] * point[1] + normal[2] * point[2];
+                ata[0] += normal[0] * normal[0];
+                ata[1] += normal[0] * normal[1];
+                ata[2] += normal[0] * normal[2];
+                ata[3] += normal[1] * normal[1];
+                ata[4] += normal[1] * normal[2];
+                ata[5] += normal[2] * normal[2];
+                atb += normal * d;
+                btb += d * d;
+                pointSum += point;
+                ++pointCount;
+            }
+
+            /// Add the planes of another QEF moved by offset, e.g. for merging
+            /// QEFs given relative to different origins. The offset is small
+            /// compared to the coordinates of the volume, so the error stays
+            /// accurate in float.
+            void Add(const Qef& other, const float3& offset) noexcept
+            {
+                const float3 shift{
+                    other.ata[0] * offset[0] + other.ata[1] * offset[1] + other.ata[2] * offset[2],
+                    other.ata[1] * offset[0] + other.ata[3] * offset[1] + other.ata[4] * offset[2],
+                    other.ata[2] * offset[0] + other.ata[4] * offset[1] + other.ata[5] * offset[2]
+                };
+                for (size_t i = 0; i < ata.size(); ++i)
+                {
+                    ata[i] += other.ata[i];
+                }
+                // the planes n.p = d become n.p = d + n.offset
+                atb += other.atb + shift;
+                btb += other.btb
+                    + 2.0f * (offset[0] * other.atb[0] + offset[1] * other.atb[1] + offset[2] * other.atb[2])
+                    + offset[0] * shift[0] + offset[1] * shift[1] + offset[2] * shift[2];
+                pointSum += other.pointSum + offset * float(other.pointCount);
+                pointCount += other.pointCount;
+            }
+
+            [[nodiscard]] float3 MassPoint() const noexcept
+            {
+                return pointCount > 0 ? pointSum * (1.0f / float(pointCount)) : float3{0, 0, 0};
+            }
+        };
+
+        using Matrix3 = std::array<std::array<float, 3>, 3>;
+
+        /// Apply the Jacobi rotation zeroing a[P][Q] to the symmetric matrix a
+        /// and accumulate it in the eigenvectors v, see Numerical Recipes
+        /// chapter 11.1. The indices are fixed, so a and v stay in registers.
+        template<int32_t P, int32_t Q>
+        inline void Rotate(Matrix3& a, Matrix3& v) noexcept
+        {
+            float apq = a[P][Q];
+            if (std::abs(apq) < 1e-20f)
+                return;
+
+            float theta = (a[Q][Q] - a[P][P]) / (2.0f * apq);
+            float t = std::copysign(1.0f, theta) / (std::abs(theta) + std::sqrt(theta * theta + 1.0f));
+            float c = 1.0f / std::sqrt(t * t + 1.0f);
+            float s = t * c;
+            for (int32_t k = 0; k < 3; ++k)
+            {
+                float akp = a[k][P];
+                float akq = a[k][Q];
+                a[k][P] = c * akp - s * akq;
+                a[k][Q] = s * akp + c * akq;
+            }
+            for (int32_t k = 0; k < 3; ++k)
+            {
+                float apk = a[P][k];
+                float aqk = a[Q][k];
+                a[P][k] = c * apk - s * aqk;
+                a[Q][k] = s * apk + c * aqk;
+            }
+            for (int32_t k = 0; k < 3; ++k)
+            {
+                float vkp = v[k][P];
+                float vkq = v[k][Q];
+                v[k][P] = c * vkp - s * vkq;
+                v[k][Q] = s * vkp + c * vkq;
+            }
+        }
+
+        /// Find the point minimizing the QEF closest to its mass point. The
+        /// problem is solved relative to the mass point with the pseudo inverse
+        /// of A^T A, whose eigen decomposition is computed by cyclic Jacobi
+        /// rotations.
+        [[nodiscard]] inline float3 Solve(const Qef& qef) noexcept
+        {
+            float3 mass = qef.MassPoint();
+            Matrix3 a{{
+                {qef.ata[0], qef.ata[1], qef.ata[2]},
+                {qef.ata[1], qef.ata[3], qef.ata[4]},
+                {qef.ata[2], qef.ata[4], qef.ata[5]}
+            }};
+
+            // right hand side relative to the mass point
+            float3 rhs = qef.atb;
+            for (int32_t i = 0; i < 3; ++i)
+            {
+                rhs[i] -= a[i][0] * mass[0] + a[i][1] * mass[1] + a[i][2] * mass[2];
+            }
+
+            Matrix3 v{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+            const float scale = a[0][0] + a[1][1] + a[2][2];
+            for (int32_t sweep = 0; sweep < JacobiSweeps; ++sweep)
+            {
+                // Jacobi sweeps converge quadratically, so most matrices are
+                // diagonal after two sweeps
+                float offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+                if (offDiagonal <= 1e-12f * scale * scale)
+                    break;
+                Rotate<0, 1>(a, v);
+                Rotate<0, 2>(a, v);
+                Rotate<1, 2>(a, v);
+            }
+
+            // x = V * diag(1/lambda) * V^T * rhs with small eigenvalues dropped
+            const float largest = std::max({std::abs(a[0][0]), std::abs(a[1][1]), std::abs(a[2][2])});
+            float3 x = mass;
+            for (int32_t j = 0; j < 3; ++j)
+            {
+                float lambda = a[j][j];
+                if (!(std::abs(lambda) > Truncation * largest) || lambda == 0.0f)
+                    continue;
+                float projection = (v[0][j] * rhs[0] + v[1][j] * rhs[1] + v[2][j] * rhs[2]) / lambda;
+                for (int32_t i = 0; i < 3; ++i)
+                {
+                    x[i] += v[i][j] * projection;
+                }
+            }
+            return x;
+        }
+
+        /// Sum of the squared distances of x to the planes of a QEF.
+        [[nodiscard]] inline float Error(const Qef& qef, const float3& x) noexcept
+        {
+            const float3 ax{
+                qef.ata[0] * x[0] + qef.ata[1] * x[1] + qef.ata[2] * x[2],
+                qef.ata[1] * x[0] + qef.ata[3] * x[1] + qef.ata[4] * x[2],
+                qef.ata[2] * x[0] + qef.ata[4] * x[1] + qef.ata[5] * x[2]
+            };
+            float error = x[0] * (ax[0] - 2.0f * qef.atb[0]) + x[1] * (ax[1] - 2.0f * qef.atb[1]) + x[2] * (ax[2] - 2.0f * qef.atb[2]) + qef.btb;
+            return std::max(error, 0.0f);
+        }
+    } // END: namespace qef
+
+} // END: namespace dualmc
+#endif // DUALMC_QEF_H_INCLUDED
@@ -0,0 +1,159 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_STATS_H_INCLUDED
+#define DUALMC_STATS_H_INCLUDED
+
+/// \file   stats.hpp
+/// Statistics and profiler zones of the extraction. Statistics are collected
+/// if DUALMC_ENABLE_STATS is defined and compiled out otherwise. Zones are
+/// reported to Tracy with DUALMC_TRACY or to Intel ITT with DUALMC_ITT, which
+/// expect the include paths and libraries of the profiler.
+
+// c includes
+#include <cstdint>
+
+// stl includes
+#include <array>
+#include <chrono>
+
+#if defined(DUALMC_TRACY)
+    #include <tracy/Tracy.hpp>
+    /// Profiler zone covering the rest of the enclosing scope.
+    #define DUALMC_ZONE(name) ZoneScopedN(name)
+#elif defined(DUALMC_ITT)
+    #include <ittnotify.h>
+    #define DUALMC_ZONE(name) \
+        static __itt_string_handle* const dualmcZoneName = __itt_string_handle_create(name); \
+        const ::dualmc::stats::IttZone dualmcZone(dualmcZoneName)
+#else
+    #define DUALMC_ZONE(name)
+#endif
+
+namespace dualmc
+{
+#if defined(DUALMC_ENABLE_STATS)
+    inline constexpr bool StatsEnabled = true;
+#else
+    inline constexpr bool StatsEnabled = false;
+#endif
+
+    /// \class  ExtractionStats
+    /// Counters and timings of an extraction. Cells, faces and dual points are
+    /// counted once, although the two-pass extractions visit them twice.
+    struct ExtractionStats
+    {
+        /// cells of face construction in slices and rows holding surface
+        uint64_t visitedCells = 0;
+        /// visited cells with a cube code other than 0 and 255
+        uint64_t activeCells = 0;
+        /// faces dual to the x, y and z edges of the cells
+        std::array<uint64_t, 3> faces{};
+        /// dual point lookups of face corners finding the vertex of an earlier
+        /// face and creating it. Parallel slabs both create the dual points on
+        /// their seam.
+        uint64_t dualPointHits = 0;
+        uint64_t dualPointMisses = 0;
+        /// cells whose cube code is inverted by the manifold test
+        uint64_t manifoldInversions = 0;
+        /// reallocations of the buffers of the output meshes
+        uint64_t reallocations = 0;
+        /// wall time of the count pass and of the fill or stream pass
+        std::chrono::nanoseconds countTime{0};
+        std::chrono::nanoseconds fillTime{0};
+        /// time of classifying cells and of the manifold test in both passes,
+        /// summed over the slabs
+        std::chrono::nanoseconds classifyTime{0};
+        std::chrono::nanoseconds resolveTime{0};
+
+        ExtractionStats& operator+=(const ExtractionStats& other) noexcept
+        {
+            visitedCells += other.visitedCells;
+            activeCells += other.activeCells;
+            for (size_t i = 0; i < faces.size(); ++i)
+            {
+                faces[i] += other.faces[i];
+            }
+            dualPointHits += other.dualPointHits;
+            dualPointMisses += other.dualPointMisses;
+            manifoldInversions += other.manifoldInversions;
+            reallocations += other.reallocations;
+            countTime += other.countTime;
+            fillTime += other.fillTime;
+            classifyTime += other.classifyTime;
+            resolveTime += other.resolveTime;
+            return *this;
+        }
+    };
+
+    namespace stats
+    {
+        /// Adds the time of its scope to a duration, if statistics are enabled.
+        class ScopedTimer
+        {
+        public:
+            explicit ScopedTimer(std::chrono::nanoseconds& duration) noexcept : duration(duration)
+            {
+                if constexpr (StatsEnabled)
+                {
+                    start = std::chrono::steady_clock::now();
+                }
+            }
+
+            ~ScopedTimer()
+            {
+                if constexpr (StatsEnabled)
+                {
+                    duration += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                }
+            }
+
+            ScopedTimer(const ScopedTimer&) = delete;
+            ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        private:
+            std::chrono::nanoseconds& duration;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        /// Count a reallocation of a buffer from its capacities before and
+        /// after growing it.
+        inline void CountReallocation(ExtractionStats& stats, size_t capacityBefore, size_t capacityAfter) noexcept
+        {
+            if constexpr (StatsEnabled)
+            {
+                stats.reallocations += capacityAfter != capacityBefore ? 1 : 0;
+            }
+        }
+
+#if defined(DUALMC_ITT)
+        inline __itt_domain* GetIttDomain() noexcept
+        {
+            static __itt_domain* const domain = __itt_domain_create("dualmc");
+            return domain;
+        }
+
+        /// ITT task covering its scope.
+        class IttZone
+        {
+        public:
+            explicit IttZone(__itt_string_handle* name) noexcept
+            {
+                __itt_task_begin(GetIttDomain(), __itt_null, __itt_null, name);
+            }
+
+            ~IttZone()
+            {
+                __itt_task_end(GetIttDomain());
+            }
+
+            IttZone(const IttZone&) = delete;
+            IttZone& operator=(const IttZone&) = delete;
+        };
+#endif
+    } // END: namespace stats
+
+} // END: namespace dualmc
+#endif // DUALMC_STATS_H_INCLUDED
@@ -0,0 +1,110 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_TYPES_H_INCLUDED
+#define DUALMC_TYPES_H_INCLUDED
+
+/// \file   types.hpp
+/// Small vector types and the voxel types shared by the dual mc headers.
+
+// c includes
+#include <cstdint>
+#include <cstddef>
+
+// stl includes
+#include <array>
+#include <bit>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+
+// Half precision voxels need compiler support for _Float16, e.g. GCC 12 or
+// Clang 15 on x86-64 and AArch64.
+#if defined(__FLT16_MAX__) && !defined(DUALMC_NO_HALF)
+    #define DUALMC_HAS_HALF 1
+#endif
+
+namespace dualmc 
+{
+	using float3 = std::array<float, 3>;
+	using int3 = std::array<int32_t, 3>;
+
+    constexpr float3 operator+(const float3& a, const float3& b) 
+    {
+        return {a[0] + b[0], a[1] + b[1], a[2] + b[2]};
+    }
+    
+    constexpr float3 operator-(const float3& a, const float3& b) 
+    {
+        return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+    }
+
+    constexpr float3 operator*(const float3& a, float s) 
+    {
+        return {a[0] * s, a[1] * s, a[2] * s};
+    }
+
+    constexpr float3& operator+=(float3& a, const float3& b) 
+    {
+        a[0] += b[0]; a[1] += b[1]; a[2] += b[2];
+        return a;
+    }
+
+#if defined(DUALMC_HAS_HALF)
+    /// Half precision voxels, which halve the memory and the bandwidth of
+    /// float volumes such as exported signed distance fields.
+    using half = _Float16;
+#endif
+
+    /// True for half precision floats.
+    template<class T>
+    inline constexpr bool IsHalf =
+#if defined(DUALMC_HAS_HALF)
+        std::is_same_v<std::remove_cv_t<T>, half>;
+#else
+        false;
+#endif
+
+    /// True for voxel types holding floating point values.
+    template<class T>
+    inline constexpr bool IsFloatingVoxel = std::is_floating_point_v<T> || IsHalf<T>;
+
+    /// Voxels hold arithmetic values or half precision floats.
+    template<class T>
+    concept VoxelType = std::is_arithmetic_v<T> || IsHalf<T>;
+
+    /// std::numeric_limits of a voxel type, which are not specialized for
+    /// half precision floats by all standard libraries.
+    template<class T>
+    struct VoxelLimits : std::numeric_limits<T> {};
+
+#if defined(DUALMC_HAS_HALF)
+    template<>
+    struct VoxelLimits<half>
+    {
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_signed = true;
+
+        static constexpr half lowest() noexcept { return std::bit_cast<half>(uint16_t(0xfbff)); }
+        static constexpr half max() noexcept { return std::bit_cast<half>(uint16_t(0x7bff)); }
+        static constexpr half infinity() noexcept { return std::bit_cast<half>(uint16_t(0x7c00)); }
+    };
+#endif
+
+    /// Throws std::length_error if vertexCount vertices cannot be addressed by
+    /// indices of type I, whose reservedCount largest values are reserved as
+    /// markers, e.g. of unused slots. Meshers check their vertex counts before
+    /// writing indices, so indices never wrap in release builds.
+    template<class I>
+    void CheckVertexCount(size_t vertexCount, size_t reservedCount = 0)
+    {
+        static_assert(std::is_unsigned_v<I>, "Indices are unsigned");
+        if (vertexCount > 0 && vertexCount - 1 > size_t(std::numeric_limits<I>::max()) - reservedCount)
+            throw std::length_error("dualmc: too many vertices for the index type");
+    }
+
+} // END: namespace dualmc
+#endif // DUALMC_TYPES_H_INCLUDED
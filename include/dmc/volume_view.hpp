@@ -0,0 +1,88 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+#ifndef DUALMC_VOLUME_VIEW_H_INCLUDED
+#define DUALMC_VOLUME_VIEW_H_INCLUDED
+
+/// \file   volume_view.hpp
+/// Non-owning strided view of the voxels of a volume.
+
+// c includes
+#include <cstdint>
+#include <cstddef>
+
+// stl includes
+#include <array>
+#include <span>
+
+// dual mc includes
+#include "types.hpp"
+
+namespace dualmc
+{
+    /// Distances in elements between neighboring voxels along x, y and z.
+    using stride3 = std::array<ptrdiff_t, 3>;
+
+    /// \class  VolumeView
+    /// Read-only view of a volume, whose voxel (x,y,z) is found at
+    /// data[x*strides[0] + y*strides[1] + z*strides[2]]. Strides may be arbitrary,
+    /// which covers padded rows, interleaved channels, sub-boxes of larger
+    /// arrays and flipped axes. Dense volumes are stored x-fastest.
+    template<class T>
+    struct VolumeView
+    {
+        const T* data = nullptr;
+        int3 extent{0, 0, 0};
+        stride3 strides{0, 0, 0};
+
+        constexpr VolumeView() = default;
+
+        /// View of a dense volume.
+        constexpr VolumeView(const T* data, const int3& extent) noexcept
+            : data(data), extent(extent), strides{1, ptrdiff_t(extent[0]), ptrdiff_t(extent[0]) * ptrdiff_t(extent[1])}
+        {
+        }
+
+        /// View of a dense volume held by a span.
+        constexpr VolumeView(std::span<const T> data, const int3& extent) noexcept
+            : VolumeView(data.data(), extent)
+        {
+        }
+
+        constexpr VolumeView(const T* data, const int3& extent, const stride3& strides) noexcept
+            : data(data), extent(extent), strides(strides)
+        {
+        }
+
+        /// View of the box [begin,begin+size) of this view.
+        [[nodiscard]] constexpr VolumeView SubView(const int3& begin, const int3& size) const noexcept
+        {
+            return {&(*this)(begin[0], begin[1], begin[2]), size, strides};
+        }
+
+        /// Check if the voxels of a row are adjacent in memory, so rows can be
+        /// read in place.
+        [[nodiscard]] constexpr bool IsRowContiguous() const noexcept { return strides[0] == 1; }
+
+        /// Check if the view is a dense x-fastest volume.
+        [[nodiscard]] constexpr bool IsDense() const noexcept
+        {
+            return strides[0] == 1 && strides[1] == ptrdiff_t(extent[0]) && strides[2] == ptrdiff_t(extent[0]) * ptrdiff_t(extent[1]);
+        }
+
+        /// Get the first voxel of the row (y,z).
+        [[nodiscard]] constexpr const T* Row(int32_t y, int32_t z) const noexcept
+        {
+            return data + ptrdiff_t(y) * strides[1] + ptrdiff_t(z) * strides[2];
+        }
+
+        [[nodiscard]] constexpr const T& operator()(int32_t x, int32_t y, int32_t z) const noexcept
+        {
+            return Row(y, z)[ptrdiff_t(x) * strides[0]];
+        }
+    };
+
+} // END: namespace dualmc
+#endif // DUALMC_VOLUME_VIEW_H_INCLUDED
@@ -0,0 +1,266 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+// Declarations shared by the dual marching cubes compute shaders. The shaders
+// are written for Vulkan and compiled to SPIR-V, e.g. with
+//
+//     glslc -fshader-stage=compute dualmc_classify.comp -o dualmc_classify.spv
+//
+// The voxel type is selected with DUALMC_VOXEL_UINT8 or DUALMC_VOXEL_UINT16,
+// which read voxels packed into 32-bit words. Floats are read otherwise.
+// Buffer layouts and the dispatch order are documented in dmc/gpu.hpp.
+
+#ifndef DUALMC_COMMON_GLSL
+#define DUALMC_COMMON_GLSL
+
+#define DUALMC_WORKGROUP_SIZE 64
+
+// indices into the counter buffer, see dualmc::gpu::Counters
+#define DUALMC_COUNTER_ACTIVE_CELLS 0
+#define DUALMC_COUNTER_VERTICES 1
+#define DUALMC_COUNTER_INDICES 2
+#define DUALMC_COUNTER_ACTIVE_DISPATCH 3
+#define DUALMC_COUNTER_SCAN_DISPATCH 6
+#define DUALMC_COUNTER_DRAW 15
+
+#define DUALMC_SCAN_BLOCK_SIZE 512
+#define DUALMC_SCAN_LEVELS 3
+
+layout(std140, set = 0, binding = 0) uniform Parameters
+{
+    // voxels along each axis
+    ivec4 extent;
+    // cells whose faces are constructed, extent - 4 as for dualmc::Mesher
+    ivec4 cellCount;
+    // classified cells, which includes the neighbors of the manifold test
+    ivec4 codeCount;
+    float iso;
+    // 1 for the manifold variant of Rephael Wenger
+    uint manifold;
+    // 1 for quads, 0 for triangles as dualmc::Topology
+    uint quads;
+    uint codeCellCount;
+} params;
+
+// dualmc::tables::dualPointsList and problematicConfigs, see dualmc::gpu::Tables
+layout(std430, set = 0, binding = 1) readonly buffer Tables
+{
+    uint dualPointsList[1024];
+    uint problematicConfigs[256];
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer Volume
+{
+#if defined(DUALMC_VOXEL_UINT8) || defined(DUALMC_VOXEL_UINT16)
+    uint voxels[];
+#else
+    float voxels[];
+#endif
+};
+
+// cube codes of the classified cells
+layout(std430, set = 0, binding = 3) buffer CubeCodes
+{
+    uint cubeCodes[];
+};
+
+// 1 for classified cells holding surface, whose faces are constructed
+layout(std430, set = 0, binding = 4) buffer ActiveFlags
+{
+    uint activeFlags[];
+};
+
+// exclusive prefix sum of activeFlags, the index of an active cell
+layout(std430, set = 0, binding = 5) buffer ActiveOffsets
+{
+    uint activeOffsets[];
+};
+
+// classified cell index of each active cell
+layout(std430, set = 0, binding = 6) buffer ActiveCells
+{
+    uint activeCells[];
+};
+
+// slots of the dual points of each active cell, which are referenced by faces
+layout(std430, set = 0, binding = 7) buffer PointMasks
+{
+    uint pointMasks[];
+};
+
+// exclusive prefix sum of the dual point counts, the first vertex of each active cell
+layout(std430, set = 0, binding = 8) buffer PointOffsets
+{
+    uint pointOffsets[];
+};
+
+// number of indices of the faces of each active cell
+layout(std430, set = 0, binding = 9) buffer IndexCounts
+{
+    uint indexCounts[];
+};
+
+// exclusive prefix sum of indexCounts, the first index of each active cell
+layout(std430, set = 0, binding = 10) buffer IndexOffsets
+{
+    uint indexOffsets[];
+};
+
+layout(std430, set = 0, binding = 11) buffer Counters
+{
+    uint counters[];
+};
+
+// vertex positions, three floats per vertex
+layout(std430, set = 0, binding = 12) buffer Vertices
+{
+    float vertices[];
+};
+
+layout(std430, set = 0, binding = 13) buffer Indices
+{
+    uint indices[];
+};
+
+// axis in bits 0-1 and origin corner in bits 2-4 of the cell edges
+const uint edgeDefs[12] = uint[12](0u, 6u, 16u, 2u, 8u, 14u, 24u, 10u, 1u, 5u, 21u, 17u);
+
+// edges of the four cells around the x, y and z edge of a cell
+#define DUALMC_EDGE0 1u
+#define DUALMC_EDGE1 2u
+#define DUALMC_EDGE2 4u
+#define DUALMC_EDGE3 8u
+#define DUALMC_EDGE4 16u
+#define DUALMC_EDGE5 32u
+#define DUALMC_EDGE6 64u
+#define DUALMC_EDGE7 128u
+#define DUALMC_EDGE8 256u
+#define DUALMC_EDGE9 512u
+#define DUALMC_EDGE10 1024u
+#define DUALMC_EDGE11 2048u
+
+float GetVoxel(ivec3 voxel)
+{
+    uint i = uint(voxel.x) + uint(params.extent.x) * (uint(voxel.y) + uint(params.extent.y) * uint(voxel.z));
+#if defined(DUALMC_VOXEL_UINT8)
+    return float((voxels[i >> 2u] >> ((i & 3u) * 8u)) & 255u);
+#elif defined(DUALMC_VOXEL_UINT16)
+    return float((voxels[i >> 1u] >> ((i & 1u) * 16u)) & 65535u);
+#else
+    return voxels[i];
+#endif
+}
+
+uint GetCodeIndex(ivec3 cell)
+{
+    return uint(cell.x) + uint(params.codeCount.x) * (uint(cell.y) + uint(params.codeCount.y) * uint(cell.z));
+}
+
+ivec3 GetCodeCell(uint index)
+{
+    uint x = index % uint(params.codeCount.x);
+    uint y = (index / uint(params.codeCount.x)) % uint(params.codeCount.y);
+    uint z = index / (uint(params.codeCount.x) * uint(params.codeCount.y));
+    return ivec3(int(x), int(y), int(z));
+}
+
+// Cube code of a cell, whose bit i is set if corner i is inside the surface.
+// Corner i is the voxel at the offsets given by the bits of i.
+uint ComputeCubeCode(ivec3 cell)
+{
+    uint code = 0u;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        ivec3 voxel = cell + ivec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+        if (GetVoxel(voxel) >= params.iso)
+        {
+            code |= 1u << uint(corner);
+        }
+    }
+    return code;
+}
+
+// Cube code used for looking up the dual points of a cell. The manifold test
+// inverts C16 and C19 configurations sharing their ambiguous face with
+// another one, as dualmc::Mesher::ResolveCellCode.
+uint GetDualCode(ivec3 cell)
+{
+    uint cubeCode = cubeCodes[GetCodeIndex(cell)];
+    if (params.manifold == 0u)
+    {
+        return cubeCode;
+    }
+
+    uint direction = problematicConfigs[cubeCode];
+    if (direction != 255u)
+    {
+        ivec3 neighbor = cell;
+        int component = int(direction >> 1u);
+        int delta = (direction & 1u) == 1u ? 1 : -1;
+        neighbor[component] += delta;
+        if (neighbor[component] >= 0 && neighbor[component] < params.extent[component] - 1)
+        {
+            if (problematicConfigs[cubeCodes[GetCodeIndex(neighbor)]] != 255u)
+            {
+                cubeCode ^= 255u;
+            }
+        }
+    }
+    return cubeCode;
+}
+
+// Slot of the dual point of a cube code, which belongs to the given edge.
+uint GetDualPointSlot(uint dualCode, uint edge)
+{
+    for (uint slot = 0u; slot < 4u; ++slot)
+    {
+        if ((dualPointsList[dualCode * 4u + slot] & edge) != 0u)
+        {
+            return slot;
+        }
+    }
+    return 0u;
+}
+
+// Check if a cell constructs the face dual to its edge from corner 0 along the
+// given axis. The faces on the lower border are skipped as by the mesher.
+bool HasFace(ivec3 cell, uint cubeCode, uint axis)
+{
+    const uint cornerBits[3] = uint[3](2u, 4u, 16u);
+    ivec3 lower = ivec3(axis != 0u, axis != 1u, axis != 2u);
+    bool border = any(lessThan(cell, lower));
+    return !border && ((cubeCode & 1u) != 0u) != ((cubeCode & cornerBits[axis]) != 0u);
+}
+
+// Cells and edges of the face dual to the edge along the given axis, which
+// is constructed by the first cell. The corner order matches the mesher.
+void GetFace(ivec3 cell, uint axis, out ivec3 cells[4], out uint edges[4])
+{
+    if (axis == 0u)
+    {
+        cells = ivec3[4](cell, cell - ivec3(0, 0, 1), cell - ivec3(0, 1, 1), cell - ivec3(0, 1, 0));
+        edges = uint[4](DUALMC_EDGE0, DUALMC_EDGE2, DUALMC_EDGE6, DUALMC_EDGE4);
+    }
+    else if (axis == 1u)
+    {
+        cells = ivec3[4](cell, cell - ivec3(0, 0, 1), cell - ivec3(1, 0, 1), cell - ivec3(1, 0, 0));
+        edges = uint[4](DUALMC_EDGE8, DUALMC_EDGE11, DUALMC_EDGE10, DUALMC_EDGE9);
+    }
+    else
+    {
+        cells = ivec3[4](cell, cell - ivec3(1, 0, 0), cell - ivec3(1, 1, 0), cell - ivec3(0, 1, 0));
+        edges = uint[4](DUALMC_EDGE3, DUALMC_EDGE1, DUALMC_EDGE5, DUALMC_EDGE7);
+    }
+}
+
+// The face along x keeps its corner order if corner 0 is inside, the faces
+// along y and z if corner 0 is outside.
+bool IsFaceFlipped(uint cubeCode, uint axis)
+{
+    bool inside = (cubeCode & 1u) != 0u;
+    return axis == 0u ? !inside : inside;
+}
+
+#endif // DUALMC_COMMON_GLSL
@@ -0,0 +1,62 @@
+// Copyright (C) 2017, Dominik Wodniok
+// This software may be modified and distributed under the terms
+// of the BSD 3-Clause license.
+// See the LICENSE.txt file for details.
+
+// Declarations of the prefix sum shaders. Three levels of 512 elements scan
+// up to 2^27 elements, e.g. the cells of a 509^3 volume.
+
+#ifndef DUALMC_SCAN_GLSL
+#define DUALMC_SCAN_GLSL
+
+#include "dualmc_common.glsl"
+
+// block sums of level 1 followed by those of level 2
+#define DUALMC_SCAN_LEVEL2_OFFSET 262144u
+
+layout(std430, set = 0, binding = 14) buffer ScanSums
+{
+    uint scanSums[];
+};
+
+layout(push_constant) uniform ScanConstants
+{
+    uint level;
+} scan;
+
+#if defined(DUALMC_SCAN_ACTIVE)
+#define DUALMC_SCAN_COUNT params.codeCellCount
+#define DUALMC_SCAN_TOTAL DUALMC_COUNTER_ACTIVE_CELLS
+#define ScanInput(i) activeFlags[i]
+#define ScanOutput(i) activeOffsets[i]
+#elif defined(DUALMC_SCAN_POINTS)
+#define DUALMC_SCAN_COUNT counters[DUALMC_COUNTER_ACTIVE_CELLS]
+#define DUALMC_SCAN_TOTAL DUALMC_COUNTER_VERTICES
+#define ScanInput(i) uint(bitCount(pointMasks[i]))
+#define ScanOutput(i) pointOffsets[i]
+#elif defined(DUALMC_SCAN_INDICES)
+#define DUALMC_SCAN_COUNT counters[DUALMC_COUNTER_ACTIVE_CELLS]
+#define DUALMC_SCAN_TOTAL DUALMC_COUNTER_INDICES
+#define ScanInput(i) indexCounts[i]
+#define ScanOutput(i) indexOffsets[i]
+#else
+#error "Define DUALMC_SCAN_ACTIVE, DUALMC_SCAN_POINTS or DUALMC_SCAN_INDICES"
+#endif
+
+uint GetScanLevelOffset(uint level)
+{
+    return level == 2u ? DUALMC_SCAN_LEVEL2_OFFSET : 0u;
+}
+
+// Number of elements of a level, which are the block sums of the level below.
+uint GetScanCount(uint level)
+{
+    uint count = DUALMC_SCAN_COUNT;
+    for (uint i = 0u; i < level; ++i)
+    {
+        count = (count + DUALMC_SCAN_BLOCK_SIZE - 1u) / DUALMC_SCAN_BLOCK_SIZE;
+    }
+    return count;
+}
+
+#endif // DUALMC_SCAN_GLSL